@@ -19,9 +19,24 @@
 /// the location of variables assigned in the control volume. 
 /// Velocities at X, Y and Z directions are locatted
 /// on the surface of the control volume. They are computed using 
-/// subroutines: \c trace_vx(), \c trace_vy() and \c trace_vz().
+/// subroutines: \c trace_vx(), \c trace_vy() and \c trace_vz(). The
+/// velocity step interleaves the lines of the three components in a single
+/// parallel sweep through \c advect_velocity() and \c trace_velocity().
 /// Scalar variables are in the center of control volume and they are computed
-/// using \c trace_scalar().
+/// using \c trace_scalar(). Their departure points are traced once after the
+/// velocity has changed and kept in a cache, which is shared by the 
+/// temperature and all the trace substances. The cache is interpolated in
+/// batches by \c interpolation_batch().
+///
+/// The cell of the departure point is found by a binary search over the 1D
+/// coordinates if there is no boundary cell between the departure point and 
+/// the current cell. Only the other cells are traced back cell by cell, so 
+/// that the cost does not grow with the Courant number.
+///
+/// The departure point of each cell only depends on the variables at the
+/// previous time step. The cells are thus traced by several threads in
+/// parallel if the code is compiled with OpenMP. The planes are distributed
+/// dynamically since the cells near the boundaries take longer.
 ///
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -46,6 +61,21 @@
 int advect(PARA_DATA *para, REAL **var, int var_type, int index, 
            REAL *d, REAL *d0, int **BINDEX) {
   int flag;
+
+  // The distances to the boundary cells are computed at the first call
+  if(para->solv->trace==NULL) {
+    if(allocate_trace_data(para, var)!=0) {
+      ffd_log("advect(): Could not allocate memory for the departure point "
+              "search.", FFD_ERROR);
+      return 1;
+    }
+  }
+
+  // The velocity changes, so that the departure points of the scalar 
+  // variables have to be traced again
+  if(var_type==VX || var_type==VY || var_type==VZ)
+    para->solv->trace->departure = 0;
+
   switch (var_type) {
     case VX:
       flag = trace_vx(para, var, var_type, d, d0, BINDEX);
@@ -85,6 +115,79 @@ int advect(PARA_DATA *para, REAL **var, int var_type, int index,
   return flag;
 } // End of advect( )
 
+///////////////////////////////////////////////////////////////////////////////
+/// Entrance of advection step for the three velocity components
+///
+/// The lines of the velocities in X, Y and Z direction are interleaved in
+/// one parallel sweep by \c trace_velocity().
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param du Pointer to the computed X-velocity for current time step
+///\param dv Pointer to the computed Y-velocity for current time step
+///\param dw Pointer to the computed Z-velocity for current time step
+///\param BINDEX Pointer to boundary index
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int advect_velocity(PARA_DATA *para, REAL **var, REAL *du, REAL *dv, 
+                    REAL *dw, int **BINDEX) {
+  int flag;
+
+  // The distances to the boundary cells are computed at the first call
+  if(para->solv->trace==NULL) {
+    if(allocate_trace_data(para, var)!=0) {
+      ffd_log("advect_velocity(): Could not allocate memory for the "
+              "departure point search.", FFD_ERROR);
+      return 1;
+    }
+  }
+
+  // The velocity changes, so that the departure points of the scalar 
+  // variables have to be traced again
+  para->solv->trace->departure = 0;
+
+  flag = trace_velocity(para, var, du, dv, dw, BINDEX);
+  if(flag!=0)
+    ffd_log("advect_velocity(): Failed in advection for velocity.",
+            FFD_ERROR);
+
+  return flag;
+} // End of advect_velocity( )
+
+///////////////////////////////////////////////////////////////////////////////
+/// Entrance of advection step for several trace substances
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param nb Number of trace substances
+///\param d d[nb]: Pointers to the computed variables at previous time step
+///\param d0 d0[nb]: Pointers to the computed variables for current time step
+///\param BINDEX Pointer to boundary index
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int advect_species(PARA_DATA *para, REAL **var, int nb, REAL **d, REAL **d0,
+                   int **BINDEX) {
+  int flag;
+
+  // The distances to the boundary cells are computed at the first call
+  if(para->solv->trace==NULL) {
+    if(allocate_trace_data(para, var)!=0) {
+      ffd_log("advect_species(): Could not allocate memory for the "
+              "departure point search.", FFD_ERROR);
+      return 1;
+    }
+  }
+
+  flag = trace_species(para, var, nb, d, d0, BINDEX);
+  if(flag!=0)
+    ffd_log("advect_species(): Failed in advection for trace substances.",
+            FFD_ERROR);
+
+  return flag;
+} // End of advect_species( )
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Advection for velocity at X-direction
 ///
@@ -99,42 +202,78 @@ int advect(PARA_DATA *para, REAL **var, int var_type, int index,
 ///////////////////////////////////////////////////////////////////////////////
 int trace_vx(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0,
              int **BINDEX) {
-  int i, j, k;
-  int it;
+  int j, k, flag = 0;
+  int jmax = para->geom->jmax, kmax = para->geom->kmax;
+
+#pragma omp parallel for private(j) reduction(|:flag) schedule(dynamic)
+  for(k=1; k<=kmax; k++)
+    for(j=1; j<=jmax; j++)
+      flag |= trace_vx_line(para, var, d, d0, j, k);
+
+  if(flag!=0) return 1;
+
+  /*---------------------------------------------------------------------------
+  | define the b.c.
+  ---------------------------------------------------------------------------*/
+  set_bnd(para, var, var_type, 0, d, BINDEX);
+  return 0;
+} // End of trace_vx()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Advection for one line of velocity at X-direction
+///
+/// The departure points of the cells (i,j,k) along the line are traced back
+/// and the velocity is interpolated there.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param d Pointer to the computed variables at previous time step
+///\param d0 Pointer to the computed variables for current time step
+///\param j J-index of the line
+///\param k K-index of the line
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int trace_vx_line(PARA_DATA *para, REAL **var, REAL *d, REAL *d0,
+                  int j, int k) {
+  int i, it, flag = 0;
   int itmax = 20000; // Max number of iterations for backward tracing 
   int imax = para->geom->imax, jmax = para->geom->jmax;
-  int kmax = para->geom->kmax;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
   REAL x_1, y_1, z_1;
   REAL dt = para->mytime->dt; 
   REAL u0, v0, w0;
-  REAL *x = var[X], *y = var[Y],  *z = var[Z]; 
+  REAL *y = var[Y], *z = var[Z];
   REAL *gx = var[GX]; 
   REAL *u = var[VX], *v = var[VY], *w = var[VZ];
   REAL *flagu = var[FLAGU];
+  METRIC_DATA *metric = para->geom->metric;
+  TRACE_DATA *trace = para->solv->trace;
   int  COOD[3], LOC[3];
   REAL OL[3];
   int  OC[3];
 
-  FOR_U_CELL
+  for(i=1; i<=imax-1; i++) {
+    // Do not trace for boundary cells
     if(flagu[IX(i,j,k)]>=0) continue;
+
     /*-----------------------------------------------------------------------
     | Step 1: Tracing Back
     -----------------------------------------------------------------------*/
     // Get velocities at the location of VX
     u0 = u[IX(i,j,k)];
     v0 = (REAL) 0.5 
-        * ((v[IX(i,  j,k)]+v[IX(i,  j-1,k)])*( x[IX(i+1,j,k)]-gx[IX(i,j,k)])
-          +(v[IX(i+1,j,k)]+v[IX(i+1,j-1,k)])*(gx[IX(i,  j,k)]- x[IX(i,j,k)])) 
-        / (x[IX(i+1,j,k)]-x[IX(i,j,k)]);
+        * ((v[IX(i,  j,k)]+v[IX(i,  j-1,k)])*(metric->x[i+1]-metric->gx[i])
+          +(v[IX(i+1,j,k)]+v[IX(i+1,j-1,k)])*(metric->gx[i]-metric->x[i])) 
+        / (metric->x[i+1]-metric->x[i]);
     w0 = (REAL) 0.5 
-        * ((w[IX(i,  j,k)]+w[IX(i  ,j, k-1)])*( x[IX(i+1,j,k)]-gx[IX(i,j,k)])
-          +(w[IX(i+1,j,k)]+w[IX(i+1,j, k-1)])*(gx[IX(i,  j,k)]- x[IX(i,j,k)]))
-        / (x[IX(i+1,j,k)]-x[IX(i,j,k)]); 
+        * ((w[IX(i,  j,k)]+w[IX(i  ,j, k-1)])*(metric->x[i+1]-metric->gx[i])
+          +(w[IX(i+1,j,k)]+w[IX(i+1,j, k-1)])*(metric->gx[i]-metric->x[i]))
+        / (metric->x[i+1]-metric->x[i]); 
     // Find the location at previous time step
-    OL[X] =gx[IX(i,j,k)] - u0*dt;
-    OL[Y] = y[IX(i,j,k)] - v0*dt;
-    OL[Z] = z[IX(i,j,k)] - w0*dt;
+    OL[X] = metric->gx[i] - u0*dt;
+    OL[Y] = metric->y[j] - v0*dt;
+    OL[Z] = metric->z[k] - w0*dt;
     // Initialize the coordinates of previous step 
     OC[X] = i; 
     OC[Y] = j; 
@@ -149,6 +288,13 @@ int trace_vx(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0,
     LOC[X] = 1; 
     LOC[Y] = 1; 
     LOC[Z] = 1;
+    // Find the coordinates directly if no boundary cell is on the way
+    if(locate_departure(para, trace->distu, metric->gx, metric->y, metric->z,
+                        i, j, k, OL, OC)==0) {
+      COOD[X] = 0;
+      COOD[Y] = 0;
+      COOD[Z] = 0;
+    }
     //Initialize the number of iterations
     it=1;
 
@@ -168,12 +314,14 @@ int trace_vx(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0,
 
       if(it>itmax)
       {
-        printf("Error: advection.c, can not track the location for VX(%d, %d,%d)",
-                i, j, k);
-        printf("after %d iterations.\n", it);
-        return 1;
+        sprintf(msg, "trace_vx_line(): Could not track the location for "
+          "VX at cell(%d, %d,%d) after %d iterations", i, j, k, it);
+        ffd_log(msg, FFD_ERROR);
+        flag = 1;
+        break;
       }
     } // End of while() for backward tracing
+    if(it>itmax) continue;
 
     // Set the coordinates of previous location if it is as boundary
     if(u0>0 && LOC[X]==0) OC[X] -=1;
@@ -189,57 +337,85 @@ int trace_vx(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0,
     /*-------------------------------------------------------------------------
     | Interpolate
     -------------------------------------------------------------------------*/
-    x_1 = (OL[X]-gx[IX(OC[X],OC[Y],OC[Z])]) 
-        / (gx[IX(OC[X]+1,OC[Y],OC[Z])]-gx[IX(OC[X],OC[Y],OC[Z])]); 
-    y_1 = (OL[Y]-y[IX(OC[X],OC[Y],OC[Z])])
-        / (y[IX(OC[X],OC[Y]+1,OC[Z])]-y[IX(OC[X],OC[Y],OC[Z])]);
-    z_1 = (OL[Z]-z[IX(OC[X],OC[Y],OC[Z])]) 
-        / (z[IX(OC[X],OC[Y],OC[Z]+1)]-z[IX(OC[X],OC[Y],OC[Z])]);
+    x_1 = (OL[X]-metric->gx[OC[X]]) 
+        / (metric->gx[OC[X]+1]-metric->gx[OC[X]]); 
+    y_1 = (OL[Y]-metric->y[OC[Y]])
+        / (metric->y[OC[Y]+1]-metric->y[OC[Y]]);
+    z_1 = (OL[Z]-metric->z[OC[Z]]) 
+        / (metric->z[OC[Z]+1]-metric->z[OC[Z]]);
 
     d[IX(i,j,k)] = interpolation(para, d0, x_1, y_1, z_1, OC[X], OC[Y], OC[Z]);
+  } // End of for() loop for the cells in the line
+
+  return flag;
+} // End of trace_vx_line()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Advection for velocity at Y-direction
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param var_type The type of variable for advection solver
+///\param d Pointer to the computed variables at previous time step
+///\param d0 Pointer to the computed variables for current time step
+///\param BINDEX Pointer to boundary index
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int trace_vy(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0,
+             int **BINDEX) {
+  int j, k, flag = 0;
+  int jmax = para->geom->jmax, kmax = para->geom->kmax;
 
-  END_FOR // End of loop for all cells
+#pragma omp parallel for private(j) reduction(|:flag) schedule(dynamic)
+  for(k=1; k<=kmax; k++)
+    for(j=1; j<=jmax-1; j++)
+      flag |= trace_vy_line(para, var, d, d0, j, k);
+
+  if(flag!=0) return 1;
 
   /*---------------------------------------------------------------------------
   | define the b.c.
   ---------------------------------------------------------------------------*/
   set_bnd(para, var, var_type, 0, d, BINDEX);
-
   return 0;
-} // End of trace_vx()
+} // End of trace_vy()
 
 ///////////////////////////////////////////////////////////////////////////////
-/// Advection for velocity at Y-direction
+/// Advection for one line of velocity at Y-direction
+///
+/// The departure points of the cells (i,j,k) along the line are traced back
+/// and the velocity is interpolated there.
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
-///\param var_type The type of variable for advection solver
 ///\param d Pointer to the computed variables at previous time step
 ///\param d0 Pointer to the computed variables for current time step
-///\param BINDEX Pointer to boundary index
+///\param j J-index of the line
+///\param k K-index of the line
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int trace_vy(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0, 
-             int **BINDEX) {
-  int i, j, k;
-  int it;
+int trace_vy_line(PARA_DATA *para, REAL **var, REAL *d, REAL *d0,
+                  int j, int k) {
+  int i, it, flag = 0;
   int itmax = 20000; // Max number of iterations for backward tracing 
   int imax = para->geom->imax, jmax = para->geom->jmax;
-  int kmax = para->geom->kmax;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
   REAL x_1, y_1, z_1;
   REAL dt = para->mytime->dt; 
   REAL u0, v0, w0;
-  REAL *x = var[X], *y = var[Y],  *z = var[Z]; 
+  REAL *x = var[X], *z = var[Z];
   REAL *gy = var[GY]; 
   REAL *u = var[VX], *v = var[VY], *w = var[VZ];
   REAL *flagv = var[FLAGV];
+  METRIC_DATA *metric = para->geom->metric;
+  TRACE_DATA *trace = para->solv->trace;
   int  COOD[3], LOC[3];
   REAL OL[3];
   int  OC[3];
 
-  FOR_V_CELL
+  for(i=1; i<=imax; i++) {
     // Do not trace for boundary cells
     if(flagv[IX(i,j,k)]>=0) continue;
 
@@ -248,18 +424,18 @@ int trace_vy(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0,
     -------------------------------------------------------------------------*/
     // Get velocities at the location of VY
     u0 = (REAL) 0.5
-       * ((u[IX(i,j,k)]+u[IX(i-1,j,  k)])*(y [IX(i,j+1,k)]-gy[IX(i,j,k)])
-         +(u[IX(i,j+1,k)]+u[IX(i-1,j+1,k)])*(gy[IX(i,j,  k)]-y[IX(i,j,k)]))
-       / (y[IX(i,j+1,k)]-y[IX(i,j,k)]);
+       * ((u[IX(i,j,k)]+u[IX(i-1,j,  k)])*(metric->y[j+1]-metric->gy[j])
+         +(u[IX(i,j+1,k)]+u[IX(i-1,j+1,k)])*(metric->gy[j]-metric->y[j]))
+       / (metric->y[j+1]-metric->y[j]);
     v0 = v[IX(i,j,k)]; 
     w0 = (REAL) 0.5
-       * ((w[IX(i,j,k)]+w[IX(i,j,k-1)])*(y[IX(i,j+1,k)]-gy[IX(i,j,k)])
-         +(w[IX(i,j+1,k)]+w[IX(i,j+1,k-1)])*(gy[IX(i,j,k)]-y[IX(i,j,k)]))
-       / (y[IX(i,j+1,k)]-y[IX(i,j,k)]); 
+       * ((w[IX(i,j,k)]+w[IX(i,j,k-1)])*(metric->y[j+1]-metric->gy[j])
+         +(w[IX(i,j+1,k)]+w[IX(i,j+1,k-1)])*(metric->gy[j]-metric->y[j]))
+       / (metric->y[j+1]-metric->y[j]); 
     // Find the location at previous time step
-    OL[X] = x[IX(i,j,k)] - u0*dt; 
-    OL[Y] = gy[IX(i,j,k)] - v0*dt;
-    OL[Z] = z[IX(i,j,k)] - w0*dt;
+    OL[X] = metric->x[i] - u0*dt; 
+    OL[Y] = metric->gy[j] - v0*dt;
+    OL[Z] = metric->z[k] - w0*dt;
     // Initialize the coordinates of previous step
     OC[X] = i;
     OC[Y] = j;
@@ -274,6 +450,13 @@ int trace_vy(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0,
     LOC[X] = 1; 
     LOC[Y] = 1; 
     LOC[Z] = 1;
+    // Find the coordinates directly if no boundary cell is on the way
+    if(locate_departure(para, trace->distv, metric->x, metric->gy, metric->z,
+                        i, j, k, OL, OC)==0) {
+      COOD[X] = 0;
+      COOD[Y] = 0;
+      COOD[Z] = 0;
+    }
     //Initialize the number of iterations
     it=1;
 
@@ -289,12 +472,14 @@ int trace_vy(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0,
           set_z_location(para, var, flagv, z, w0, i, j, k, OL, OC, LOC, COOD); 
 
       if(it>itmax) {
-        printf("Error: advection.c can not track the location for VY(%d, %d,%d)",
-                i, j, k);
-        printf("after %d iterations.\n", it);
-        return 1;
+        sprintf(msg, "trace_vy_line(): Could not track the location for "
+          "VY at cell(%d, %d,%d) after %d iterations", i, j, k, it);
+        ffd_log(msg, FFD_ERROR);
+        flag = 1;
+        break;
       }
     } // End of while() loop
+    if(it>itmax) continue;
 
     // Set the coordinates of previous location if it is as boundary
     if(u0>=0 && LOC[X] == 0) OC[X] -=1; 
@@ -306,58 +491,88 @@ int trace_vy(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0,
     if(u0<0 && LOC[X]==1) OC[X] -=1;
     if(v0<0 && LOC[Y]==1) OC[Y] -=1;
     if(w0<0 && LOC[Z]==1) OC[Z] -=1;
-            
+          
     /*-------------------------------------------------------------------------
     | Interpolating for all variables
     -------------------------------------------------------------------------*/
-    x_1 = (OL[X]-x[IX(OC[X],OC[Y],OC[Z])])
-        / (x[IX(OC[X]+1,OC[Y],OC[Z])]-x[IX(OC[X],OC[Y],OC[Z])]); 
-    y_1 = (OL[Y]-gy[IX(OC[X],OC[Y],OC[Z])])
-        / (gy[IX(OC[X],OC[Y]+1,OC[Z])]-gy[IX(OC[X],OC[Y],OC[Z])]);
-    z_1 = (OL[Z]-z[IX(OC[X],OC[Y],OC[Z])])
-        / (z[IX(OC[X],OC[Y],OC[Z]+1)]-z[IX(OC[X],OC[Y],OC[Z])]);
+    x_1 = (OL[X]-metric->x[OC[X]])
+        / (metric->x[OC[X]+1]-metric->x[OC[X]]); 
+    y_1 = (OL[Y]-metric->gy[OC[Y]])
+        / (metric->gy[OC[Y]+1]-metric->gy[OC[Y]]);
+    z_1 = (OL[Z]-metric->z[OC[Z]])
+        / (metric->z[OC[Z]+1]-metric->z[OC[Z]]);
     d[IX(i,j,k)] = interpolation(para, d0, x_1, y_1, z_1, OC[X],OC[Y],OC[Z]);
-  END_FOR // End of For() loop for each cell
+  } // End of for() loop for the cells in the line
+
+  return flag;
+} // End of trace_vy_line()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Advection for velocity at Z-direction
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param var_type The type of variable for advection solver
+///\param d Pointer to the computed variables at previous time step
+///\param d0 Pointer to the computed variables for current time step
+///\param BINDEX Pointer to boundary index
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int trace_vz(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0,
+             int **BINDEX) {
+  int j, k, flag = 0;
+  int jmax = para->geom->jmax, kmax = para->geom->kmax;
+
+#pragma omp parallel for private(j) reduction(|:flag) schedule(dynamic)
+  for(k=1; k<=kmax-1; k++)
+    for(j=1; j<=jmax; j++)
+      flag |= trace_vz_line(para, var, d, d0, j, k);
+
+  if(flag!=0) return 1;
 
   /*---------------------------------------------------------------------------
   | define the b.c.
   ---------------------------------------------------------------------------*/
   set_bnd(para, var, var_type, 0, d, BINDEX);
   return 0;
-} // End of trace_vy()
+} // End of trace_vz()
 
 ///////////////////////////////////////////////////////////////////////////////
-/// Advection for velocity at Z-direction
+/// Advection for one line of velocity at Z-direction
+///
+/// The departure points of the cells (i,j,k) along the line are traced back
+/// and the velocity is interpolated there.
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
-///\param var_type The type of variable for advection solver
 ///\param d Pointer to the computed variables at previous time step
 ///\param d0 Pointer to the computed variables for current time step
-///\param BINDEX Pointer to boundary index
+///\param j J-index of the line
+///\param k K-index of the line
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int trace_vz(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0, 
-             int **BINDEX) {
-  int i, j, k;
-  int it;
+int trace_vz_line(PARA_DATA *para, REAL **var, REAL *d, REAL *d0,
+                  int j, int k) {
+  int i, it, flag = 0;
   int itmax = 20000; // Max number of iterations for backward tracing 
   int imax = para->geom->imax, jmax = para->geom->jmax;
-  int kmax = para->geom->kmax;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
   REAL x_1, y_1, z_1;
   REAL dt = para->mytime->dt; 
   REAL u0, v0, w0;
-  REAL *x = var[X], *y = var[Y],  *z = var[Z]; 
+  REAL *x = var[X], *y = var[Y];
   REAL *gz = var[GZ]; 
   REAL *u = var[VX], *v = var[VY], *w = var[VZ];
   REAL *flagw = var[FLAGW];
+  METRIC_DATA *metric = para->geom->metric;
+  TRACE_DATA *trace = para->solv->trace;
   int  COOD[3], LOC[3];
   REAL OL[3];
   int  OC[3];
 
-  FOR_W_CELL
+  for(i=1; i<=imax; i++) {
     // Do not trace for boundary cells
     if(flagw[IX(i,j,k)]>=0) continue;
 
@@ -366,18 +581,18 @@ int trace_vz(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0,
     -------------------------------------------------------------------------*/
     // Get velocities at the location of VZ
     u0 = (REAL) 0.5 
-       * ((u[IX(i,j,k  )]+u[IX(i-1,j,k  )])*(z [IX(i,j,k+1)]-gz[IX(i,j,k)])
-         +(u[IX(i,j,k+1)]+u[IX(i-1,j,k+1)])*(gz[IX(i,j,k  )]- z[IX(i,j,k)]))
-       /  (z[IX(i,j,k+1)]-z[IX(i,j,k)]);
+       * ((u[IX(i,j,k  )]+u[IX(i-1,j,k  )])*(metric->z[k+1]-metric->gz[k])
+         +(u[IX(i,j,k+1)]+u[IX(i-1,j,k+1)])*(metric->gz[k]-metric->z[k]))
+       /  (metric->z[k+1]-metric->z[k]);
     v0 = (REAL) 0.5
-       * ((v[IX(i,j,k  )]+v[IX(i,j-1,k  )])*(z [IX(i,j,k+1)]-gz[IX(i,j,k)])
-       +(v[IX(i,j,k+1)]+v[IX(i,j-1,k+1)])*(gz[IX(i,j,k  )]-z [IX(i,j,k)]))
-       /  (z[IX(i,j,k+1)]-z[IX(i,j,k)]); 
+       * ((v[IX(i,j,k  )]+v[IX(i,j-1,k  )])*(metric->z[k+1]-metric->gz[k])
+       +(v[IX(i,j,k+1)]+v[IX(i,j-1,k+1)])*(metric->gz[k]-metric->z[k]))
+       /  (metric->z[k+1]-metric->z[k]); 
     w0 = w[IX(i,j,k)]; 
     // Find the location at previous time step
-    OL[X] = x[IX(i,j,k)] - u0*dt; 
-    OL[Y] = y[IX(i,j,k)] - v0*dt;
-    OL[Z] = gz[IX(i,j,k)] - w0*dt;
+    OL[X] = metric->x[i] - u0*dt; 
+    OL[Y] = metric->y[j] - v0*dt;
+    OL[Z] = metric->gz[k] - w0*dt;
     // Initialize the coordinates of previous step
     OC[X] = i;
     OC[Y] = j;
@@ -392,6 +607,13 @@ int trace_vz(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0,
     LOC[X] = 1;
     LOC[Y] = 1;
     LOC[Z] = 1;
+    // Find the coordinates directly if no boundary cell is on the way
+    if(locate_departure(para, trace->distw, metric->x, metric->y, metric->gz,
+                        i, j, k, OL, OC)==0) {
+      COOD[X] = 0;
+      COOD[Y] = 0;
+      COOD[Z] = 0;
+    }
     //Initialize the number of iterations
     it=1;
 
@@ -406,12 +628,14 @@ int trace_vz(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0,
         set_z_location(para, var, flagw, gz, w0, i, j, k, OL, OC, LOC, COOD); 
 
       if(it>itmax) {
-        printf("Error: advection.c can not track the location for VY(%d, %d,%d)",
-                i, j, k);
-        printf("after %d iterations.\n", it);
-        return 1;
+        sprintf(msg, "trace_vz_line(): Could not track the location for "
+          "VZ at cell(%d, %d,%d) after %d iterations", i, j, k, it);
+        ffd_log(msg, FFD_ERROR);
+        flag = 1;
+        break;
       }
     } // End of while() loop
+    if(it>itmax) continue;
 
     // Set the coordinates of previous location if it is as boundary
     if(u0>=0 && LOC[X] == 0) OC[X] -=1;
@@ -426,25 +650,70 @@ int trace_vz(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0,
     /*-------------------------------------------------------------------------
     | Interpolating for all variables
     -------------------------------------------------------------------------*/
-    x_1 = (OL[X]- x[IX(OC[X],OC[Y],OC[Z])])
-        / ( x[IX(OC[X]+1,OC[Y],   OC[Z]  )]- x[IX(OC[X],OC[Y],OC[Z])]); 
-    y_1 = (OL[Y]- y[IX(OC[X],OC[Y],OC[Z])])
-        / ( y[IX(OC[X],  OC[Y]+1, OC[Z]  )]- y[IX(OC[X],OC[Y],OC[Z])]);
-    z_1 = (OL[Z]-gz[IX(OC[X],OC[Y],OC[Z])])
-        / (gz[IX(OC[X],  OC[Y],   OC[Z]+1)]-gz[IX(OC[X],OC[Y],OC[Z])]);
-     d[IX(i,j,k)] = interpolation(para, d0, x_1, y_1, z_1, OC[X], OC[Y], OC[Z]);
-  END_FOR
+    x_1 = (OL[X]-metric->x[OC[X]])
+        / (metric->x[OC[X]+1]-metric->x[OC[X]]); 
+    y_1 = (OL[Y]-metric->y[OC[Y]])
+        / (metric->y[OC[Y]+1]-metric->y[OC[Y]]);
+    z_1 = (OL[Z]-metric->gz[OC[Z]])
+        / (metric->gz[OC[Z]+1]-metric->gz[OC[Z]]);
+    d[IX(i,j,k)] = interpolation(para, d0, x_1, y_1, z_1, OC[X], OC[Y], OC[Z]);
+  } // End of for() loop for the cells in the line
+
+  return flag;
+} // End of trace_vz_line()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Advection for the velocities in X, Y and Z direction
+///
+/// The lines of the three components at the same j and k are traced one
+/// after the other in the same sweep, so that the velocity rows around the
+/// line are mostly still in cache for the second and third component. This
+/// is only an interleaving: each component lies on its own cell face, so
+/// the face velocities, the departure point and the interpolation are
+/// computed separately by \c trace_vx_line(), \c trace_vy_line() and
+/// \c trace_vz_line(). The results are the same as with \c trace_vx(),
+/// \c trace_vy() and \c trace_vz().
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param du Pointer to the computed X-velocity for current time step
+///\param dv Pointer to the computed Y-velocity for current time step
+///\param dw Pointer to the computed Z-velocity for current time step
+///\param BINDEX Pointer to boundary index
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int trace_velocity(PARA_DATA *para, REAL **var, REAL *du, REAL *dv, 
+                   REAL *dw, int **BINDEX) {
+  int j, k, flag = 0;
+  int jmax = para->geom->jmax, kmax = para->geom->kmax;
+  REAL *u = var[VX], *v = var[VY], *w = var[VZ];
+
+#pragma omp parallel for private(j) reduction(|:flag) schedule(dynamic)
+  for(k=1; k<=kmax; k++)
+    for(j=1; j<=jmax; j++) {
+      flag |= trace_vx_line(para, var, du, u, j, k);
+      if(j<jmax) flag |= trace_vy_line(para, var, dv, v, j, k);
+      if(k<kmax) flag |= trace_vz_line(para, var, dw, w, j, k);
+    }
+
+  if(flag!=0) return 1;
 
   /*---------------------------------------------------------------------------
   | define the b.c.
   ---------------------------------------------------------------------------*/
-  set_bnd(para, var, var_type, 0, d, BINDEX);
+  set_bnd(para, var, VX, 0, du, BINDEX);
+  set_bnd(para, var, VY, 0, dv, BINDEX);
+  set_bnd(para, var, VZ, 0, dw, BINDEX);
   return 0;
-} // End of trace_vz()
+} // End of trace_velocity()
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Advection for scalar variables located in the center of control volume
 ///
+/// The departure points are taken from the cache, which is computed at the 
+/// first advection of a scalar variable after the velocity has changed.
+///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
 ///\param var_type The type of variable for advection solver
@@ -457,25 +726,99 @@ int trace_vz(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0,
 ///////////////////////////////////////////////////////////////////////////////
 int trace_scalar(PARA_DATA *para, REAL **var, int var_type, int index,
                  REAL *d, REAL *d0, int **BINDEX) {
-  int i, j, k;
-  int it;
+
+  if(para->solv->trace->departure==0) {
+    if(trace_departure(para, var)!=0) {
+      sprintf(msg, "trace_scalar(): Could not trace the departure points "
+              "for scalar variable %d.", var_type);
+      ffd_log(msg, FFD_ERROR);
+      return 1;
+    }
+  }
+
+  interpolate_departure(para, var, 1, &d, &d0);
+
+  /*---------------------------------------------------------------------------
+  | Define the b.c.
+  ---------------------------------------------------------------------------*/
+  set_bnd(para, var, var_type, index, d, BINDEX);
+  return 0;
+} // End of trace_scalar()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Advection for several trace substances
+///
+/// All the trace substances are interpolated at the departure points of the
+/// cache in one pass. The results are the same as the ones of 
+/// \c trace_scalar() called for each substance.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param nb Number of trace substances
+///\param d d[nb]: Pointers to the computed variables at previous time step
+///\param d0 d0[nb]: Pointers to the computed variables for current time step
+///\param BINDEX Pointer to boundary index
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int trace_species(PARA_DATA *para, REAL **var, int nb, REAL **d, REAL **d0,
+                  int **BINDEX) {
+  int n;
+
+  if(para->solv->trace->departure==0) {
+    if(trace_departure(para, var)!=0) {
+      ffd_log("trace_species(): Could not trace the departure points.",
+              FFD_ERROR);
+      return 1;
+    }
+  }
+
+  interpolate_departure(para, var, nb, d, d0);
+
+  /*---------------------------------------------------------------------------
+  | Define the b.c.
+  ---------------------------------------------------------------------------*/
+  for(n=0; n<nb; n++)
+    set_bnd(para, var, TRACE, n, d[n], BINDEX);
+  return 0;
+} // End of trace_species()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Trace back the departure points of the scalar variables
+///
+/// The departure points only depend on the velocity, so that they are shared
+/// by the temperature and all the trace substances of one time step. For 
+/// each cell of the cache, the index of the cell of the departure point and
+/// the relative location of the departure point in that cell are stored.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int trace_departure(PARA_DATA *para, REAL **var) {
+  int i, j, k, n;
+  int it, flag = 0;
   int itmax = 20000; // Max number of iterations for backward tracing 
   int imax = para->geom->imax, jmax = para->geom->jmax;
-  int kmax = para->geom->kmax;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
-  REAL x_1, y_1, z_1;
   REAL dt = para->mytime->dt;
   REAL u0, v0, w0;
   REAL *x = var[X], *y = var[Y], *z = var[Z]; 
   REAL *u = var[VX], *v = var[VY], *w = var[VZ];
   REAL *flagp = var[FLAGP];
+  METRIC_DATA *metric = para->geom->metric;
+  TRACE_DATA *trace = para->solv->trace;
   int  COOD[3], LOC[3];
   REAL OL[3];
   int  OC[3];
 
-  FOR_EACH_CELL
-    // Do not trace for boundary cells
-    if(flagp[IX(i,j,k)]>=0) continue;
+#pragma omp parallel for private(i, j, k, it, u0, v0, w0, COOD, LOC, OL, \
+                                 OC) reduction(|:flag) schedule(dynamic, 256)
+  for(n=0; n<trace->nb_cell; n++) {
+    i = trace->cell[n] % IMAX;
+    j = trace->cell[n] / IMAX % (jmax+2);
+    k = trace->cell[n] / IJMAX;
 
     /*-------------------------------------------------------------------------
     | Step 1: Tracing Back
@@ -485,9 +828,9 @@ int trace_scalar(PARA_DATA *para, REAL **var, int var_type, int index,
     v0 = (REAL) 0.5 * (v[IX(i,j,k)]+v[IX(i,j-1,k  )]);
     w0 = (REAL) 0.5 * (w[IX(i,j,k)]+w[IX(i,j  ,k-1)]);
     // Find the location at previous time step
-    OL[X] = x[IX(i,j,k)] - u0*dt; 
-    OL[Y] = y[IX(i,j,k)] - v0*dt;
-    OL[Z] = z[IX(i,j,k)] - w0*dt;
+    OL[X] = metric->x[i] - u0*dt; 
+    OL[Y] = metric->y[j] - v0*dt;
+    OL[Z] = metric->z[k] - w0*dt;
     // Initialize the coordinates of previous step
     OC[X] = i; 
     OC[Y] = j; 
@@ -502,6 +845,13 @@ int trace_scalar(PARA_DATA *para, REAL **var, int var_type, int index,
     LOC[X] = 1; 
     LOC[Y] = 1; 
     LOC[Z] = 1;
+    // Find the coordinates directly if no boundary cell is on the way
+    if(locate_departure(para, trace->distp, metric->x, metric->y, metric->z,
+                        i, j, k, OL, OC)==0) {
+      COOD[X] = 0;
+      COOD[Y] = 0;
+      COOD[Z] = 0;
+    }
     //Initialize the number of iterations
     it=1;
 
@@ -518,13 +868,15 @@ int trace_scalar(PARA_DATA *para, REAL **var, int var_type, int index,
       if(COOD[Z]==1 && LOC[Z]==1)
         set_z_location(para, var, flagp, z, w0, i, j, k, OL, OC, LOC, COOD); 
       if(it>itmax) {
-        sprintf(msg, "trace_scalar(): Could not track the location for scalar "
-          "variable %d at cell(%d, %d,%d) after %d interations", 
-          var_type, i, j, k, it);
+        sprintf(msg, "trace_departure(): Could not track the location for "
+          "scalar variables at cell(%d, %d,%d) after %d interations", 
+          i, j, k, it);
         ffd_log(msg, FFD_ERROR);
-        return 1;
+        flag = 1;
+        break;
       }
     } // End of while() for backward tracing
+    if(it>itmax) continue;
 
     // Set the coordinates of previous location if it is as boundary
     if(u0>=0 && LOC[X]==0) OC[X] -=1;
@@ -536,28 +888,82 @@ int trace_scalar(PARA_DATA *para, REAL **var, int var_type, int index,
     if(v0<0 && LOC[Y]==1) OC[Y] -=1;
     if(w0<0 && LOC[Z]==1) OC[Z] -=1;
 
-    //Store the local minium and maximum values
-    var[LOCMIN][IX(i,j,k)]=check_min(para, d0, OC[X], OC[Y], OC[Z]); 
-    var[LOCMAX][IX(i,j,k)]=check_max(para, d0, OC[X], OC[Y], OC[Z]); 
-
     /*-------------------------------------------------------------------------
-    | Interpolate
+    | Store the cell and the relative location of the departure point
     -------------------------------------------------------------------------*/
-    x_1 = (OL[X]- x[IX(OC[X],OC[Y],OC[Z])])
-        / ( x[IX(OC[X]+1,OC[Y],   OC[Z]  )] - x[IX(OC[X],OC[Y],OC[Z])]); 
-    y_1 = (OL[Y]- y[IX(OC[X],OC[Y],OC[Z])])
-        / ( y[IX(OC[X],  OC[Y]+1, OC[Z]  )] - y[IX(OC[X],OC[Y],OC[Z])]);
-    z_1 = (OL[Z]- z[IX(OC[X],OC[Y],OC[Z])])
-        / ( z[IX(OC[X],  OC[Y],   OC[Z]+1)] - z[IX(OC[X],OC[Y],OC[Z])]);
-    d[IX(i,j,k)] = interpolation(para, d0, x_1, y_1, z_1, OC[X], OC[Y], OC[Z]);
-  END_FOR // End of loop for all cells
+    trace->oc[n] = IX(OC[X],OC[Y],OC[Z]);
+    trace->x_1[n] = (OL[X]-metric->x[OC[X]])
+                  / (metric->x[OC[X]+1]-metric->x[OC[X]]); 
+    trace->y_1[n] = (OL[Y]-metric->y[OC[Y]])
+                  / (metric->y[OC[Y]+1]-metric->y[OC[Y]]);
+    trace->z_1[n] = (OL[Z]-metric->z[OC[Z]])
+                  / (metric->z[OC[Z]+1]-metric->z[OC[Z]]);
+  } // End of for() loop for the cells in the cache
 
-  /*---------------------------------------------------------------------------
-  | Define the b.c.
-  ---------------------------------------------------------------------------*/
-  set_bnd(para, var, var_type, index, d, BINDEX);
+  if(flag!=0) return 1;
+
+  trace->departure = 1;
   return 0;
-} // End of trace_scalar()
+} // End of trace_departure()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Interpolate scalar variables at the departure points of the cache
+///
+/// The cache is split into batches of ADVECT_BATCH points, which are
+/// interpolated by \c interpolation_batch() one variable after the other.
+/// The local minimum and maximum around the departure points are stored for
+/// the last variable. For the bilinear interpolation, the corners are 
+/// addressed by their offsets to the cell of the departure point.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param nb Number of variables
+///\param d d[nb]: Pointers to the computed variables at previous time step
+///\param d0 d0[nb]: Pointers to the computed variables for current time step
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void interpolate_departure(PARA_DATA *para, REAL **var, int nb, REAL **d,
+                           REAL **d0) {
+  int start, size, c, o, n, m, l;
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  // Offsets of the corners in the order of check_min() and check_max()
+  int corner[8];
+  REAL *last = d0[nb-1], tmp_min, tmp_max;
+  REAL *locmin = var[LOCMIN], *locmax = var[LOCMAX];
+  TRACE_DATA *trace = para->solv->trace;
+
+  corner[0] = 0;      corner[1] = IJMAX;
+  corner[2] = IMAX;   corner[3] = IMAX+IJMAX;
+  corner[4] = 1;      corner[5] = 1+IJMAX;
+  corner[6] = 1+IMAX; corner[7] = 1+IMAX+IJMAX;
+
+#pragma omp parallel for private(size, c, o, n, m, l, tmp_min, tmp_max) \
+                         schedule(static)
+  for(start=0; start<trace->nb_cell; start+=ADVECT_BATCH) {
+    size = min(ADVECT_BATCH, trace->nb_cell-start);
+
+    for(m=0; m<nb; m++)
+      interpolation_batch(para, d0[m], size, trace->oc+start,
+                          trace->x_1+start, trace->y_1+start,
+                          trace->z_1+start, trace->cell+start, d[m]);
+
+    //Store the local minium and maximum values
+    for(n=start; n<start+size; n++) {
+      c = trace->cell[n];
+      o = trace->oc[n];
+      tmp_min = last[o];
+      tmp_max = last[o];
+      for(l=1; l<8; l++) {
+        if(tmp_min>last[o+corner[l]]) tmp_min = last[o+corner[l]];
+        if(tmp_max<last[o+corner[l]]) tmp_max = last[o+corner[l]];
+      }
+      locmin[c] = tmp_min;
+      locmax[c] = tmp_max;
+    }
+  }
+} // End of interpolate_departure()
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -885,4 +1291,308 @@ void set_z_location(PARA_DATA *para, REAL **var, REAL *flag, REAL *z, REAL w0,
       COOD[Z]=0;
     } // End of if() for inlet or outlet
   } // End of if() for previous position is on the east of new position
-} // End of set_z_location()
\ No newline at end of file
+} // End of set_z_location()
+///////////////////////////////////////////////////////////////////////////////
+/// Find the coordinates of the departure point without tracing cell by cell
+///
+/// The cell of the departure point is searched in each direction with
+/// \c search_location(). If the box of cells between the current cell and 
+/// the found cell contains no boundary cell, the tracing cell by cell would 
+/// end in the same cell without hitting the boundary. Otherwise the tracing
+/// cell by cell is needed. The box is checked by the distances of the current
+/// cell and of the middle cell of the box to the nearest boundary cell.
+///
+///\param para Pointer to FFD parameters
+///\param dist Pointer to the distance of the cells to the boundary cells
+///\param x Pointer to the X-coordinates of the traced variable
+///\param y Pointer to the Y-coordinates of the traced variable
+///\param z Pointer to the Z-coordinates of the traced variable
+///\param i I-index for cell at time t
+///\param j J-index for cell at time t
+///\param k K-index for cell at time t
+///\param OL Pointer to the locations of particle at time (t-1)
+///\param OC Pointer to the coordinates of particle at time (t-1)
+///
+///\return 0 if the coordinates were found, 1 if tracing cell by cell is needed
+///////////////////////////////////////////////////////////////////////////////
+int locate_departure(PARA_DATA *para, unsigned char *dist, REAL *x, REAL *y, 
+                     REAL *z, int i, int j, int k, REAL *OL, int *OC) {
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int ci, cj, ck, steps;
+
+  ci = search_location(x, imax, i, OL[X]);
+  cj = search_location(y, jmax, j, OL[Y]);
+  ck = search_location(z, kmax, k, OL[Z]);
+  if(ci<0 || cj<0 || ck<0) return 1;
+
+  // The cube around the current cell or around the middle cell has to be
+  // free of boundary cells
+  steps = max(abs(ci-i), max(abs(cj-j), abs(ck-k)));
+  if(steps>=dist[IX(i,j,k)] 
+     && (steps+1)/2>=dist[IX((i+ci)/2,(j+cj)/2,(k+ck)/2)]) 
+    return 1;
+
+  OC[X] = ci;
+  OC[Y] = cj;
+  OC[Z] = ck;
+
+  return 0;
+} // End of locate_departure()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Search the coordinate of the departure point in one direction
+///
+/// The result is the cell where \c set_x_location() stops if no boundary is 
+/// on the way. The search range starts at the neighbor of the current cell
+/// and is doubled until it contains the cell, which is then found by a binary
+/// search. The cost is proportional to the logarithm of the number of cells
+/// passed by the particle.
+///
+///\param a Pointer to the 1D coordinates a[0],...,a[n+1]
+///\param n Number of interior cells in the direction
+///\param start Index of the cell at time t
+///\param ol Location of particle at time (t-1)
+///
+///\return Index of the cell or -1 if the location is out of the domain
+///////////////////////////////////////////////////////////////////////////////
+int search_location(REAL *a, int n, int start, REAL ol) {
+  int lo, hi, mid, step;
+
+  if(ol==a[start]) 
+    return start;
+  /****************************************************************************
+  | Backward: the last cell whose coordinate is not larger than ol
+  ****************************************************************************/
+  else if(ol<a[start]) {
+    if(ol<a[0]) return -1;
+    // Double the search range until it contains the cell
+    hi = start - 1;
+    lo = hi;
+    for(step=1; a[lo]>ol; step*=2) {
+      hi = lo - 1;
+      lo = max(lo-step, 0);
+    }
+    while(lo<hi) {
+      mid = (lo+hi+1) / 2;
+      if(a[mid]<=ol) 
+        lo = mid;
+      else 
+        hi = mid - 1;
+    }
+  }
+  /****************************************************************************
+  | Forward: the first cell whose coordinate is not smaller than ol
+  ****************************************************************************/
+  else {
+    if(!(ol<=a[n+1])) return -1;
+    // Double the search range until it contains the cell
+    lo = start + 1;
+    hi = lo;
+    for(step=1; a[hi]<ol; step*=2) {
+      lo = hi + 1;
+      hi = hi+step<n+1 ? hi+step : n+1;
+    }
+    while(lo<hi) {
+      mid = (lo+hi) / 2;
+      if(a[mid]>=ol) 
+        hi = mid;
+      else 
+        lo = mid + 1;
+    }
+  }
+
+  return lo;
+} // End of search_location()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Allocate the data for the search of the departure points
+///
+/// The boundary cells do not change during the simulation, so that their 
+/// distances are computed only once at the first call of \c advect(). The
+/// trace substances after the advection are also stored here, since all of
+/// them are advected before they are diffused. The cache of the departure 
+/// points holds the cells with FLAGP<0, which do not change either.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int allocate_trace_data(PARA_DATA *para, REAL **var) {
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int size = (imax+2)*(jmax+2)*(kmax+2);
+  int i, j, k, n;
+  size_t stride;
+  TRACE_DATA *trace;
+  unsigned char *block;
+  REAL *arena = NULL;
+
+  trace = (TRACE_DATA *) malloc(sizeof(TRACE_DATA));
+  block = (unsigned char *) malloc(4*size*sizeof(unsigned char));
+  if(trace==NULL || block==NULL) {
+    ffd_log("allocate_trace_data(): Could not allocate memory for the "
+            "distances.", FFD_ERROR);
+    free(trace);
+    free(block);
+    return 1;
+  }
+
+  trace->distp = block;
+  trace->distu = trace->distp + size;
+  trace->distv = trace->distu + size;
+  trace->distw = trace->distv + size;
+
+  /****************************************************************************
+  | Allocate the trace substances after the advection
+  ****************************************************************************/
+  trace->nb_den0 = para->bc->nb_Xi;
+  trace->den0 = NULL;
+  if(trace->nb_den0>0) {
+    stride = (size*sizeof(REAL) + FFD_ALIGN-1) / FFD_ALIGN * FFD_ALIGN
+           / sizeof(REAL);
+    trace->den0 = (REAL **) malloc(trace->nb_den0*sizeof(REAL *));
+    arena = (REAL *) ffd_aligned_malloc(trace->nb_den0*stride*sizeof(REAL));
+    if(trace->den0==NULL || arena==NULL) {
+      ffd_log("allocate_trace_data(): Could not allocate memory for the "
+              "trace substances.", FFD_ERROR);
+      free(trace->den0);
+      ffd_aligned_free(arena);
+      free(block);
+      free(trace);
+      return 1;
+    }
+    memset(arena, 0, trace->nb_den0*stride*sizeof(REAL));
+    for(n=0; n<trace->nb_den0; n++)
+      trace->den0[n] = arena + n*stride;
+  }
+
+  /****************************************************************************
+  | Allocate the cache of the departure points for the fluid cells
+  ****************************************************************************/
+  trace->nb_cell = 0;
+  FOR_EACH_CELL
+    if(var[FLAGP][IX(i,j,k)]<0) trace->nb_cell++;
+  END_FOR
+  trace->cell = (int *) malloc(2*trace->nb_cell*sizeof(int));
+  trace->x_1 = (REAL *) malloc(3*trace->nb_cell*sizeof(REAL));
+  if(trace->nb_cell>0 && (trace->cell==NULL || trace->x_1==NULL)) {
+    ffd_log("allocate_trace_data(): Could not allocate memory for the "
+            "departure points.", FFD_ERROR);
+    free(trace->cell);
+    free(trace->x_1);
+    if(trace->den0!=NULL) {
+      ffd_aligned_free(trace->den0[0]);
+      free(trace->den0);
+    }
+    free(block);
+    free(trace);
+    return 1;
+  }
+  trace->oc = trace->cell + trace->nb_cell;
+  trace->y_1 = trace->x_1 + trace->nb_cell;
+  trace->z_1 = trace->y_1 + trace->nb_cell;
+  trace->departure = 0;
+
+  // The cells are stored in the order of the memory
+  n = 0;
+  for(k=1; k<=kmax; k++)
+    for(j=1; j<=jmax; j++)
+      for(i=1; i<=imax; i++)
+        if(var[FLAGP][IX(i,j,k)]<0) trace->cell[n++] = IX(i,j,k);
+
+  boundary_distance(para, var[FLAGP], trace->distp);
+  boundary_distance(para, var[FLAGU], trace->distu);
+  boundary_distance(para, var[FLAGV], trace->distv);
+  boundary_distance(para, var[FLAGW], trace->distw);
+
+  para->solv->trace = trace;
+
+  return 0;
+} // End of allocate_trace_data()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free the data for the search of the departure points
+///
+///\param para Pointer to FFD parameters
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_trace_data(PARA_DATA *para) {
+  if(para->solv->trace==NULL) return;
+
+  free(para->solv->trace->distp);
+  free(para->solv->trace->cell);
+  free(para->solv->trace->x_1);
+  if(para->solv->trace->den0!=NULL) {
+    ffd_aligned_free(para->solv->trace->den0[0]);
+    free(para->solv->trace->den0);
+  }
+  free(para->solv->trace);
+  para->solv->trace = NULL;
+} // End of free_trace_data()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Calculate the distance of the cells to the nearest boundary cell
+///
+/// The distance is the number of cells in the maximum norm, so that all the
+/// cells within dist-1 cells in each direction have flag<0. It is 0 for the 
+/// cells with flag>=0 and limited to 255. The distances are computed by a 
+/// forward and a backward sweep over the 26 neighbors.
+///
+///\param para Pointer to FFD parameters
+///\param flag Pointer to the cell property flag
+///\param dist Pointer to the distance
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void boundary_distance(PARA_DATA *para, REAL *flag, unsigned char *dist) {
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int i, j, k, di, dj, dk, d, s;
+
+  /****************************************************************************
+  | Forward sweep over the neighbors that have been visited
+  ****************************************************************************/
+  FOR_ALL_CELL
+    if(flag[IX(i,j,k)]>=0) {
+      dist[IX(i,j,k)] = 0;
+      continue;
+    }
+    d = 255;
+    for(dk=-1; dk<=0; dk++)
+      for(dj=-1; dj<=1; dj++)
+        for(di=-1; di<=1; di++) {
+          if(dk==0 && (dj>0 || (dj==0 && di>=0))) continue;
+          if(i+di<0 || i+di>imax+1 || j+dj<0 || j+dj>jmax+1 || k+dk<0) 
+            continue;
+          s = dist[IX(i+di,j+dj,k+dk)] + 1;
+          if(s<d) d = s;
+        }
+    dist[IX(i,j,k)] = (unsigned char) d;
+  END_FOR
+
+  /****************************************************************************
+  | Backward sweep over the other neighbors
+  ****************************************************************************/
+  for(k=kmax+1; k>=0; k--)
+    for(j=jmax+1; j>=0; j--)
+      for(i=imax+1; i>=0; i--) {
+        d = dist[IX(i,j,k)];
+        if(d==0) continue;
+        for(dk=0; dk<=1; dk++)
+          for(dj=-1; dj<=1; dj++)
+            for(di=-1; di<=1; di++) {
+              if(dk==0 && (dj<0 || (dj==0 && di<=0))) continue;
+              if(i+di<0 || i+di>imax+1 || j+dj<0 || j+dj>jmax+1 || k+dk>kmax+1)
+                continue;
+              s = dist[IX(i+di,j+dj,k+dk)] + 1;
+              if(s<d) d = s;
+            }
+        dist[IX(i,j,k)] = (unsigned char) d;
+      }
+} // End of boundary_distance()
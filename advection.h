@@ -19,9 +19,14 @@
 /// the location of variables assigned in the control volume. 
 /// Velocities at X, Y and Z directions are locatted
 /// on the surface of the control volume. They are computed using 
-/// subroutines: \c trace_vx(), \c trace_vy() and \ctrace_vz().
+/// subroutines: \c trace_vx(), \c trace_vy() and \c trace_vz(). The
+/// velocity step interleaves the lines of the three components in a single
+/// parallel sweep through \c advect_velocity() and \c trace_velocity().
 /// Scalar variables are in the center of control volume and they are computed
-/// using \c trace_scalar().
+/// using \c trace_scalar(). Their departure points are traced once after the
+/// velocity has changed and kept in a cache, which is shared by the 
+/// temperature and all the trace substances. The cache is interpolated in
+/// batches by \c interpolation_batch().
 ///
 ///////////////////////////////////////////////////////////////////////////////
 
@@ -54,6 +59,8 @@
 #include "solver.h"
 #endif
 
+#define ADVECT_BATCH 1024 // Number of departure points interpolated together
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Entrance of advection step
 ///
@@ -73,6 +80,39 @@
 int advect(PARA_DATA *para, REAL **var, int var_type, int index, 
            REAL *d, REAL *d0, int **BINDEX);
 
+///////////////////////////////////////////////////////////////////////////////
+/// Entrance of advection step for the three velocity components
+///
+/// The lines of the velocities in X, Y and Z direction are interleaved in
+/// one parallel sweep by \c trace_velocity().
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param du Pointer to the computed X-velocity for current time step
+///\param dv Pointer to the computed Y-velocity for current time step
+///\param dw Pointer to the computed Z-velocity for current time step
+///\param BINDEX Pointer to boundary index
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int advect_velocity(PARA_DATA *para, REAL **var, REAL *du, REAL *dv, 
+                    REAL *dw, int **BINDEX);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Entrance of advection step for several trace substances
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param nb Number of trace substances
+///\param d d[nb]: Pointers to the computed variables at previous time step
+///\param d0 d0[nb]: Pointers to the computed variables for current time step
+///\param BINDEX Pointer to boundary index
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int advect_species(PARA_DATA *para, REAL **var, int nb, REAL **d, REAL **d0,
+                   int **BINDEX);
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Advection for velocity at X-direction
 ///
@@ -88,6 +128,24 @@ int advect(PARA_DATA *para, REAL **var, int var_type, int index,
 int trace_vx(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0, 
              int **BINDEX);
 
+///////////////////////////////////////////////////////////////////////////////
+/// Advection for one line of velocity at X-direction
+///
+/// The departure points of the cells (i,j,k) along the line are traced back
+/// and the velocity is interpolated there.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param d Pointer to the computed variables at previous time step
+///\param d0 Pointer to the computed variables for current time step
+///\param j J-index of the line
+///\param k K-index of the line
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int trace_vx_line(PARA_DATA *para, REAL **var, REAL *d, REAL *d0,
+                  int j, int k);
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Advection for velocity at Y-direction
 ///
@@ -103,6 +161,24 @@ int trace_vx(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0,
 int trace_vy(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0, 
              int **BINDEX);
 
+///////////////////////////////////////////////////////////////////////////////
+/// Advection for one line of velocity at Y-direction
+///
+/// The departure points of the cells (i,j,k) along the line are traced back
+/// and the velocity is interpolated there.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param d Pointer to the computed variables at previous time step
+///\param d0 Pointer to the computed variables for current time step
+///\param j J-index of the line
+///\param k K-index of the line
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int trace_vy_line(PARA_DATA *para, REAL **var, REAL *d, REAL *d0,
+                  int j, int k);
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Advection for velocity at Z-direction
 ///
@@ -118,10 +194,54 @@ int trace_vy(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0,
 int trace_vz(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0, 
              int **BINDEX);
 
+///////////////////////////////////////////////////////////////////////////////
+/// Advection for one line of velocity at Z-direction
+///
+/// The departure points of the cells (i,j,k) along the line are traced back
+/// and the velocity is interpolated there.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param d Pointer to the computed variables at previous time step
+///\param d0 Pointer to the computed variables for current time step
+///\param j J-index of the line
+///\param k K-index of the line
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int trace_vz_line(PARA_DATA *para, REAL **var, REAL *d, REAL *d0,
+                  int j, int k);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Advection for the velocities in X, Y and Z direction
+///
+/// The lines of the three components at the same j and k are traced one
+/// after the other in the same sweep, so that the velocity rows around the
+/// line are mostly still in cache for the second and third component. This
+/// is only an interleaving: each component lies on its own cell face, so
+/// the face velocities, the departure point and the interpolation are
+/// computed separately by \c trace_vx_line(), \c trace_vy_line() and
+/// \c trace_vz_line(). The results are the same as with \c trace_vx(),
+/// \c trace_vy() and \c trace_vz().
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param du Pointer to the computed X-velocity for current time step
+///\param dv Pointer to the computed Y-velocity for current time step
+///\param dw Pointer to the computed Z-velocity for current time step
+///\param BINDEX Pointer to boundary index
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int trace_velocity(PARA_DATA *para, REAL **var, REAL *du, REAL *dv, 
+                   REAL *dw, int **BINDEX);
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Advection for scalar variables located in the center of control volume
 ///
+/// The departure points are taken from the cache, which is computed at the 
+/// first advection of a scalar variable after the velocity has changed.
+///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
 ///\param var_type The type of variable for advection solver
@@ -135,6 +255,60 @@ int trace_vz(PARA_DATA *para, REAL **var, int var_type, REAL *d, REAL *d0,
 int trace_scalar(PARA_DATA *para, REAL **var, int var_type, int index,
                  REAL *d, REAL *d0, int **BINDEX);
 
+///////////////////////////////////////////////////////////////////////////////
+/// Advection for several trace substances
+///
+/// All the trace substances are interpolated at the departure points of the
+/// cache in one pass. The results are the same as the ones of 
+/// \c trace_scalar() called for each substance.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param nb Number of trace substances
+///\param d d[nb]: Pointers to the computed variables at previous time step
+///\param d0 d0[nb]: Pointers to the computed variables for current time step
+///\param BINDEX Pointer to boundary index
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int trace_species(PARA_DATA *para, REAL **var, int nb, REAL **d, REAL **d0,
+                  int **BINDEX);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Trace back the departure points of the scalar variables
+///
+/// The departure points only depend on the velocity, so that they are shared
+/// by the temperature and all the trace substances of one time step. For 
+/// each cell of the cache, the index of the cell of the departure point and
+/// the relative location of the departure point in that cell are stored.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int trace_departure(PARA_DATA *para, REAL **var);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Interpolate scalar variables at the departure points of the cache
+///
+/// The cache is split into batches of ADVECT_BATCH points, which are
+/// interpolated by \c interpolation_batch() one variable after the other.
+/// The local minimum and maximum around the departure points are stored for
+/// the last variable. For the bilinear interpolation, the corners are 
+/// addressed by their offsets to the cell of the departure point.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param nb Number of variables
+///\param d d[nb]: Pointers to the computed variables at previous time step
+///\param d0 d0[nb]: Pointers to the computed variables for current time step
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void interpolate_departure(PARA_DATA *para, REAL **var, int nb, REAL **d,
+                           REAL **d0);
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Find the X-location and coordinates at previous time step
 ///
@@ -208,4 +382,86 @@ void set_y_location(PARA_DATA *para, REAL **var, REAL *flag, REAL *y, REAL v0,
 ///////////////////////////////////////////////////////////////////////////////
 void set_z_location(PARA_DATA *para, REAL **var, REAL *flag, REAL *z, REAL w0, 
                     int i, int j, int k, 
-                    REAL *OL, int *OC, int *LOC , int *COOD);
\ No newline at end of file
+                    REAL *OL, int *OC, int *LOC , int *COOD);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Find the coordinates of the departure point without tracing cell by cell
+///
+/// The cell of the departure point is searched in each direction with
+/// \c search_location(). If the box of cells between the current cell and 
+/// the found cell contains no boundary cell, the tracing cell by cell would 
+/// end in the same cell without hitting the boundary. Otherwise the tracing
+/// cell by cell is needed. The box is checked by the distances of the current
+/// cell and of the middle cell of the box to the nearest boundary cell.
+///
+///\param para Pointer to FFD parameters
+///\param dist Pointer to the distance of the cells to the boundary cells
+///\param x Pointer to the X-coordinates of the traced variable
+///\param y Pointer to the Y-coordinates of the traced variable
+///\param z Pointer to the Z-coordinates of the traced variable
+///\param i I-index for cell at time t
+///\param j J-index for cell at time t
+///\param k K-index for cell at time t
+///\param OL Pointer to the locations of particle at time (t-1)
+///\param OC Pointer to the coordinates of particle at time (t-1)
+///
+///\return 0 if the coordinates were found, 1 if tracing cell by cell is needed
+///////////////////////////////////////////////////////////////////////////////
+int locate_departure(PARA_DATA *para, unsigned char *dist, REAL *x, REAL *y, 
+                     REAL *z, int i, int j, int k, REAL *OL, int *OC);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Search the coordinate of the departure point in one direction
+///
+/// The result is the cell where \c set_x_location() stops if no boundary is 
+/// on the way. The search range starts at the neighbor of the current cell
+/// and is doubled until it contains the cell, which is then found by a binary
+/// search. The cost is proportional to the logarithm of the number of cells
+/// passed by the particle.
+///
+///\param a Pointer to the 1D coordinates a[0],...,a[n+1]
+///\param n Number of interior cells in the direction
+///\param start Index of the cell at time t
+///\param ol Location of particle at time (t-1)
+///
+///\return Index of the cell or -1 if the location is out of the domain
+///////////////////////////////////////////////////////////////////////////////
+int search_location(REAL *a, int n, int start, REAL ol);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Allocate the data for the search of the departure points
+///
+/// The boundary cells do not change during the simulation, so that their 
+/// distances are computed only once at the first call of \c advect().
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int allocate_trace_data(PARA_DATA *para, REAL **var);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free the data for the search of the departure points
+///
+///\param para Pointer to FFD parameters
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_trace_data(PARA_DATA *para);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Calculate the distance of the cells to the nearest boundary cell
+///
+/// The distance is the number of cells in the maximum norm, so that all the
+/// cells within dist-1 cells in each direction have flag<0. It is 0 for the 
+/// cells with flag>=0 and limited to 255. The distances are computed by a 
+/// forward and a backward sweep over the 26 neighbors.
+///
+///\param para Pointer to FFD parameters
+///\param flag Pointer to the cell property flag
+///\param dist Pointer to the distance
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void boundary_distance(PARA_DATA *para, REAL *flag, unsigned char *dist);
@@ -0,0 +1,133 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// \file   bench.h
+///
+/// \brief  Test room shared by the benchmarks of the solver kernels
+///
+/// \author agent
+///         agent@local
+///
+/// \date   10/17/2026
+///
+/// The room is a cube of 1 m with n cells in each direction. The grid is
+/// stretched by up to 30%, so that the kernels see the non-uniform spacing
+/// of real cases. The walls are solid with a fixed temperature of 30 degC
+/// and a solid block sits in the room. The benchmarks are built from the
+/// root of the repository with the compile line given in their file.
+///
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef _BENCH_H
+#define _BENCH_H
+#endif
+
+#ifndef _FFD_H
+#define _FFD_H
+#include "ffd.h"
+#endif
+
+#ifndef _GEOMETRY_H
+#define _GEOMETRY_H
+#include "geometry.h"
+#endif
+
+#ifndef _SCI_READER_H
+#define _SCI_READER_H
+#include "sci_reader.h"
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+/// Create the test room with n cells in each direction
+///
+///\param n Number of cells in each direction
+///
+///\return Pointer to the instance, NULL if an error occurred
+///////////////////////////////////////////////////////////////////////////////
+static FFD_INSTANCE *bench_room(int n) {
+  FFD_INSTANCE *inst;
+  PARA_DATA *para;
+  REAL **var, *f;
+  int **BINDEX;
+  int i, j, k, wall, block;
+  int imax = n, jmax = n, kmax = n;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+
+  inst = new_ffd_instance(NULL);
+  if(inst==NULL) return NULL;
+  para = &inst->para;
+  set_default_parameter(para);
+
+  para->geom->imax = para->geom->jmax = para->geom->kmax = n;
+  para->geom->index = 0;
+  para->bc->nb_Xi = 0;
+  para->bc->nb_C = 0;
+  para->prob->nu = (REAL) 1.5e-5;
+  para->prob->alpha = (REAL) 2.0e-5;
+  para->prob->diff = (REAL) 1.0e-5;
+  para->prob->rho = (REAL) 1.2;
+  para->prob->Cp = (REAL) 1000.0;
+  para->prob->beta = (REAL) 3.0e-3;
+  para->prob->gravz = (REAL) -9.81;
+  para->prob->Temp_Buoyancy = (REAL) 20.0;
+  para->prob->tur_model = LAM;
+  para->mytime->dt = 0.1;
+
+  if(allocate_memory(inst)!=0) {
+    free_ffd_instance(inst);
+    return NULL;
+  }
+  var = inst->var;
+  BINDEX = inst->BINDEX;
+
+  // Cell faces of the stretched grid
+  f = (REAL *) malloc((n+2)*sizeof(REAL));
+  if(f==NULL) {
+    free_ffd_instance(inst);
+    return NULL;
+  }
+  f[0] = 0;
+  for(i=1; i<=n; i++)
+    f[i] = f[i-1] + (REAL) (1.0/n * (1.0 + 0.3*sin(0.2*i)));
+  for(i=1; i<=n; i++)
+    f[i] /= f[n];
+  f[n+1] = f[n];
+
+  FOR_ALL_CELL
+    var[GX][IX(i,j,k)] = f[i<=n ? i : n];
+    var[GY][IX(i,j,k)] = f[j<=n ? j : n];
+    var[GZ][IX(i,j,k)] = f[k<=n ? k : n];
+    var[X][IX(i,j,k)] = i==0 ? 0 : (i==n+1 ? f[n] : (f[i]+f[i-1])/2);
+    var[Y][IX(i,j,k)] = j==0 ? 0 : (j==n+1 ? f[n] : (f[j]+f[j-1])/2);
+    var[Z][IX(i,j,k)] = k==0 ? 0 : (k==n+1 ? f[n] : (f[k]+f[k-1])/2);
+
+    wall = i==0 || j==0 || k==0 || i==n+1 || j==n+1 || k==n+1;
+    block = i>n/3 && i<n/2 && j>n/4 && j<n/2 && k<n/3;
+    var[FLAGP][IX(i,j,k)] = (REAL) (wall || block ? SOLID : FLUID);
+    var[FLAGU][IX(i,j,k)] = -1;
+    var[FLAGV][IX(i,j,k)] = -1;
+    var[FLAGW][IX(i,j,k)] = -1;
+    if(wall || block) {
+      BINDEX[0][para->geom->index] = i;
+      BINDEX[1][para->geom->index] = j;
+      BINDEX[2][para->geom->index] = k;
+      BINDEX[3][para->geom->index] = 1;
+      para->geom->index++;
+      var[TEMPBC][IX(i,j,k)] = 30;
+    }
+
+    var[TEMP][IX(i,j,k)] = (REAL) (20.0 + sin(i+j) + cos(0.3*k));
+    var[VX][IX(i,j,k)] = (REAL) (0.6*cos(0.2*k+0.1*j) + 0.4);
+    var[VY][IX(i,j,k)] = (REAL) (0.7*sin(0.15*i+0.2*k));
+    var[VZ][IX(i,j,k)] = (REAL) (-0.5*cos(0.1*j+0.3*i));
+    var[PP][IX(i,j,k)] = (REAL) sin(0.1*i);
+  END_FOR
+  free(f);
+
+  mark_cell(para, var);
+  if(build_metric(para, var)!=0) {
+    free_ffd_instance(inst);
+    return NULL;
+  }
+
+  return inst;
+} // End of bench_room()
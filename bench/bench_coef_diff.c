@@ -0,0 +1,95 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// \file   bench_coef_diff.c
+///
+/// \brief  Benchmark of the coefficients of the diffusion equation
+///
+/// \author agent
+///         agent@local
+///
+/// \date   10/17/2026
+///
+/// coef_diff() is timed for the three velocities and the temperature on a
+/// room of 64^3 cells. Other sizes can be given as arguments. The loops of
+/// coef_diff() are vectorized with -fopenmp or -fopenmp-simd, the scalar
+/// code is timed by leaving both out.
+///
+/// Build from the root of the repository with (on one line):
+///   gcc -O2 -fopenmp-simd -I. -o bench_coef_diff
+///       bench/bench_coef_diff.c *.c -lglut -lGLU -lGL -lm -lpthread
+/// and run with:
+///   ./bench_coef_diff [n ...]
+///
+///////////////////////////////////////////////////////////////////////////////
+
+#include "bench.h"
+
+///////////////////////////////////////////////////////////////////////////////
+/// Run the benchmark for one size of room
+///
+///\param n Number of cells in each direction
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+static int bench_size(int n) {
+  FFD_INSTANCE *inst;
+  PARA_DATA *para;
+  REAL **var;
+  double t0, t;
+  int type[4] = {VX, VY, VZ, TEMP};
+  int psi[4] = {VX, VY, VZ, TEMP};
+  int psi0[4] = {VXS, VYS, VZS, TEMPS};
+  const char *name[4] = {"VX", "VY", "VZ", "TEMP"};
+  int it, i;
+  // Number of calls, about 2e8 cells
+  int nb = 2 + 200000000 / (n*n*n);
+
+  inst = bench_room(n);
+  if(inst==NULL) {
+    fprintf(stderr, "Could not create the room of %d^3 cells\n", n);
+    return 1;
+  }
+  para = &inst->para;
+  var = inst->var;
+
+  printf("\n%d^3 cells, %d calls\n", n, nb);
+  printf("%-5s %10s\n", "type", "ms/call");
+
+  for(it=0; it<4; it++) {
+    memcpy(var[psi0[it]], var[psi[it]], sizeof(REAL)*(n+2)*(n+2)*(n+2));
+    // First call to warm up the caches
+    coef_diff(para, var, var[psi[it]], var[psi0[it]], type[it], 0,
+              inst->BINDEX);
+
+    t0 = ffd_clock();
+    for(i=0; i<nb; i++)
+      coef_diff(para, var, var[psi[it]], var[psi0[it]], type[it], 0,
+                inst->BINDEX);
+    t = (ffd_clock()-t0) / nb * 1000;
+
+    printf("%-5s %10.3f\n", name[it], t);
+  }
+
+  free_ffd_instance(inst);
+  return 0;
+} // End of bench_size()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Main routine of the benchmark
+///
+///\param argc Number of arguments
+///\param argv Sizes of the rooms, 64 if none is given
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int main(int argc, char **argv) {
+  int i;
+
+  if(argc<2)
+    return bench_size(64);
+
+  for(i=1; i<argc; i++)
+    if(bench_size(atoi(argv[i]))!=0) return 1;
+
+  return 0;
+} // End of main()
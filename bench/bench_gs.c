@@ -0,0 +1,129 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// \file   bench_gs.c
+///
+/// \brief  Benchmark of the Gauss-Seidel solvers on several threads
+///
+/// \author agent
+///         agent@local
+///
+/// \date   10/17/2026
+///
+/// The pressure solver GS_P() and the solver Gauss_Seidel() for the
+/// temperature are timed with the lexicographic and the red-black sweeps
+/// on a room of 64^3 and 128^3 cells, using 1 up to omp_get_max_threads()
+/// threads. Other sizes can be given as arguments. The speedup is relative
+/// to the lexicographic sweeps on one thread.
+///
+/// Build from the root of the repository with (on one line):
+///   gcc -O2 -fopenmp -I. -o bench_gs bench/bench_gs.c *.c
+///       -lglut -lGLU -lGL -lm -lpthread
+/// and run with:
+///   OMP_PROC_BIND=close ./bench_gs [n ...]
+///
+///////////////////////////////////////////////////////////////////////////////
+
+#include "bench.h"
+
+static const char *order_name[2] = {"lexicographic", "red-black"};
+
+///////////////////////////////////////////////////////////////////////////////
+/// Time one solver call
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param pressure 1: GS_P(); 0: Gauss_Seidel() for the temperature
+///\param nb Number of calls
+///
+///\return Time of one call in milliseconds
+///////////////////////////////////////////////////////////////////////////////
+static double time_solver(PARA_DATA *para, REAL **var, int pressure, int nb) {
+  double t0;
+  int i;
+
+  // First call to warm up the caches and the threads
+  if(pressure) GS_P(para, var, IP, var[IP]);
+  else Gauss_Seidel(para, var, TEMP, var[FLAGP], var[TEMP]);
+
+  t0 = ffd_clock();
+  for(i=0; i<nb; i++)
+    if(pressure) GS_P(para, var, IP, var[IP]);
+    else Gauss_Seidel(para, var, TEMP, var[FLAGP], var[TEMP]);
+
+  return (ffd_clock()-t0) / nb * 1000;
+} // End of time_solver()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Run the benchmark for one size of room
+///
+///\param n Number of cells in each direction
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+static int bench_size(int n) {
+  FFD_INSTANCE *inst;
+  PARA_DATA *para;
+  REAL **var;
+  double t, t_ref[2];
+  int pressure, order, nb_thread, max_thread = omp_get_max_threads();
+  // Number of calls, about 5e7 cell updates for the pressure
+  int nb = 2 + 50000000 / (20*n*n*n);
+
+  inst = bench_room(n);
+  if(inst==NULL) {
+    fprintf(stderr, "Could not create the room of %d^3 cells\n", n);
+    return 1;
+  }
+  para = &inst->para;
+  var = inst->var;
+
+  // Coefficients of the pressure and of the temperature
+  project(para, var, inst->BINDEX);
+  memcpy(var[TEMPS], var[TEMP], sizeof(REAL)*(n+2)*(n+2)*(n+2));
+  coef_diff(para, var, var[TEMP], var[TEMPS], TEMP, 0, inst->BINDEX);
+
+  printf("\n%d^3 cells, %d calls\n", n, nb);
+  printf("%-13s %-14s %7s %10s %8s\n",
+         "solver", "sweeps", "threads", "ms/call", "speedup");
+
+  for(pressure=1; pressure>=0; pressure--)
+    for(order=LEXICOGRAPHIC; order<=REDBLACK; order++)
+      for(nb_thread=1; nb_thread<=max_thread; nb_thread++) {
+        // The lexicographic sweeps are serial
+        if(order==LEXICOGRAPHIC && nb_thread>1) break;
+        omp_set_num_threads(nb_thread);
+        para->solv->gs_order = order;
+        t = time_solver(para, var, pressure, nb);
+        if(order==LEXICOGRAPHIC) t_ref[pressure] = t;
+        printf("%-13s %-14s %7d %10.2f %8.2f\n",
+               pressure ? "GS_P" : "Gauss_Seidel", order_name[order],
+               nb_thread, t, t_ref[pressure]/t);
+      }
+
+  omp_set_num_threads(max_thread);
+  free_ffd_instance(inst);
+  return 0;
+} // End of bench_size()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Main routine of the benchmark
+///
+///\param argc Number of arguments
+///\param argv Sizes of the rooms, 64 and 128 if none is given
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int main(int argc, char **argv) {
+  int i;
+
+  printf("Gauss-Seidel benchmark with up to %d threads\n",
+         omp_get_max_threads());
+
+  if(argc<2)
+    return bench_size(64) || bench_size(128);
+
+  for(i=1; i<argc; i++)
+    if(bench_size(atoi(argv[i]))!=0) return 1;
+
+  return 0;
+} // End of main()
@@ -0,0 +1,182 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// \file   bench_gs_layout.c
+///
+/// \brief  Benchmark of the loop order of the lexicographic Gauss-Seidel sweep
+///
+/// \author agent
+///         agent@local
+///
+/// \date   10/17/2026
+///
+/// One lexicographic sweep of the pressure equation is timed with the loops
+/// of the former code, which run K innermost, and with GS_sweep(), which
+/// runs I innermost, on a room of 64^3 and 128^3 cells. Other sizes can be
+/// given as arguments. Both sweeps visit the neighbors in the same order,
+/// so their results must be identical, which is checked.
+///
+/// Build from the root of the repository with (on one line):
+///   gcc -O2 -fopenmp -I. -o bench_gs_layout
+///       bench/bench_gs_layout.c *.c -lglut -lGLU -lGL -lm -lpthread
+/// and run with:
+///   ./bench_gs_layout [n ...]
+/// To count the cache misses of one loop order, give it after the size:
+///   perf stat -e cache-references,cache-misses ./bench_gs_layout 128 k
+///   valgrind --tool=cachegrind ./bench_gs_layout 64 i
+/// where k is the K-inner sweep and i is GS_sweep().
+///
+///////////////////////////////////////////////////////////////////////////////
+
+#include "bench.h"
+
+///////////////////////////////////////////////////////////////////////////////
+/// Lexicographic sweep with K innermost as in the former GS_P()
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param flag Pointer to the cell property flag
+///\param x Pointer to variable
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+static void sweep_k_inner(PARA_DATA *para, REAL **var, REAL *flag, REAL *x) {
+  REAL *as = var[AS], *aw = var[AW], *ae = var[AE], *an = var[AN];
+  REAL *ap = var[AP], *af = var[AF], *ab = var[AB], *b = var[B];
+  int imax = para->geom->imax, jmax= para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int i, j, k;
+
+  for(i=1; i<=imax; i++)
+    for(j=1; j<=jmax; j++)
+      for(k=1; k<=kmax; k++) {
+        if (flag[IX(i,j,k)]>=0) continue;
+
+        x[IX(i,j,k)] = (  ae[IX(i,j,k)]*x[IX(i+1,j,k)]
+                        + aw[IX(i,j,k)]*x[IX(i-1,j,k)]
+                        + an[IX(i,j,k)]*x[IX(i,j+1,k)]
+                        + as[IX(i,j,k)]*x[IX(i,j-1,k)]
+                        + af[IX(i,j,k)]*x[IX(i,j,k+1)]
+                        + ab[IX(i,j,k)]*x[IX(i,j,k-1)]
+                        + b[IX(i,j,k)] ) / ap[IX(i,j,k)];
+      }
+} // End of sweep_k_inner()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Time one sweep
+///
+/// The sweeps start from the same pressure, which is restored before the
+/// timed calls.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param p0 Pointer to the initial pressure
+///\param k_inner 1: K-inner sweep; 0: GS_sweep()
+///\param nb Number of calls
+///
+///\return Time of one call in milliseconds
+///////////////////////////////////////////////////////////////////////////////
+static double time_sweep(PARA_DATA *para, REAL **var, REAL *p0,
+                         int k_inner, int nb) {
+  int size = (para->geom->imax+2) * (para->geom->jmax+2)
+           * (para->geom->kmax+2);
+  double t0;
+  int i;
+
+  memcpy(var[IP], p0, size*sizeof(REAL));
+
+  t0 = ffd_clock();
+  for(i=0; i<nb; i++)
+    if(k_inner) sweep_k_inner(para, var, var[FLAGP], var[IP]);
+    else GS_sweep(para, var, var[FLAGP], var[IP], 1, 1, 1, NULL);
+
+  return (ffd_clock()-t0) / nb * 1000;
+} // End of time_sweep()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Run the benchmark for one size of room
+///
+///\param n Number of cells in each direction
+///\param only Loop order to run alone: 'k', 'i' or 0 for all of them
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+static int bench_size(int n, char only) {
+  FFD_INSTANCE *inst;
+  PARA_DATA *para;
+  REAL **var, *p0, *p_ref;
+  double t_k, t_i;
+  int size = (n+2)*(n+2)*(n+2);
+  int same;
+  // Number of calls, about 2e8 cell updates
+  int nb = 2 + 200000000 / (n*n*n);
+
+  inst = bench_room(n);
+  if(inst==NULL) {
+    fprintf(stderr, "Could not create the room of %d^3 cells\n", n);
+    return 1;
+  }
+  para = &inst->para;
+  var = inst->var;
+
+  // Coefficients of the pressure equation
+  project(para, var, inst->BINDEX);
+
+  p0 = (REAL *) malloc(size*sizeof(REAL));
+  p_ref = (REAL *) malloc(size*sizeof(REAL));
+  if(p0==NULL || p_ref==NULL) {
+    fprintf(stderr, "Could not allocate the pressure of %d^3 cells\n", n);
+    free(p0);
+    free(p_ref);
+    free_ffd_instance(inst);
+    return 1;
+  }
+  memcpy(p0, var[IP], size*sizeof(REAL));
+
+  if(only!=0) {
+    t_k = time_sweep(para, var, p0, only=='k', nb);
+    printf("%d^3 cells, %d calls, %s inner: %.3f ms/call\n", n, nb,
+           only=='k' ? "K" : "I", t_k);
+  }
+  else {
+    t_k = time_sweep(para, var, p0, 1, nb);
+    memcpy(p_ref, var[IP], size*sizeof(REAL));
+    t_i = time_sweep(para, var, p0, 0, nb);
+    same = memcmp(var[IP], p_ref, size*sizeof(REAL))==0;
+
+    printf("\n%d^3 cells, %d calls\n", n, nb);
+    printf("%-7s %10s\n", "inner", "ms/call");
+    printf("%-7s %10.3f\n", "K", t_k);
+    printf("%-7s %10.3f\n", "I", t_i);
+    printf("speedup %.2f, identical: %s\n", t_k/t_i, same ? "yes" : "NO");
+  }
+
+  free(p0);
+  free(p_ref);
+  free_ffd_instance(inst);
+  return 0;
+} // End of bench_size()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Main routine of the benchmark
+///
+///\param argc Number of arguments
+///\param argv Sizes of the rooms, 64 and 128 if none is given, optionally
+///            followed by the loop order to run alone
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int main(int argc, char **argv) {
+  int i;
+
+  if(argc<2)
+    return bench_size(64, 0) || bench_size(128, 0);
+
+  if(argc==3 && (argv[2][0]=='k' || argv[2][0]=='i'))
+    return bench_size(atoi(argv[1]), argv[2][0]);
+
+  for(i=1; i<argc; i++)
+    if(bench_size(atoi(argv[i]), 0)!=0) return 1;
+
+  return 0;
+} // End of main()
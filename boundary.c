@@ -40,6 +40,8 @@
 int set_bnd(PARA_DATA *para, REAL **var, int var_type, int index, REAL *psi, 
             int **BINDEX) {
   int flag;
+
+  start_timer(para, PHASE_BC);
   switch(var_type) {
     case VX:
       flag = set_bnd_vel(para, var, VX, psi, BINDEX); 
@@ -78,6 +80,7 @@ int set_bnd(PARA_DATA *para, REAL **var, int var_type, int index, REAL *psi,
               var_type);
       ffd_log(msg, FFD_ERROR);
   }
+  stop_timer(para, PHASE_BC);
 
   return flag;
 } // End of set_bnd() 
@@ -251,7 +254,9 @@ int set_bnd_temp(PARA_DATA *para, REAL **var, int var_type, REAL *psi,
   int index=para->geom->index;
   int imax = para->geom->imax, jmax = para->geom->jmax;
   int kmax = para->geom->kmax;
-  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2), JMAX = jmax+2;
+  METRIC_DATA *metric = para->geom->metric;
+  REAL *lx = metric->lx, *ly = metric->ly, *lz = metric->lz;
   REAL *aw = var[AW], *ae = var[AE], *as = var[AS], *an = var[AN];
   REAL *af = var[AF], *ab = var[AB], *b=var[B], 
        *qflux = var[QFLUX], *qfluxbc = var[QFLUXBC];
@@ -269,9 +274,9 @@ int set_bnd_temp(PARA_DATA *para, REAL **var, int var_type, REAL *psi,
     j = BINDEX[1][it];
     k = BINDEX[2][it];
     
-    axy = area_xy(para, var, i, j, k);
-    ayz = area_yz(para, var, i, j, k);
-    azx = area_zx(para, var, i, j, k);
+    axy = metric->axy[i+IMAX*j];
+    ayz = metric->ayz[j+JMAX*k];
+    azx = metric->azx[i+IMAX*k];
 
     /*-------------------------------------------------------------------------
     | Inlet boundary
@@ -292,7 +297,7 @@ int set_bnd_temp(PARA_DATA *para, REAL **var, int var_type, REAL *psi,
         // West boundary wall and eastern neighbor cell is fluid
         if(i==0) { 
           if(flagp[IX(i+1,j,k)]==FLUID) {
-            D = 0.5 * length_x(para,var,i+1,j,k);
+            D = 0.5 * lx[i+1];
             h = h_coef(para,var,i+1,j,k,D);
             aw[IX(i+1,j,k)] = h * rhoCp_1 * ayz;
             qflux[IX(i,j,k)] = h * (psi[IX(i+1,j,k)]-psi[IX(i,j,k)]);
@@ -301,7 +306,7 @@ int set_bnd_temp(PARA_DATA *para, REAL **var, int var_type, REAL *psi,
         // East boundary wall and western neigbor cell is fluid
         else if(i==imax+1) {
           if(flagp[IX(i-1,j,k)]==FLUID) {
-            D = 0.5 * length_x(para,var,i-1,j,k);
+            D = 0.5 * lx[i-1];
             h = h_coef(para,var,i-1,j,k,D);
             ae[IX(i-1,j,k)] = h * rhoCp_1 * ayz;
             qflux[IX(i,j,k)] = h * (psi[IX(i-1,j,k)]-psi[IX(i,j,k)]);
@@ -311,14 +316,14 @@ int set_bnd_temp(PARA_DATA *para, REAL **var, int var_type, REAL *psi,
         else {
           // Eastern neighbor cell is fluid
           if(flagp[IX(i+1,j,k)]==FLUID) {
-            D = 0.5 * length_x(para,var,i+1,j,k);
+            D = 0.5 * lx[i+1];
             h = h_coef(para,var,i+1,j,k,D);
             aw[IX(i+1,j,k)] = h * rhoCp_1 * ayz;
             qflux[IX(i,j,k)] = h * (psi[IX(i+1,j,k)]-psi[IX(i,j,k)]);
           }
           // Western neigbor cell is fluid
           if(flagp[IX(i-1,j,k)]==FLUID) {
-            D = 0.5 * length_x(para,var,i-1,j,k);
+            D = 0.5 * lx[i-1];
             h = h_coef(para,var,i-1,j,k,D);
             ae[IX(i-1,j,k)] = h * rhoCp_1 * ayz;
             qflux[IX(i,j,k)] = h * (psi[IX(i-1,j,k)]-psi[IX(i,j,k)]);
@@ -327,7 +332,7 @@ int set_bnd_temp(PARA_DATA *para, REAL **var, int var_type, REAL *psi,
         // South wall boundary and northern neighbor is fluid
         if(j==0) {
           if(flagp[IX(i,j+1,k)]==FLUID) {
-            D = 0.5 * length_y(para,var,i,j+1,k);
+            D = 0.5 * ly[j+1];
             h = h_coef(para,var,i,j+1,k,D);
             as[IX(i,j+1,k)] = h * rhoCp_1 * azx;
             qflux[IX(i,j,k)] = h * (psi[IX(i,j+1,k)]-psi[IX(i,j,k)]);
@@ -336,7 +341,7 @@ int set_bnd_temp(PARA_DATA *para, REAL **var, int var_type, REAL *psi,
         // North wall boundary and southern neighbor is fluid
         else if(j==jmax+1) {
           if(flagp[IX(i,j-1,k)]==FLUID) {
-            D = 0.5 * length_y(para,var,i,j-1,k);
+            D = 0.5 * ly[j-1];
             h = h_coef(para,var,i,j-1,k,D);
             an[IX(i,j-1,k)] = h * rhoCp_1 * azx;
             qflux[IX(i,j,k)] = h * (psi[IX(i,j-1,k)]-psi[IX(i,j,k)]);
@@ -346,14 +351,14 @@ int set_bnd_temp(PARA_DATA *para, REAL **var, int var_type, REAL *psi,
         else {
           // Southern neighbor is fluid
           if(flagp[IX(i,j-1,k)]==FLUID) {
-            D = 0.5 * length_y(para,var,i,j-1,k);
+            D = 0.5 * ly[j-1];
             h = h_coef(para,var,i,j-1,k,D);
             an[IX(i,j-1,k)] = h * rhoCp_1 * azx;
             qflux[IX(i,j,k)] = h * (psi[IX(i,j-1,k)]-psi[IX(i,j,k)]);
           }
           // Northern neighbor is fluid
           if(flagp[IX(i,j+1,k)]==FLUID) {
-            D = 0.5 * length_y(para,var,i,j+1,k);
+            D = 0.5 * ly[j+1];
             h = h_coef(para,var,i,j+1,k,D);
             as[IX(i,j+1,k)] = h * rhoCp_1 * azx;
             qflux[IX(i,j,k)] = h * (psi[IX(i,j+1,k)]-psi[IX(i,j,k)]);
@@ -362,7 +367,7 @@ int set_bnd_temp(PARA_DATA *para, REAL **var, int var_type, REAL *psi,
         // Floor and ceiling neighbor is fluid
         if(k==0) {
           if(flagp[IX(i,j,k+1)]==FLUID) {
-            D = 0.5 * length_z(para,var,i,j,k+1);
+            D = 0.5 * lz[k+1];
             h = h_coef(para,var,i,j,k+1,D);
             ab[IX(i,j,k+1)] = h * rhoCp_1 * axy;
             qflux[IX(i,j,k)] = h * (psi[IX(i,j,k+1)]-psi[IX(i,j,k)]);
@@ -371,7 +376,7 @@ int set_bnd_temp(PARA_DATA *para, REAL **var, int var_type, REAL *psi,
         // Ceilling and floor neighbor is fluid
         else if(k==kmax+1) {
           if(flagp[IX(i,j,k-1)]==FLUID) {
-            D = 0.5 * length_z(para,var,i,j,k-1);
+            D = 0.5 * lz[k-1];
             h = h_coef(para,var,i,j,k-1,D);
             af[IX(i,j,k-1)] = h * rhoCp_1 * axy; 
             qflux[IX(i,j,k)] = h * (psi[IX(i,j,k-1)]-psi[IX(i,j,k)]);
@@ -381,14 +386,14 @@ int set_bnd_temp(PARA_DATA *para, REAL **var, int var_type, REAL *psi,
         else {
           // Ceiling neighbor is fluid
           if(flagp[IX(i,j,k+1)]==FLUID) {
-            D = 0.5 * length_z(para,var,i,j,k+1);
+            D = 0.5 * lz[k+1];
             h = h_coef(para,var,i,j,k+1,D);
             ab[IX(i,j,k+1)] = h * rhoCp_1 * axy;
             qflux[IX(i,j,k)] = h * (psi[IX(i,j,k+1)]-psi[IX(i,j,k)]);
           }
           // Floor neighbor is fluid
           if(flagp[IX(i,j,k-1)]==FLUID) {
-            D = 0.5 * length_z(para,var,i,j,k-1);
+            D = 0.5 * lz[k-1];
             h = h_coef(para,var,i,j,k-1,D);
             af[IX(i,j,k-1)] = h * rhoCp_1 * axy;
             qflux[IX(i,j,k)] = h * (psi[IX(i,j,k-1)]-psi[IX(i,j,k)]);
@@ -403,7 +408,7 @@ int set_bnd_temp(PARA_DATA *para, REAL **var, int var_type, REAL *psi,
         if(i==0) {
           if(flagp[IX(i+1,j,k)]==FLUID) {
             aw[IX(i+1,j,k)] = 0;
-            D = 0.5 * length_z(para,var,i+1,j,k);
+            D = 0.5 * lz[k];
             h = h_coef(para,var,i+1,j,k,D);
             b[IX(i+1,j,k)] += rhoCp_1 * qfluxbc[IX(i,j,k)] * ayz;
             // get the temperature of solid surface
@@ -414,7 +419,7 @@ int set_bnd_temp(PARA_DATA *para, REAL **var, int var_type, REAL *psi,
         else if(i==imax+1) {
           if(flagp[IX(i-1,j,k)]==FLUID) { 
             ae[IX(i-1,j,k)] = 0;
-            D = 0.5 * length_z(para,var,i-1,j,k);
+            D = 0.5 * lz[k];
             h = h_coef(para,var,i-1,j,k,D);
             b[IX(i-1,j,k)] += rhoCp_1 * qfluxbc[IX(i,j,k)] * ayz;
             // get the temperature of solid surface
@@ -426,7 +431,7 @@ int set_bnd_temp(PARA_DATA *para, REAL **var, int var_type, REAL *psi,
           // Eastern neighbor is fluid
           if(flagp[IX(i+1,j,k)]==FLUID) {
             aw[IX(i+1,j,k)] = 0; 
-            D = 0.5 * length_z(para,var,i+1,j,k);
+            D = 0.5 * lz[k];
             h = h_coef(para,var,i+1,j,k,D);
             b[IX(i+1,j,k)] += rhoCp_1 * qfluxbc[IX(i,j,k)] * ayz;
             // get the temperature of solid surface
@@ -435,7 +440,7 @@ int set_bnd_temp(PARA_DATA *para, REAL **var, int var_type, REAL *psi,
           // Western neighbor is fluid
           if(flagp[IX(i-1,j,k)]==FLUID) {
             ae[IX(i-1,j,k)] = 0;
-            D = 0.5 * length_z(para,var,i-1,j,k);
+            D = 0.5 * lz[k];
             h = h_coef(para,var,i-1,j,k,D);
             b[IX(i-1,j,k)] += rhoCp_1 * qfluxbc[IX(i,j,k)] * ayz;
             // get the temperature of solid surface
@@ -446,7 +451,7 @@ int set_bnd_temp(PARA_DATA *para, REAL **var, int var_type, REAL *psi,
         if(j==0) {
           if(flagp[IX(i,j+1,k)]==FLUID) {
             as[IX(i,j+1,k)] = 0;
-            D = 0.5 * length_z(para,var,i,j+1,k);
+            D = 0.5 * lz[k];
             h = h_coef(para,var,i,j+1,k,D);
             b[IX(i,j+1,k)] += rhoCp_1 * qfluxbc[IX(i,j,k)] * azx;
             // get the temperature of solid surface
@@ -457,7 +462,7 @@ int set_bnd_temp(PARA_DATA *para, REAL **var, int var_type, REAL *psi,
         else if(j==jmax+1) {
           if(flagp[IX(i,j-1,k)]==FLUID) { 
             an[IX(i,j-1,k)] = 0;
-            D = 0.5 * length_z(para,var,i,j-1,k);
+            D = 0.5 * lz[k];
             h = h_coef(para,var,i,j-1,k,D);
             b[IX(i,j-1,k)] += rhoCp_1 * qfluxbc[IX(i,j,k)] * azx;
             // get the temperature of solid surface
@@ -469,7 +474,7 @@ int set_bnd_temp(PARA_DATA *para, REAL **var, int var_type, REAL *psi,
           // Southern neighbor is fluid
           if(flagp[IX(i,j-1,k)]==FLUID) { 
             an[IX(i,j-1,k)] = 0;
-            D = 0.5 * length_z(para,var,i,j-1,k);
+            D = 0.5 * lz[k];
             h = h_coef(para,var,i,j-1,k,D);
             b[IX(i,j-1,k)] += rhoCp_1 * qfluxbc[IX(i,j,k)] * azx;
             // get the temperature of solid surface
@@ -478,7 +483,7 @@ int set_bnd_temp(PARA_DATA *para, REAL **var, int var_type, REAL *psi,
           // Northern neighbor is fluid
           if(flagp[IX(i,j+1,k)]==FLUID) { 
             as[IX(i,j+1,k)] = 0;
-            D = 0.5 * length_z(para,var,i,j+1,k);
+            D = 0.5 * lz[k];
             h = h_coef(para,var,i,j+1,k,D);
             b[IX(i,j+1,k)] += rhoCp_1 * qfluxbc[IX(i,j,k)] * azx;
             // get the temperature of solid surface
@@ -489,7 +494,7 @@ int set_bnd_temp(PARA_DATA *para, REAL **var, int var_type, REAL *psi,
         if(k==0) {
           if(flagp[IX(i,j,k+1)]==FLUID) { 
             ab[IX(i,j,k+1)] = 0;
-            D = 0.5 * length_z(para,var,i,j,k+1);
+            D = 0.5 * lz[k+1];
             h = h_coef(para,var,i,j,k+1,D);
             b[IX(i,j,k+1)] += rhoCp_1 * qfluxbc[IX(i,j,k)] * axy;
             // Get the temperature on the solid surface
@@ -500,7 +505,7 @@ int set_bnd_temp(PARA_DATA *para, REAL **var, int var_type, REAL *psi,
         else if(k==kmax+1) {
           if(flagp[IX(i,j,k-1)]==FLUID) { 
             af[IX(i,j,k-1)] = 0;
-            D = 0.5 * length_z(para,var,i,j,k-1);
+            D = 0.5 * lz[k-1];
             h = h_coef(para,var,i,j,k-1,D);
             b[IX(i,j,k-1)] += rhoCp_1 * qfluxbc[IX(i,j,k)] * axy;
             // Get the temperature on the solid surface
@@ -512,7 +517,7 @@ int set_bnd_temp(PARA_DATA *para, REAL **var, int var_type, REAL *psi,
           // Ceiling neighbor is fluid
           if(flagp[IX(i,j,k+1)]==FLUID) { 
             ab[IX(i,j,k+1)] = 0;
-            D = 0.5 * length_z(para,var,i,j,k+1);
+            D = 0.5 * lz[k+1];
             h = h_coef(para,var,i,j,k+1,D);
             b[IX(i,j,k+1)] += rhoCp_1 * qfluxbc[IX(i,j,k)] * axy;
             // Get the temperature on the solid surface
@@ -521,7 +526,7 @@ int set_bnd_temp(PARA_DATA *para, REAL **var, int var_type, REAL *psi,
           // Floor neighbor is fluid
           if(flagp[IX(i,j,k-1)]==FLUID) { 
             af[IX(i,j,k-1)] = 0;
-            D = 0.5 * length_z(para,var,i,j,k-1);
+            D = 0.5 * lz[k-1];
             h = h_coef(para,var,i,j,k-1,D);
             b[IX(i,j,k-1)] += rhoCp_1 * qfluxbc[IX(i,j,k)] * axy;
             // Get the temperature on the solid surface
@@ -708,6 +713,7 @@ int set_bnd_pressure(PARA_DATA *para, REAL **var, REAL *p, int **BINDEX) {
 
   REAL *flagp = var[FLAGP];
 
+  start_timer(para, PHASE_BC);
   for(it=0;it<index;it++) {
     i = BINDEX[0][it];
     j = BINDEX[1][it];
@@ -759,6 +765,7 @@ int set_bnd_pressure(PARA_DATA *para, REAL **var, REAL *p, int **BINDEX) {
       } 
     }
   }
+  stop_timer(para, PHASE_BC);
 
   return 0;
 } // End of set_bnd_pressure()
@@ -831,7 +838,8 @@ REAL adjust_velocity(PARA_DATA *para, REAL **var, int **BINDEX) {
   int imax = para->geom->imax, jmax = para->geom->jmax;
   int kmax = para->geom->kmax;
   int index= para->geom->index;
-  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2), JMAX = jmax+2;
+  METRIC_DATA *metric = para->geom->metric;
   REAL *u = var[VX], *v = var[VY], *w = var[VZ];
   REAL mass_in = (REAL) 0.0, mass_out = (REAL) 0.00000001;
   REAL area_out=0;
@@ -844,9 +852,9 @@ REAL adjust_velocity(PARA_DATA *para, REAL **var, int **BINDEX) {
     j = BINDEX[1][it];
     k = BINDEX[2][it];
 
-    axy = area_xy(para, var, i, j, k);
-    ayz = area_yz(para, var, i, j, k);
-    azx = area_zx(para, var, i, j, k);
+    axy = metric->axy[i+IMAX*j];
+    ayz = metric->ayz[j+JMAX*k];
+    azx = metric->azx[i+IMAX*k];
     /*-------------------------------------------------------------------------
     | Compute the total inflow
     -------------------------------------------------------------------------*/
@@ -39,6 +39,11 @@
 #include "utility.h"
 #endif
 
+#ifndef _TIMING_H
+#define _TIMING_H
+#include "timing.h"
+#endif
+
 #ifndef _CHEN_ZERO_EQU_MODEL_H
 #define _CHEN_ZERO_EQU_MODEL_H
 #include "chen_zero_equ_model.h"
@@ -0,0 +1,456 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// \file   checkpoint.c
+///
+/// \brief  Write and read the binary checkpoint file for restarts
+///
+/// \author agent
+///         agent@local
+///
+/// \date   10/17/2026
+///
+/// The checkpoint file stores the complete state of a simulation: all the
+/// variables in var, including the time averaged ones, the time and step
+/// counters of mytime, the time averaged accumulators and the values of the
+/// boundaries and sensors. The values are written in the binary format of
+/// the machine, so that a restart with a fixed time step continues bit by
+/// bit as if the simulation had not been interrupted. An adaptive time step
+/// starts again from the time step size of the input. The variables start
+/// at a page aligned offset and are copied out of a memory mapping of the
+/// file when it is read.
+///
+///////////////////////////////////////////////////////////////////////////////
+
+#include "checkpoint.h"
+
+#ifndef _MSC_VER
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
+
+#define CKP_MAGIC "FFDCKP" // Magic at the start of the checkpoint file
+#define CKP_VERSION 1 // Version of the checkpoint file format
+#define CKP_BYTE_ORDER 0x01020304 // Detects files of a different byte order
+#define CKP_ALIGN 4096 // Alignment of the variables in the file
+
+///////////////////////////////////////////////////////////////////////////////
+/// Write the binary checkpoint file
+///
+/// The file is first written as name.ckp.tmp and then renamed, so that an
+/// interrupted run does not destroy the previous checkpoint. The variables
+/// are written without the padding of the memory arena.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param name Pointer to file name without the extension .ckp
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int write_checkpoint(PARA_DATA *para, REAL **var, char *name) {
+  int size = (para->geom->imax+2)*(para->geom->jmax+2)*(para->geom->kmax+2);
+  int i, flag = 0;
+  long long offset;
+  char *filename, *tmpname;
+  char zero[CKP_ALIGN];
+  CHECKPOINT_HEADER head;
+  REAL *buf;
+  FILE *datafile;
+
+  filename = (char *) malloc((strlen(name)+5)*sizeof(char));
+  tmpname = (char *) malloc((strlen(name)+9)*sizeof(char));
+  if(filename==NULL || tmpname==NULL) {
+    ffd_log("write_checkpoint(): Failed to allocate memory for file name",
+            FFD_ERROR);
+    free(filename);
+    free(tmpname);
+    return 1;
+  }
+  strcpy(filename, name);
+  strcat(filename, ".ckp");
+  strcpy(tmpname, filename);
+  strcat(tmpname, ".tmp");
+
+  set_checkpoint_header(para, &head);
+
+  /****************************************************************************
+  | Collect the boundary and sensor values
+  ****************************************************************************/
+  buf = (REAL *) calloc(head.nb_bc_value+1, sizeof(REAL));
+  if(buf==NULL) {
+    ffd_log("write_checkpoint(): Failed to allocate memory for the "
+            "boundary values", FFD_ERROR);
+    free(filename);
+    free(tmpname);
+    return 1;
+  }
+  checkpoint_bc(para, buf, 1);
+
+  if((datafile=fopen(tmpname, "wb"))==NULL) {
+    sprintf(msg, "write_checkpoint(): Failed to open file %s.", tmpname);
+    ffd_log(msg, FFD_ERROR);
+    free(buf);
+    free(filename);
+    free(tmpname);
+    return 1;
+  }
+
+  /****************************************************************************
+  | Write the header, the boundary values and the variables
+  ****************************************************************************/
+  memset(zero, 0, CKP_ALIGN);
+  offset = sizeof(CHECKPOINT_HEADER) + head.nb_bc_value*sizeof(REAL);
+
+  if(fwrite(&head, sizeof(CHECKPOINT_HEADER), 1, datafile)!=1
+     || fwrite(buf, sizeof(REAL), head.nb_bc_value, datafile)
+        !=(size_t) head.nb_bc_value
+     || fwrite(zero, 1, (size_t) (head.var_offset-offset), datafile)
+        !=(size_t) (head.var_offset-offset))
+    flag = 1;
+
+  for(i=0; i<head.nb_var && flag==0; i++)
+    if(fwrite(var[i], sizeof(REAL), size, datafile)!=(size_t) size)
+      flag = 1;
+
+  if(fclose(datafile)!=0) flag = 1;
+  free(buf);
+
+  if(flag!=0) {
+    sprintf(msg, "write_checkpoint(): Failed to write file %s.", tmpname);
+    ffd_log(msg, FFD_ERROR);
+    remove(tmpname);
+    free(filename);
+    free(tmpname);
+    return 1;
+  }
+
+  /****************************************************************************
+  | Replace the previous checkpoint
+  ****************************************************************************/
+#ifdef _MSC_VER
+  remove(filename);
+#endif
+  if(rename(tmpname, filename)!=0) {
+    sprintf(msg, "write_checkpoint(): Failed to rename %s to %s.",
+            tmpname, filename);
+    ffd_log(msg, FFD_ERROR);
+    free(filename);
+    free(tmpname);
+    return 1;
+  }
+
+  sprintf(msg, "write_checkpoint(): Wrote file %s at t=%f[s], step %d.",
+          filename, para->mytime->t, para->mytime->step_current);
+  ffd_log(msg, FFD_NORMAL);
+
+  free(filename);
+  free(tmpname);
+  return 0;
+} // End of write_checkpoint()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Read the binary checkpoint file
+///
+/// The file must have been written for the same grid and the same number of
+/// variables, boundaries and sensors. The parameters of mytime which are
+/// not counters, such as dt, step_total or the settings of the adaptive time
+/// step, are taken from the input file of the restart. A warning is logged
+/// if the fixed time step size differs from the one of the checkpoint.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param name Pointer to the file name
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int read_checkpoint(PARA_DATA *para, REAL **var, char *name) {
+  int size = (para->geom->imax+2)*(para->geom->jmax+2)*(para->geom->kmax+2);
+  int i;
+  long long file_size;
+  char *data;
+  CHECKPOINT_HEADER head, *file_head;
+
+  data = (char *) map_checkpoint(name, &file_size);
+  if(data==NULL) {
+    sprintf(msg, "read_checkpoint(): Can not open %s.", name);
+    ffd_log(msg, FFD_ERROR);
+    return 1;
+  }
+
+  /****************************************************************************
+  | Check that the file fits to the current simulation
+  ****************************************************************************/
+  set_checkpoint_header(para, &head);
+  file_head = (CHECKPOINT_HEADER *) data;
+
+  if(file_size<(long long) sizeof(CHECKPOINT_HEADER)
+     || memcmp(file_head->magic, head.magic, sizeof(head.magic))!=0) {
+    sprintf(msg, "read_checkpoint(): %s is not a checkpoint file.", name);
+    ffd_log(msg, FFD_ERROR);
+    unmap_checkpoint(data, file_size);
+    return 1;
+  }
+  if(file_head->version!=head.version
+     || file_head->byte_order!=head.byte_order
+     || file_head->size_real!=head.size_real) {
+    sprintf(msg, "read_checkpoint(): %s was written with version %d, "
+            "byte order %x and %d bytes per value instead of %d, %x and %d.",
+            name, file_head->version, file_head->byte_order,
+            file_head->size_real, head.version, head.byte_order,
+            head.size_real);
+    ffd_log(msg, FFD_ERROR);
+    unmap_checkpoint(data, file_size);
+    return 1;
+  }
+  if(file_head->imax!=head.imax || file_head->jmax!=head.jmax
+     || file_head->kmax!=head.kmax || file_head->nb_var!=head.nb_var
+     || file_head->nb_wall!=head.nb_wall || file_head->nb_port!=head.nb_port
+     || file_head->nb_Xi!=head.nb_Xi || file_head->nb_C!=head.nb_C
+     || file_head->nb_sensor!=head.nb_sensor
+     || file_head->nb_bc_value!=head.nb_bc_value) {
+    sprintf(msg, "read_checkpoint(): %s was written for a different case "
+            "with %dx%dx%d cells and %d variables.", name, file_head->imax,
+            file_head->jmax, file_head->kmax, file_head->nb_var);
+    ffd_log(msg, FFD_ERROR);
+    unmap_checkpoint(data, file_size);
+    return 1;
+  }
+  if(file_size<file_head->var_offset
+               + (long long) (head.nb_var*size*sizeof(REAL))) {
+    sprintf(msg, "read_checkpoint(): %s is truncated.", name);
+    ffd_log(msg, FFD_ERROR);
+    unmap_checkpoint(data, file_size);
+    return 1;
+  }
+
+  /****************************************************************************
+  | Restore the counters, the boundary values and the variables
+  ****************************************************************************/
+  // The time step size of the input is kept, since it defines the end of
+  // the simulation
+  if(para->mytime->adaptive==0 && file_head->dt!=para->mytime->dt) {
+    sprintf(msg, "read_checkpoint(): %s was written with dt=%f[s], the "
+            "simulation continues with dt=%f[s].", name, file_head->dt,
+            para->mytime->dt);
+    ffd_log(msg, FFD_WARNING);
+  }
+  para->mytime->t = file_head->t;
+  para->mytime->step_current = file_head->step_current;
+  para->mytime->step_mean = file_head->step_mean;
+  para->mytime->w_mean = file_head->w_mean;
+
+  checkpoint_bc(para, (REAL *) (data + sizeof(CHECKPOINT_HEADER)), 0);
+
+#pragma omp parallel for schedule(static)
+  for(i=0; i<head.nb_var; i++)
+    memcpy(var[i],
+           data + file_head->var_offset + (long long) i*size*sizeof(REAL),
+           size*sizeof(REAL));
+
+  unmap_checkpoint(data, file_size);
+
+  sprintf(msg, "read_checkpoint(): Restarted from %s at t=%f[s], step %d.",
+          name, para->mytime->t, para->mytime->step_current);
+  ffd_log(msg, FFD_NORMAL);
+  return 0;
+} // End of read_checkpoint()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Check if a file is a binary checkpoint file
+///
+///\param name Pointer to the file name
+///
+///\return 1 if the file starts with the magic of the checkpoint file
+///////////////////////////////////////////////////////////////////////////////
+int is_checkpoint(char *name) {
+  char magic[8];
+  FILE *datafile;
+  int flag;
+
+  if((datafile=fopen(name, "rb"))==NULL) return 0;
+  flag = fread(magic, 1, 8, datafile)==8 && memcmp(magic, CKP_MAGIC, 7)==0;
+  fclose(datafile);
+
+  return flag;
+} // End of is_checkpoint()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Fill in the header of the checkpoint file for the current simulation
+///
+///\param para Pointer to FFD parameters
+///\param head Pointer to the header
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void set_checkpoint_header(PARA_DATA *para, CHECKPOINT_HEADER *head) {
+  memset(head, 0, sizeof(CHECKPOINT_HEADER));
+  memcpy(head->magic, CKP_MAGIC, 7);
+  head->version = CKP_VERSION;
+  head->byte_order = CKP_BYTE_ORDER;
+  head->size_real = sizeof(REAL);
+  head->imax = para->geom->imax;
+  head->jmax = para->geom->jmax;
+  head->kmax = para->geom->kmax;
+  head->nb_var = NB_VAR(para);
+  head->nb_wall = para->bc->nb_wall;
+  head->nb_port = para->bc->nb_port;
+  head->nb_Xi = para->bc->nb_Xi;
+  head->nb_C = para->bc->nb_C;
+  head->nb_sensor = para->sens->nb_sensor;
+  head->nb_bc_value = checkpoint_bc(para, NULL, 1);
+  head->step_current = para->mytime->step_current;
+  head->step_mean = para->mytime->step_mean;
+  head->t = para->mytime->t;
+  head->dt = para->mytime->dt;
+  head->w_mean = para->mytime->w_mean;
+  head->var_offset = (sizeof(CHECKPOINT_HEADER)
+                      + head->nb_bc_value*sizeof(REAL) + CKP_ALIGN-1)
+                   / CKP_ALIGN * CKP_ALIGN;
+} // End of set_checkpoint_header()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Copy the boundary and sensor values to or from a buffer
+///
+/// The values are walls (temHea, temHeaAve, temHeaMean), ports (velPort,
+/// velPortAve, velPortMean, TPort, TPortAve, TPortMean and the same for Xi
+/// and C) and sensors (senVal, senValMean, TRoo, TRooMean). Arrays which
+/// are not allocated are written as zeros and skipped when reading.
+///
+///\param para Pointer to FFD parameters
+///\param buf Pointer to the buffer, NULL to count the values only
+///\param save 1: copy to the buffer; 0: copy from the buffer
+///
+///\return Number of values
+///////////////////////////////////////////////////////////////////////////////
+int checkpoint_bc(PARA_DATA *para, REAL *buf, int save) {
+  BC_DATA *bc = para->bc;
+  SENSOR_DATA *sens = para->sens;
+  REAL *b = buf;
+  int n = 0, i, nb_wall = bc->nb_wall, nb_port = bc->nb_port;
+
+  n += checkpoint_copy(bc->temHea, nb_wall, b ? b+n : NULL, save);
+  n += checkpoint_copy(bc->temHeaAve, nb_wall, b ? b+n : NULL, save);
+  n += checkpoint_copy(bc->temHeaMean, nb_wall, b ? b+n : NULL, save);
+
+  n += checkpoint_copy(bc->velPort, nb_port, b ? b+n : NULL, save);
+  n += checkpoint_copy(bc->velPortAve, nb_port, b ? b+n : NULL, save);
+  n += checkpoint_copy(bc->velPortMean, nb_port, b ? b+n : NULL, save);
+  n += checkpoint_copy(bc->TPort, nb_port, b ? b+n : NULL, save);
+  n += checkpoint_copy(bc->TPortAve, nb_port, b ? b+n : NULL, save);
+  n += checkpoint_copy(bc->TPortMean, nb_port, b ? b+n : NULL, save);
+
+  for(i=0; i<nb_port; i++) {
+    n += checkpoint_copy(bc->XiPort ? bc->XiPort[i] : NULL, bc->nb_Xi,
+                         b ? b+n : NULL, save);
+    n += checkpoint_copy(bc->XiPortAve ? bc->XiPortAve[i] : NULL, bc->nb_Xi,
+                         b ? b+n : NULL, save);
+    n += checkpoint_copy(bc->XiPortMean ? bc->XiPortMean[i] : NULL,
+                         bc->nb_Xi, b ? b+n : NULL, save);
+    n += checkpoint_copy(bc->CPort ? bc->CPort[i] : NULL, bc->nb_C,
+                         b ? b+n : NULL, save);
+    n += checkpoint_copy(bc->CPortAve ? bc->CPortAve[i] : NULL, bc->nb_C,
+                         b ? b+n : NULL, save);
+    n += checkpoint_copy(bc->CPortMean ? bc->CPortMean[i] : NULL, bc->nb_C,
+                         b ? b+n : NULL, save);
+  }
+
+  n += checkpoint_copy(sens->senVal, sens->nb_sensor, b ? b+n : NULL, save);
+  n += checkpoint_copy(sens->senValMean, sens->nb_sensor, b ? b+n : NULL,
+                       save);
+  n += checkpoint_copy(&sens->TRoo, 1, b ? b+n : NULL, save);
+  n += checkpoint_copy(&sens->TRooMean, 1, b ? b+n : NULL, save);
+
+  return n;
+} // End of checkpoint_bc()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Copy an array of boundary values to or from a buffer
+///
+///\param psi Pointer to the array, may be NULL
+///\param n Number of values
+///\param buf Pointer to the buffer, NULL to count the values only
+///\param save 1: copy to the buffer; 0: copy from the buffer
+///
+///\return Number of values
+///////////////////////////////////////////////////////////////////////////////
+int checkpoint_copy(REAL *psi, int n, REAL *buf, int save) {
+  if(buf==NULL || n<=0) return n>0 ? n : 0;
+
+  if(save==1) {
+    if(psi!=NULL) memcpy(buf, psi, n*sizeof(REAL));
+    else memset(buf, 0, n*sizeof(REAL));
+  }
+  else if(psi!=NULL)
+    memcpy(psi, buf, n*sizeof(REAL));
+
+  return n;
+} // End of checkpoint_copy()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Map a file into the memory for reading
+///
+/// The handles of the file are closed at once since the mapping keeps its
+/// own reference to the file.
+///
+///\param name Pointer to the file name
+///\param size Pointer to the size of the file in bytes
+///
+///\return Pointer to the mapped file, NULL if an error occurred
+///////////////////////////////////////////////////////////////////////////////
+void *map_checkpoint(char *name, long long *size) {
+  void *data = NULL;
+#ifdef _MSC_VER
+  HANDLE file, map;
+  LARGE_INTEGER file_size;
+
+  file = CreateFileA(name, GENERIC_READ, FILE_SHARE_READ, NULL,
+                     OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+  if(file==INVALID_HANDLE_VALUE) return NULL;
+  if(!GetFileSizeEx(file, &file_size) || file_size.QuadPart==0) {
+    CloseHandle(file);
+    return NULL;
+  }
+  map = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if(map!=NULL) {
+    data = MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(map);
+  }
+  CloseHandle(file);
+  *size = file_size.QuadPart;
+#else
+  int fd, flags = MAP_PRIVATE;
+  struct stat st;
+
+  if((fd=open(name, O_RDONLY))<0) return NULL;
+  if(fstat(fd, &st)!=0 || st.st_size==0) {
+    close(fd);
+    return NULL;
+  }
+#ifdef MAP_POPULATE
+  // Read the whole file at once instead of page by page
+  flags |= MAP_POPULATE;
+#endif
+  data = mmap(NULL, (size_t) st.st_size, PROT_READ, flags, fd, 0);
+  close(fd);
+  if(data==MAP_FAILED) return NULL;
+  *size = (long long) st.st_size;
+#endif
+
+  return data;
+} // End of map_checkpoint()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Unmap a file mapped by map_checkpoint()
+///
+///\param data Pointer to the mapped file
+///\param size Size of the file in bytes
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void unmap_checkpoint(void *data, long long size) {
+#ifdef _MSC_VER
+  UnmapViewOfFile(data);
+#else
+  munmap(data, (size_t) size);
+#endif
+} // End of unmap_checkpoint()
@@ -0,0 +1,134 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// \file   checkpoint.h
+///
+/// \brief  Write and read the binary checkpoint file for restarts
+///
+/// \author agent
+///         agent@local
+///
+/// \date   10/17/2026
+///
+/// The checkpoint file stores the complete state of a simulation: all the
+/// variables in var, including the time averaged ones, the time and step
+/// counters of mytime, the time averaged accumulators and the values of the
+/// boundaries and sensors. The values are written in the binary format of
+/// the machine, so that a restart with a fixed time step continues bit by
+/// bit as if the simulation had not been interrupted. An adaptive time step
+/// starts again from the time step size of the input. The variables start
+/// at a page aligned offset and are copied out of a memory mapping of the
+/// file when it is read.
+///
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef _CHECKPOINT_H
+#define _CHECKPOINT_H
+#endif
+
+#ifndef _DATA_STRUCTURE_H
+#define _DATA_STRUCTURE_H
+#include "data_structure.h"
+#endif
+
+#ifndef _UTILITY_H
+#define _UTILITY_H
+#include "utility.h"
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+/// Write the binary checkpoint file
+///
+/// The file is first written as name.ckp.tmp and then renamed, so that an
+/// interrupted run does not destroy the previous checkpoint.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param name Pointer to file name without the extension .ckp
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int write_checkpoint(PARA_DATA *para, REAL **var, char *name);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Read the binary checkpoint file
+///
+/// The file must have been written for the same grid and the same number of
+/// variables, boundaries and sensors. The parameters of mytime which are
+/// not counters, such as dt, step_total or the settings of the adaptive time
+/// step, are taken from the input file of the restart. A warning is logged
+/// if the fixed time step size differs from the one of the checkpoint.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param name Pointer to the file name
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int read_checkpoint(PARA_DATA *para, REAL **var, char *name);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Check if a file is a binary checkpoint file
+///
+///\param name Pointer to the file name
+///
+///\return 1 if the file starts with the magic of the checkpoint file
+///////////////////////////////////////////////////////////////////////////////
+int is_checkpoint(char *name);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Fill in the header of the checkpoint file for the current simulation
+///
+///\param para Pointer to FFD parameters
+///\param head Pointer to the header
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void set_checkpoint_header(PARA_DATA *para, CHECKPOINT_HEADER *head);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Copy the boundary and sensor values to or from a buffer
+///
+/// The values are walls (temHea, temHeaAve, temHeaMean), ports (velPort,
+/// velPortAve, velPortMean, TPort, TPortAve, TPortMean and the same for Xi
+/// and C) and sensors (senVal, senValMean, TRoo, TRooMean). Arrays which
+/// are not allocated are written as zeros and skipped when reading.
+///
+///\param para Pointer to FFD parameters
+///\param buf Pointer to the buffer, NULL to count the values only
+///\param save 1: copy to the buffer; 0: copy from the buffer
+///
+///\return Number of values
+///////////////////////////////////////////////////////////////////////////////
+int checkpoint_bc(PARA_DATA *para, REAL *buf, int save);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Copy an array of boundary values to or from a buffer
+///
+///\param psi Pointer to the array, may be NULL
+///\param n Number of values
+///\param buf Pointer to the buffer, NULL to count the values only
+///\param save 1: copy to the buffer; 0: copy from the buffer
+///
+///\return Number of values
+///////////////////////////////////////////////////////////////////////////////
+int checkpoint_copy(REAL *psi, int n, REAL *buf, int save);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Map a file into the memory for reading
+///
+///\param name Pointer to the file name
+///\param size Pointer to the size of the file in bytes
+///
+///\return Pointer to the mapped file, NULL if an error occurred
+///////////////////////////////////////////////////////////////////////////////
+void *map_checkpoint(char *name, long long *size);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Unmap a file mapped by map_checkpoint()
+///
+///\param data Pointer to the mapped file
+///\param size Size of the file in bytes
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void unmap_checkpoint(void *data, long long size);
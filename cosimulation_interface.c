@@ -188,6 +188,9 @@ int read_cosim_parameter(PARA_DATA *para, REAL **var, int **BINDEX) {
 ///////////////////////////////////////////////////////////////////////////////
 /// Read the data from Modelica
 ///
+/// If solv.cosim_lag is 1, FFD does not wait for the data of the current
+/// synchronization but uses the data extrapolated by receive_cosim_data().
+///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
 ///
@@ -195,32 +198,41 @@ int read_cosim_parameter(PARA_DATA *para, REAL **var, int **BINDEX) {
 ///////////////////////////////////////////////////////////////////////////////
 int read_cosim_data(PARA_DATA *para, REAL **var, int **BINDEX) {
   int i;
+  ModelicaSharedData *modelica = para->cosim->modelica;
 
   ffd_log("-------------------------------------------------------------------",
           FFD_NORMAL);
   ffd_log("read_cosim_data(): Start to read data from Modelica.", 
           FFD_NORMAL);
   /****************************************************************************
+  | Lagged coupling: Use the data received or extrapolated by FFD
+  ****************************************************************************/
+  if(para->solv->cosim_lag==1) {
+    if(receive_cosim_data(para)!=0) {
+      ffd_log("read_cosim_data(): Could not receive the data from Modelica.",
+              FFD_ERROR);
+      return 1;
+    }
+    modelica = &para->solv->lag->guess;
+  }
+  /****************************************************************************
   | Wait for data to be updated by the other program
   ****************************************************************************/
-  while(para->cosim->modelica->flag==0) {
-    sprintf(msg, 
-            "read_cosim_data(): Data is not ready with "
-            "para->cosim->modelica->flag=%d",
-            para->cosim->modelica->flag);
-    ffd_log(msg, FFD_NORMAL);
-    Sleep(1000);
+  else if(cosim_get_flag(&para->cosim->modelica->flag)==0) {
+    ffd_log("read_cosim_data(): Data is not ready with "
+            "para->cosim->modelica->flag=0", FFD_NORMAL);
+    cosim_wait_flag(&para->cosim->modelica->flag, 0);
   }
 
   sprintf(msg, 
           "read_cosim_data(): Received the following data at t=%f[s]", 
-          para->cosim->modelica->t);
+          modelica->t);
   ffd_log(msg, FFD_NORMAL);
 
   /****************************************************************************
   | Read and assign the thermal boundary conditions
   ****************************************************************************/
-  if(assign_thermal_bc(para,var,BINDEX)!=0) {
+  if(assign_thermal_bc(para,var,BINDEX,modelica)!=0) {
      ffd_log("read_cosim_data(): Could not assign the Modelicathermal data to FFD",
             FFD_ERROR);
     return 1;
@@ -235,8 +247,7 @@ int read_cosim_data(PARA_DATA *para, REAL **var, int **BINDEX) {
             FFD_NORMAL);
     for(i=0; i<para->cosim->para->nConExtWin; i++) {
       sprintf(msg, "Surface[%d]: %f,\t%f\n",
-              i, para->cosim->modelica->shaConSig[i], 
-              para->cosim->modelica->shaAbsRad[i]);
+              i, modelica->shaConSig[i], modelica->shaAbsRad[i]);
       ffd_log(msg, FFD_NORMAL);
     }
   }
@@ -247,7 +258,7 @@ int read_cosim_data(PARA_DATA *para, REAL **var, int **BINDEX) {
   | Read and assign the inlet conditions
   ****************************************************************************/
   if(para->cosim->para->nPorts>0) {
-    if(assign_port_bc(para,var,BINDEX)!=0) {
+    if(assign_port_bc(para,var,BINDEX,modelica)!=0) {
       ffd_log(" read_cosim_data(): Could not assign the Modelica inlet BC to FFD",
       FFD_ERROR);
       return 1;
@@ -260,14 +271,246 @@ int read_cosim_data(PARA_DATA *para, REAL **var, int **BINDEX) {
   | Post-Process after reading the data
   ****************************************************************************/
   // Change the flag to indicate that the data has been read
-  para->cosim->modelica->flag = 0;
-  printf("para->cosim->modelica->flag=%d\n", para->cosim->modelica->flag);
+  if(para->solv->cosim_lag!=1)
+    cosim_set_flag(&para->cosim->modelica->flag, 0);
 
   ffd_log("read_cosim_data(): Ended reading data from Modelica.",
           FFD_NORMAL);
   return 0;
 } // End of read_cosim_data()
 
+///////////////////////////////////////////////////////////////////////////////
+/// Receive the data from Modelica for the lagged coupling
+///
+/// FFD runs at most one synchronization interval ahead of Modelica. It waits
+/// for the data of the previous synchronization, takes the data of the
+/// current one if Modelica has already sent them and extrapolates them
+/// linearly in time from the last two data sets otherwise. The data used by
+/// FFD are stored in para->solv->lag->guess.
+///
+///\param para Pointer to FFD parameters
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int receive_cosim_data(PARA_DATA *para) {
+  COSIM_LAG_DATA *lag;
+  ModelicaSharedData *a, *b;
+
+  if(para->solv->lag==NULL) {
+    if(allocate_cosim_lag_data(para)!=0) {
+      ffd_log("receive_cosim_data(): Could not allocate memory for the "
+              "lagged cosimulation.", FFD_ERROR);
+      return 1;
+    }
+  }
+  lag = para->solv->lag;
+
+  /****************************************************************************
+  | Wait for the data of the previous synchronization
+  ****************************************************************************/
+  while(lag->nb_read<lag->nb_sync || lag->nb_read==0) {
+    if(cosim_get_flag(&para->cosim->modelica->flag)==0) {
+      ffd_log("receive_cosim_data(): Wait for the data of the previous "
+              "synchronization.", FFD_NORMAL);
+      cosim_wait_flag(&para->cosim->modelica->flag, 0);
+    }
+    pull_cosim_data(para);
+  }
+
+  /****************************************************************************
+  | Take the data of the current synchronization if they are ready
+  ****************************************************************************/
+  if(lag->nb_read==lag->nb_sync
+     && cosim_get_flag(&para->cosim->modelica->flag)!=0)
+    pull_cosim_data(para);
+
+  lag->nb_sync++;
+  a = &lag->data[(lag->nb_read-1)%2];
+
+  if(lag->nb_read==lag->nb_sync || lag->nb_read==1) {
+    copy_modelica_data(para, &lag->guess, a, NULL, 0);
+    lag->guessed = lag->nb_read!=lag->nb_sync;
+  }
+  else {
+    b = &lag->data[lag->nb_read%2];
+    copy_modelica_data(para, &lag->guess, a, b, a->t+a->dt);
+    lag->guessed = 1;
+    sprintf(msg, "receive_cosim_data(): Extrapolated the data to t=%f[s].",
+            lag->guess.t);
+    ffd_log(msg, FFD_NORMAL);
+  }
+
+  return 0;
+} // End of receive_cosim_data()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Copy the data set sent by Modelica and release the shared data
+///
+/// If the data had been extrapolated, the largest deviations of the
+/// extrapolated surface and port data are reported.
+///
+///\param para Pointer to FFD parameters
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void pull_cosim_data(PARA_DATA *para) {
+  COSIM_LAG_DATA *lag = para->solv->lag;
+  ModelicaSharedData *to = &lag->data[lag->nb_read%2];
+  REAL dtemHea = 0, dmFloRat = 0;
+  int i;
+
+  copy_modelica_data(para, to, para->cosim->modelica, NULL, 0);
+  lag->nb_read++;
+  cosim_set_flag(&para->cosim->modelica->flag, 0);
+
+  // Compare with the extrapolated data of the same synchronization
+  if(lag->guessed==1 && lag->nb_read==lag->nb_sync) {
+    for(i=0; i<para->cosim->para->nSur; i++)
+      dtemHea = fmax(dtemHea, fabs(to->temHea[i]-lag->guess.temHea[i]));
+    for(i=0; i<para->cosim->para->nPorts; i++)
+      dmFloRat = fmax(dmFloRat,
+                      fabs(to->mFloRatPor[i]-lag->guess.mFloRatPor[i]));
+    sprintf(msg, "pull_cosim_data(): Data at t=%f[s] deviated from the "
+            "extrapolation by temHea=%f, mFloRatPor=%f.",
+            to->t, dtemHea, dmFloRat);
+    ffd_log(msg, FFD_NORMAL);
+    lag->guessed = 0;
+  }
+} // End of pull_cosim_data()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Copy or extrapolate a data set of Modelica
+///
+/// If b is NULL, a is copied. Otherwise the surface temperatures or heat
+/// flows, the mass flow rates and the temperatures at the ports are
+/// extrapolated linearly to the time t from the data sets a and b, where a
+/// is the newer one. The other data are copied from a.
+///
+///\param para Pointer to FFD parameters
+///\param to Pointer to the target data set
+///\param a Pointer to the newest data set
+///\param b Pointer to the older data set, NULL for a copy
+///\param t Time of the extrapolation
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void copy_modelica_data(PARA_DATA *para, ModelicaSharedData *to,
+                        ModelicaSharedData *a, ModelicaSharedData *b,
+                        float t) {
+  ParameterSharedData *cosim_para = para->cosim->para;
+  float w = 0;
+  int i, j;
+
+  if(b!=NULL && a->t>b->t)
+    w = (t-a->t) / (a->t-b->t);
+  else
+    b = a;
+
+  to->t = b==a ? a->t : t;
+  to->flag = a->flag;
+  to->dt = a->dt;
+  to->heaConvec = a->heaConvec;
+  to->latentHeat = a->latentHeat;
+  to->p = a->p;
+
+  for(i=0; i<cosim_para->nSur; i++)
+    to->temHea[i] = a->temHea[i] + w*(a->temHea[i]-b->temHea[i]);
+
+  if(cosim_para->sha==1)
+    for(i=0; i<cosim_para->nConExtWin; i++) {
+      to->shaConSig[i] = a->shaConSig[i];
+      to->shaAbsRad[i] = a->shaAbsRad[i];
+    }
+
+  for(i=0; i<cosim_para->nPorts; i++) {
+    to->mFloRatPor[i] = a->mFloRatPor[i]
+                      + w*(a->mFloRatPor[i]-b->mFloRatPor[i]);
+    to->TPor[i] = a->TPor[i] + w*(a->TPor[i]-b->TPor[i]);
+    for(j=0; j<cosim_para->nXi; j++)
+      to->XiPor[i][j] = a->XiPor[i][j];
+    for(j=0; j<cosim_para->nC; j++)
+      to->CPor[i][j] = a->CPor[i][j];
+  }
+} // End of copy_modelica_data()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Allocate memory for the Modelica data of the lagged coupling
+///
+///\param para Pointer to FFD parameters
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int allocate_cosim_lag_data(PARA_DATA *para) {
+  ParameterSharedData *cosim_para = para->cosim->para;
+  COSIM_LAG_DATA *lag;
+  ModelicaSharedData *d;
+  int n, i, flag = 0;
+
+  lag = (COSIM_LAG_DATA *) calloc(1, sizeof(COSIM_LAG_DATA));
+  if(lag==NULL) return 1;
+  para->solv->lag = lag;
+
+  for(n=0; n<3; n++) {
+    d = n<2 ? &lag->data[n] : &lag->guess;
+    d->temHea = (float *) calloc(cosim_para->nSur+1, sizeof(float));
+    d->shaConSig = (float *) calloc(cosim_para->nConExtWin+1, sizeof(float));
+    d->shaAbsRad = (float *) calloc(cosim_para->nConExtWin+1, sizeof(float));
+    d->mFloRatPor = (float *) calloc(cosim_para->nPorts+1, sizeof(float));
+    d->TPor = (float *) calloc(cosim_para->nPorts+1, sizeof(float));
+    d->XiPor = (float **) calloc(cosim_para->nPorts+1, sizeof(float *));
+    d->CPor = (float **) calloc(cosim_para->nPorts+1, sizeof(float *));
+    flag += d->temHea==NULL || d->shaConSig==NULL || d->shaAbsRad==NULL
+         || d->mFloRatPor==NULL || d->TPor==NULL || d->XiPor==NULL
+         || d->CPor==NULL;
+    if(flag!=0) break;
+
+    for(i=0; i<cosim_para->nPorts; i++) {
+      d->XiPor[i] = (float *) calloc(cosim_para->nXi+1, sizeof(float));
+      d->CPor[i] = (float *) calloc(cosim_para->nC+1, sizeof(float));
+      flag += d->XiPor[i]==NULL || d->CPor[i]==NULL;
+    }
+  }
+
+  if(flag!=0) {
+    free_cosim_lag_data(para);
+    return 1;
+  }
+
+  return 0;
+} // End of allocate_cosim_lag_data()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free memory for the Modelica data of the lagged coupling
+///
+///\param para Pointer to FFD parameters
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_cosim_lag_data(PARA_DATA *para) {
+  COSIM_LAG_DATA *lag = para->solv->lag;
+  ModelicaSharedData *d;
+  int n, i;
+
+  if(lag==NULL) return;
+
+  for(n=0; n<3; n++) {
+    d = n<2 ? &lag->data[n] : &lag->guess;
+    for(i=0; i<para->cosim->para->nPorts; i++) {
+      if(d->XiPor!=NULL) free(d->XiPor[i]);
+      if(d->CPor!=NULL) free(d->CPor[i]);
+    }
+    free(d->temHea);
+    free(d->shaConSig);
+    free(d->shaAbsRad);
+    free(d->mFloRatPor);
+    free(d->TPor);
+    free(d->XiPor);
+    free(d->CPor);
+  }
+  free(lag);
+  para->solv->lag = NULL;
+} // End of free_cosim_lag_data()
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Write the FFD data for Modelica
 ///
@@ -288,10 +531,10 @@ int write_cosim_data(PARA_DATA *para, REAL **var) {
   /****************************************************************************
   | Wait if the previosu data has not been read by Modelica
   ****************************************************************************/
-  while(para->cosim->ffd->flag==1) {
+  if(cosim_get_flag(&para->cosim->ffd->flag)==1) {
     ffd_log("write_cosim_data(): Wait since previosu data is not taken "
             "by Modelica", FFD_NORMAL);
-    Sleep(1000);
+    cosim_wait_flag(&para->cosim->ffd->flag, 1);
   }
 
   /****************************************************************************
@@ -390,11 +633,110 @@ int write_cosim_data(PARA_DATA *para, REAL **var) {
   /****************************************************************************
   | Inform Modelica the data is updated
   ****************************************************************************/
-  para->cosim->ffd->flag = 1;
+  cosim_set_flag(&para->cosim->ffd->flag, 1);
 
   return 0;
 } // End of write_cosim_data()
 
+///////////////////////////////////////////////////////////////////////////////
+/// Read a flag of the cosimulation data with acquire ordering
+///
+/// The data written by the other program before it set the flag are visible
+/// after this call.
+///
+///\param flag Pointer to the flag
+///
+///\return Value of the flag
+///////////////////////////////////////////////////////////////////////////////
+int cosim_get_flag(int *flag) {
+#ifdef _MSC_VER
+  // Interlocked functions are full memory barriers
+  return (int) InterlockedCompareExchange((volatile LONG *) flag, 0, 0);
+#else
+  return __atomic_load_n(flag, __ATOMIC_ACQUIRE);
+#endif
+} // End of cosim_get_flag()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Set a flag of the cosimulation data and wake up the waiting thread
+///
+/// The flag is written with release ordering, so that the data written
+/// before are visible to the thread that reads the flag. Modelica should set
+/// the flags with this function, so that FFD wakes up at once. A flag set by
+/// a plain store is still noticed after at most COSIM_MAX_SLEEP microseconds.
+///
+///\param flag Pointer to the flag
+///\param value New value of the flag
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void cosim_set_flag(int *flag, int value) {
+#ifdef _MSC_VER
+  InterlockedExchange((volatile LONG *) flag, (LONG) value);
+  WakeByAddressAll((void *) flag);
+#else
+  __atomic_store_n(flag, value, __ATOMIC_RELEASE);
+#ifdef __linux__
+  syscall(SYS_futex, flag, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+#endif
+#endif
+} // End of cosim_set_flag()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Wait as long as a flag of the cosimulation data has a given value
+///
+/// The thread polls the flag COSIM_SPIN times and then sleeps on the address
+/// of the flag (futex on Linux, WaitOnAddress on Windows). The sleep time is
+/// doubled after each wake-up up to COSIM_MAX_SLEEP microseconds, so that a
+/// flag set without cosim_set_flag() is noticed as well.
+///
+///\param flag Pointer to the flag
+///\param value Value of the flag to wait on
+///
+///\return New value of the flag
+///////////////////////////////////////////////////////////////////////////////
+int cosim_wait_flag(int *flag, int value) {
+  int i, cur, usec = 1;
+
+  for(i=0; i<COSIM_SPIN; i++) {
+    cur = cosim_get_flag(flag);
+    if(cur!=value) return cur;
+  }
+
+  while((cur=cosim_get_flag(flag))==value) {
+    cosim_sleep(flag, value, usec);
+    usec = 2*usec<COSIM_MAX_SLEEP ? 2*usec : COSIM_MAX_SLEEP;
+  }
+
+  return cur;
+} // End of cosim_wait_flag()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Sleep until a flag changes its value, is woken up or the time is over
+///
+///\param flag Pointer to the flag
+///\param value Value of the flag to wait on
+///\param usec Longest time of the sleep in microseconds
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void cosim_sleep(int *flag, int value, int usec) {
+#ifdef _MSC_VER
+  // WaitOnAddress() has a resolution of milliseconds
+  WaitOnAddress((volatile VOID *) flag, (PVOID) &value, sizeof(int),
+                (DWORD) ((usec+999)/1000));
+#elif defined(__linux__)
+  struct timespec ts;
+
+  ts.tv_sec = usec / 1000000;
+  ts.tv_nsec = (long) (usec%1000000) * 1000;
+  // Returns at once if the flag does not have the value any more
+  syscall(SYS_futex, flag, FUTEX_WAIT_PRIVATE, value, &ts, NULL, 0);
+#else
+  usleep(usec);
+#endif
+} // End of cosim_sleep()
+
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -554,10 +896,12 @@ int compare_boundary_area(PARA_DATA *para, REAL **var, int **BINDEX) {
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to the FFD simulaiton variables
 ///\param BINDEX Pointer to boundary index
+///\param modelica Pointer to the Modelica data
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int assign_thermal_bc(PARA_DATA *para, REAL **var, int **BINDEX) {
+int assign_thermal_bc(PARA_DATA *para, REAL **var, int **BINDEX,
+                      ModelicaSharedData *modelica) {
   int i, j, k, it, id, modelicaId;
   int imax = para->geom->imax, jmax = para->geom->jmax;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
@@ -582,13 +926,13 @@ int assign_thermal_bc(PARA_DATA *para, REAL **var, int **BINDEX) {
       i = para->bc->wallId[j];
       switch(para->cosim->para->bouCon[i]) {
         case 1: // Temperature
-          temHea[j] = para->cosim->modelica->temHea[i] - 273.15;
+          temHea[j] = modelica->temHea[i] - 273.15;
           sprintf(msg, "\t%s: T=%f[degC]", 
             para->bc->wallName[j], temHea[j]);
           ffd_log(msg, FFD_NORMAL);
           break;
         case 2: // Heat flow rate
-          temHea[j] = para->cosim->modelica->temHea[i] / para->bc->AWall[j];
+          temHea[j] = modelica->temHea[i] / para->bc->AWall[j];
           sprintf(msg, "\t%s: Q_dot=%f[W/m2]", 
             para->bc->wallName[j], temHea[j]);
           ffd_log(msg, FFD_NORMAL);
@@ -659,10 +1003,12 @@ int assign_thermal_bc(PARA_DATA *para, REAL **var, int **BINDEX) {
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to the FFD simulaiton variables
 ///\param BINDEX Pointer to boundary index
+///\param modelica Pointer to the Modelica data
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int assign_port_bc(PARA_DATA *para, REAL **var, int **BINDEX) {
+int assign_port_bc(PARA_DATA *para, REAL **var, int **BINDEX,
+                   ModelicaSharedData *modelica) {
   int i, j, k, it, id;
   int imax = para->geom->imax, jmax = para->geom->jmax;
   int kmax = para->geom->kmax;
@@ -679,9 +1025,9 @@ int assign_port_bc(PARA_DATA *para, REAL **var, int **BINDEX) {
     /*-------------------------------------------------------------------------
     | Convert for mass flow rate and temperature
     -------------------------------------------------------------------------*/
-    para->bc->velPort[j] = para->cosim->modelica->mFloRatPor[i] 
+    para->bc->velPort[j] = modelica->mFloRatPor[i] 
                               / (para->prob->rho*para->bc->APort[j]);
-    para->bc->TPort[j] = para->cosim->modelica->TPor[i] - 273.15;
+    para->bc->TPort[j] = modelica->TPor[i] - 273.15;
     sprintf(msg, "\t%s: vel=%f[m/s], T=%f[degC]", 
           para->bc->portName[j], para->bc->velPort[j], 
           para->bc->TPort[j]);
@@ -690,7 +1036,7 @@ int assign_port_bc(PARA_DATA *para, REAL **var, int **BINDEX) {
     | Convert nXi types of trace substance
     -------------------------------------------------------------------------*/
     for(k=0; k<para->cosim->para->nXi; k++) {
-      para->bc->XiPort[j][k] = para->cosim->modelica->XiPor[i][k];
+      para->bc->XiPort[j][k] = modelica->XiPor[i][k];
       sprintf(msg, "\tXi[%d]=%f", k, para->bc->XiPort[j][k]);
       ffd_log(msg, FFD_NORMAL);
     }
@@ -698,7 +1044,7 @@ int assign_port_bc(PARA_DATA *para, REAL **var, int **BINDEX) {
     | Convert nC types of species
     -------------------------------------------------------------------------*/
     for(k=0; k<para->cosim->para->nC; k++) {
-      para->bc->CPort[j][k] = para->cosim->modelica->CPor[i][k];
+      para->bc->CPort[j][k] = modelica->CPor[i][k];
       sprintf(msg, "\tC[%d]=%f", k, para->bc->CPort[j][k]);
       ffd_log(msg, FFD_NORMAL);
     }
@@ -763,7 +1109,8 @@ int surface_integrate(PARA_DATA *para, REAL **var, int **BINDEX) {
   int imax = para->geom->imax, jmax = para->geom->jmax; 
   int kmax = para->geom->kmax;
   int i, j, k, it, bcid;
-  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2), JMAX = jmax+2;
+  METRIC_DATA *metric = para->geom->metric;
   REAL vel_tmp, A_tmp; 
 
   /****************************************************************************
@@ -792,15 +1139,15 @@ int surface_integrate(PARA_DATA *para, REAL **var, int **BINDEX) {
 
     if(i==0 || i==imax+1) {
       vel_tmp = var[VX][IX(i,j,k)];
-      A_tmp = area_yz(para, var, i, j, k);
+      A_tmp = metric->ayz[j+JMAX*k];
     }
     else if(j==0 || j==jmax+1) {
       vel_tmp = var[VY][IX(i,j,k)];
-      A_tmp = area_zx(para, var, i, j, k);
+      A_tmp = metric->azx[i+IMAX*k];
     }
     else if(k==0 || k==kmax+1) {
       vel_tmp = var[VZ][IX(i,j,k)];
-      A_tmp = area_xy(para, var, i, j, k);
+      A_tmp = metric->axy[i+IMAX*j];
     }
 
     /*-------------------------------------------------------------------------
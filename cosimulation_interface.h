@@ -33,9 +33,19 @@
 #include "geometry.h"
 #endif
 
-#ifndef _MSC_VER //Linux
-#define Sleep(x) sleep(x/1000)
+#ifdef _MSC_VER
+#pragma comment(lib, "Synchronization.lib")
+#elif defined(__linux__)
+#include <limits.h>
+#include <time.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 #endif
+
+// Number of times a flag is polled before the thread goes to sleep
+#define COSIM_SPIN 200
+// Longest time in microseconds a waiting thread sleeps before it polls again
+#define COSIM_MAX_SLEEP 1000
 ///////////////////////////////////////////////////////////////////////////////
 /// Read the cosimulation parameters defined by Modelica
 ///
@@ -60,6 +70,9 @@ int write_cosim_data(PARA_DATA *para, REAL **var);
 ///////////////////////////////////////////////////////////////////////////////
 /// Read the data from Modelica
 ///
+/// If solv.cosim_lag is 1, FFD does not wait for the data of the current
+/// synchronization but uses the data extrapolated by receive_cosim_data().
+///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
 ///\param BINDEX pointer to boudnary index
@@ -68,6 +81,126 @@ int write_cosim_data(PARA_DATA *para, REAL **var);
 ///////////////////////////////////////////////////////////////////////////////
 int read_cosim_data(PARA_DATA *para, REAL **var, int **BINDEX);
 
+///////////////////////////////////////////////////////////////////////////////
+/// Receive the data from Modelica for the lagged coupling
+///
+/// FFD runs at most one synchronization interval ahead of Modelica. It waits
+/// for the data of the previous synchronization, takes the data of the
+/// current one if Modelica has already sent them and extrapolates them
+/// linearly in time from the last two data sets otherwise. The data used by
+/// FFD are stored in para->solv->lag->guess.
+///
+///\param para Pointer to FFD parameters
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int receive_cosim_data(PARA_DATA *para);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Copy the data set sent by Modelica and release the shared data
+///
+/// If the data had been extrapolated, the largest deviations of the
+/// extrapolated surface and port data are reported.
+///
+///\param para Pointer to FFD parameters
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void pull_cosim_data(PARA_DATA *para);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Copy or extrapolate a data set of Modelica
+///
+/// If b is NULL, a is copied. Otherwise the surface temperatures or heat
+/// flows, the mass flow rates and the temperatures at the ports are
+/// extrapolated linearly to the time t from the data sets a and b, where a
+/// is the newer one. The other data are copied from a.
+///
+///\param para Pointer to FFD parameters
+///\param to Pointer to the target data set
+///\param a Pointer to the newest data set
+///\param b Pointer to the older data set, NULL for a copy
+///\param t Time of the extrapolation
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void copy_modelica_data(PARA_DATA *para, ModelicaSharedData *to,
+                        ModelicaSharedData *a, ModelicaSharedData *b,
+                        float t);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Allocate memory for the Modelica data of the lagged coupling
+///
+///\param para Pointer to FFD parameters
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int allocate_cosim_lag_data(PARA_DATA *para);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free memory for the Modelica data of the lagged coupling
+///
+///\param para Pointer to FFD parameters
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_cosim_lag_data(PARA_DATA *para);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Read a flag of the cosimulation data with acquire ordering
+///
+/// The data written by the other program before it set the flag are visible
+/// after this call.
+///
+///\param flag Pointer to the flag
+///
+///\return Value of the flag
+///////////////////////////////////////////////////////////////////////////////
+int cosim_get_flag(int *flag);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Set a flag of the cosimulation data and wake up the waiting thread
+///
+/// The flag is written with release ordering, so that the data written
+/// before are visible to the thread that reads the flag. Modelica should set
+/// the flags with this function, so that FFD wakes up at once. A flag set by
+/// a plain store is still noticed after at most COSIM_MAX_SLEEP microseconds.
+///
+///\param flag Pointer to the flag
+///\param value New value of the flag
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+#ifdef _MSC_VER
+__declspec(dllexport)
+#endif
+void cosim_set_flag(int *flag, int value);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Wait as long as a flag of the cosimulation data has a given value
+///
+/// The thread polls the flag COSIM_SPIN times and then sleeps on the address
+/// of the flag (futex on Linux, WaitOnAddress on Windows). The sleep time is
+/// doubled after each wake-up up to COSIM_MAX_SLEEP microseconds.
+///
+///\param flag Pointer to the flag
+///\param value Value of the flag to wait on
+///
+///\return New value of the flag
+///////////////////////////////////////////////////////////////////////////////
+int cosim_wait_flag(int *flag, int value);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Sleep until a flag changes its value, is woken up or the time is over
+///
+///\param flag Pointer to the flag
+///\param value Value of the flag to wait on
+///\param usec Longest time of the sleep in microseconds
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void cosim_sleep(int *flag, int value, int usec);
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Compare the names of boundaries and store the relationship 
 ///
@@ -94,10 +227,12 @@ int compare_boundary_area(PARA_DATA *para, REAL **var, int **BINDEX);
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to the FFD simulaiton variables
 ///\param BINDEX Pointer to boundary index
+///\param modelica Pointer to the Modelica data
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int assign_thermal_bc(PARA_DATA *para, REAL **var, int **BINDEX);
+int assign_thermal_bc(PARA_DATA *para, REAL **var, int **BINDEX,
+                      ModelicaSharedData *modelica);
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Assign the Modelica inlet and outlet boundary condition data to FFD
@@ -114,10 +249,12 @@ int assign_thermal_bc(PARA_DATA *para, REAL **var, int **BINDEX);
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to the FFD simulaiton variables
 ///\param BINDEX Pointer to boundary index
+///\param modelica Pointer to the Modelica data
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int assign_port_bc(PARA_DATA *para, REAL **var, int **BINDEX);
+int assign_port_bc(PARA_DATA *para, REAL **var, int **BINDEX,
+                   ModelicaSharedData *modelica);
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Integrate the cosimulation exchange data over the surfaces 
@@ -21,6 +21,7 @@
 #include <windows.h>
 #else
 #include <unistd.h>
+#include <pthread.h>
 #endif
 
 #include <stdio.h>
@@ -48,8 +49,8 @@ Place the stdlib.h line above the glut.h line in the code.
 #define FOR_EACH_CELL for(i=1; i<=imax; i++) { for(j=1; j<=jmax; j++) { for(k=1; k<=kmax; k++) {
 #define FOR_ALL_CELL for(k=0; k<=kmax+1; k++) { for(j=0; j<=jmax+1; j++) { for(i=0; i<=imax+1; i++) {
 #define FOR_U_CELL for(k=1; k<=kmax; k++) { for(j=1; j<=jmax; j++) { for(i=1; i<=imax-1; i++) {
-#define FOR_V_CELL for(i=1; i<=imax; i++) { for(j=1; j<=jmax-1; j++) { for(k=1; k<=kmax; k++) {
-#define FOR_W_CELL for(i=1; i<=imax; i++) { for(j=1; j<=jmax; j++) { for(k=1; k<=kmax-1; k++) {
+#define FOR_V_CELL for(k=1; k<=kmax; k++) { for(j=1; j<=jmax-1; j++) { for(i=1; i<=imax; i++) {
+#define FOR_W_CELL for(k=1; k<=kmax-1; k++) { for(j=1; j<=jmax; j++) { for(i=1; i<=imax; i++) {
 
 #define FOR_KI for(i=1; i<=imax; i++) { for(k=1; k<=kmax; k++) {{
 #define FOR_IJ for(i=1; i<=imax; i++) { for(j=1; j<=jmax; j++) {{
@@ -58,12 +59,19 @@ Place the stdlib.h line above the glut.h line in the code.
 
 #define REAL float
 
+#define FFD_ALIGN 64 // Alignment in bytes of the variables in the memory arena
+#define FFD_HUGE_PAGE 2097152 // Arenas of this size are aligned to huge pages
+
 #define SMALL 0.00001
 
 #ifndef max
 	#define max( a, b ) ( ((a) > (b)) ? (a) : (b) )
 #endif
 
+#ifndef min
+	#define min( a, b ) ( ((a) < (b)) ? (a) : (b) )
+#endif
+
 #define PI 3.1415926
 
 #define X     0
@@ -113,13 +121,20 @@ Place the stdlib.h line above the glut.h line in the code.
 
 #define TRACE 44
 
+// Number of variables allocated in var[] by allocate_memory()
+#define NB_VAR(para) (46 + (para)->bc->nb_Xi + (para)->bc->nb_C)
+
 typedef enum{NOSLIP, SLIP, INFLOW, OUTFLOW, PERIODIC, SYMMETRY} BCTYPE;
 
 typedef enum{SOLID=1, INLET=0, OUTLET=2, FLUID=-1} CELLTYPE;
 
 typedef enum{TCONST, QCONST, ADIBATIC} BCTTYPE;
 
-typedef enum{GS, TDMA} SOLVERTYPE;
+typedef enum{GS, TDMA, MG, PCG} SOLVERTYPE;
+
+typedef enum{LEXICOGRAPHIC, REDBLACK} GS_ORDER;
+
+typedef enum{JACOBI, SSOR, IC} PRECONDITIONER;
 
 typedef enum{SEMI, LAX, UPWIND, UPWIND_NEW} ADVECTION;
 
@@ -131,8 +146,41 @@ typedef enum{DEMO, DEBUG, RUN} VERSION;
 
 typedef enum{FFD, SCI, TECPLOT} FILE_FORMAT;
 
+typedef enum{ASCII, BINARY, VTK} OUTPUT_FORMAT;
+
 typedef enum{FFD_WARNING, FFD_ERROR, FFD_NORMAL, FFD_NEW} FFD_MSG_TYPE;
 
+// Phases of the solver measured by the timers, NB_PHASE is their number
+typedef enum{PHASE_VEL, PHASE_TEMP, PHASE_DEN, PHASE_ADVECT, PHASE_DIFFUSION,
+             PHASE_COEF, PHASE_SOLVE, PHASE_PROJECT, PHASE_BC, PHASE_AVERAGE,
+             PHASE_COSIM_READ, PHASE_COSIM_WRITE, NB_PHASE} FFD_PHASE;
+
+
+// Geometric metrics of the grid, built once after the grid is set.
+// The grid is a tensor product, so that the lengths only depend on one index.
+typedef struct {
+  REAL *lx; // lx[imax+2]: Length of cell i, 0 for i=0 and i=imax+1
+  REAL *ly; // ly[jmax+2]: Length of cell j, 0 for j=0 and j=jmax+1
+  REAL *lz; // lz[kmax+2]: Length of cell k, 0 for k=0 and k=kmax+1
+  REAL *rlx; // rlx[imax+2]: 1/lx, 0 if lx is 0
+  REAL *rly; // rly[jmax+2]: 1/ly, 0 if ly is 0
+  REAL *rlz; // rlz[kmax+2]: 1/lz, 0 if lz is 0
+  REAL *dxc; // dxc[imax+2]: Distance between the centers of cell i and i+1
+  REAL *dyc; // dyc[jmax+2]: Distance between the centers of cell j and j+1
+  REAL *dzc; // dzc[kmax+2]: Distance between the centers of cell k and k+1
+  REAL *rdxc; // rdxc[imax+2]: 1/dxc, 0 if dxc is 0
+  REAL *rdyc; // rdyc[jmax+2]: 1/dyc, 0 if dyc is 0
+  REAL *rdzc; // rdzc[kmax+2]: 1/dzc, 0 if dzc is 0
+  REAL *axy; // axy[i+(imax+2)*j]: Area of XY surface, lx[i]*ly[j]
+  REAL *ayz; // ayz[j+(jmax+2)*k]: Area of YZ surface, ly[j]*lz[k]
+  REAL *azx; // azx[i+(imax+2)*k]: Area of ZX surface, lz[k]*lx[i]
+  REAL *x; // x[imax+2]: X-coordinate of the cell centers
+  REAL *y; // y[jmax+2]: Y-coordinate of the cell centers
+  REAL *z; // z[kmax+2]: Z-coordinate of the cell centers
+  REAL *gx; // gx[imax+2]: X-coordinate of the east surfaces of the cells
+  REAL *gy; // gy[jmax+2]: Y-coordinate of the north surfaces of the cells
+  REAL *gz; // gz[kmax+2]: Z-coordinate of the ceiling surfaces of the cells
+}METRIC_DATA;
 
 // Parameter for geometry and mesh
 typedef struct {
@@ -147,6 +195,7 @@ typedef struct {
   REAL  dy; // Length delta_y of one cell in y-direction for uniform grid only
   REAL  dz; // Length delta_z of one cell in z-direction for uniform grid only
   int   uniform; // Only for generating grid by FFD. 1: uniform grid; 0: non-uniform grid 
+  METRIC_DATA *metric; // Internal: cached cell lengths and surface areas
 
   int   i1; // Fixme: May be deleted
   int   i2;
@@ -228,6 +277,11 @@ typedef struct{
   VERSION version; // DEMO, DEBUG, RUN
   int screen; // Screen for display: 1 velocity; 2: temperature; 3: contaminant
   int tstep_display; // Number of time steps to update the visualziation
+  int checkpoint; // 1: Write the binary checkpoint file at the end; 0: False
+  OUTPUT_FORMAT format; // Format of the result files: ASCII, BINARY, VTK
+  int log_level; // Log: 0 nothing; 1 errors; 2 and warnings; 3 all messages
+  int profile; // 1: Time the solver phases and write a report; 0: False
+  int id; // Internal: number of the instance, 0: stand alone simulation
 } OUTP_DATA;
 
 typedef struct{
@@ -253,6 +307,7 @@ typedef struct{
   REAL force; // Force to be added in demo window for velocity when left-click on mouse
   REAL source; // Source to be added in demo window for contaminants when right click on mouse 
   int movie; // Output data for making animation (1:yes, 0:no)
+  int movie_step; // Number of time steps between two snapshots for animation
   int output;   // Internl: 0: have not been written; 1: done
   TUR_MODEL tur_model; // LAM, CHEN, CONSTANT
   REAL chen_a; // Coefficeint of Chen's zero euqation turbulence model
@@ -317,17 +372,193 @@ typedef struct {
   int step_total; // The interval of iteration step to output data
   int step_current; // Internal: current iteration step
   int step_mean; // Internal: steps for time average
+  double w_mean; // Internal: sum of the weights for time average
+  int adaptive; // 1: Adapt dt to the CFL and diffusion numbers; 0: fixed dt
+  REAL cfl; // Target CFL number of the adaptive time step
+  REAL fourier; // Maximum diffusion number of the adaptive time step
+  double dt_min; // Minimum adaptive time step size, 0: no limit
+  double dt_max; // Maximum adaptive time step size, 0: no limit
+  double dt_log; // Internal: last adaptive time step size in the log
   clock_t t_start; // Internal: clock time when simulation starts
   clock_t t_end; // Internal: clock time when simulaiton ends
 }TIME_DATA;
 
+// One grid level of the multigrid solver
+typedef struct {
+  int imax; // Number of interior cells in x-direction on this level
+  int jmax; // Number of interior cells in y-direction on this level
+  int kmax; // Number of interior cells in z-direction on this level
+  REAL *ap; // Coefficients of the equations on this level
+  REAL *ae;
+  REAL *aw;
+  REAL *an;
+  REAL *as;
+  REAL *af;
+  REAL *ab;
+  REAL *b; // Source term (restricted residual on the coarse levels)
+  REAL *x; // Solution (correction on the coarse levels)
+  REAL *r; // Residual
+  REAL *flag; // Cell property: <0 means the cell is solved
+  int *ic; // ic[imax+2]: I-index of the parent cell on the next coarse level
+  int *jc; // jc[jmax+2]: J-index of the parent cell on the next coarse level
+  int *kc; // kc[kmax+2]: K-index of the parent cell on the next coarse level
+}MG_LEVEL;
+
+typedef struct {
+  int nb_level; // Number of grid levels including the finest one
+  MG_LEVEL *level; // level[nb_level]: Level 0 is the FFD grid
+}MG_DATA;
+
+typedef struct {
+  int nb_thread; // Number of workspaces
+  int length; // Maximum number of cells in a line and of lines in a batch
+  REAL **work; // work[nb_thread]: Workspace of each thread for one batch
+}TDMA_DATA;
+
+typedef struct {
+  REAL *r; // Residual
+  REAL *z; // Preconditioned residual
+  REAL *p; // Search direction
+  REAL *q; // Product of the matrix and the search direction
+  REAL *d; // Diagonal of the preconditioner
+}PCG_DATA;
+
 typedef struct {
-  SOLVERTYPE solver;  // Solver type: GS, TDMA
+  unsigned char *distp; // Distance of the cells to the nearest cell with FLAGP>=0
+  unsigned char *distu; // Distance of the cells to the nearest cell with FLAGU>=0
+  unsigned char *distv; // Distance of the cells to the nearest cell with FLAGV>=0
+  unsigned char *distw; // Distance of the cells to the nearest cell with FLAGW>=0
+  int nb_den0; // Number of trace substances in den0
+  REAL **den0; // den0[nb_den0]: Trace substances after the advection
+  int nb_cell; // Number of cells in the cache of the departure points
+  int *cell; // cell[nb_cell]: Index IX(i,j,k) of the cells with FLAGP<0
+  int *oc; // oc[nb_cell]: Index IX(i,j,k) of the cell of the departure point
+  REAL *x_1; // x_1[nb_cell]: Relative X-location of the departure point
+  REAL *y_1; // y_1[nb_cell]: Relative Y-location of the departure point
+  REAL *z_1; // z_1[nb_cell]: Relative Z-location of the departure point
+  int departure; // 1: Departure points are traced for the current velocity
+}TRACE_DATA;
+
+typedef struct {
+  REAL *vel0; // vel0[3*size]: Velocities VX, VY and VZ at the previous step
+  int nb_step; // Number of steps in the current window
+  int nb_window; // Number of completed windows
+  REAL du; // Sum of the relative velocity changes in the current window
+  REAL ke; // Sum of the kinetic energies in the current window
+  REAL troo; // Sum of the volume averaged temperatures in the current window
+  REAL du_mean; // Mean relative velocity change of the last window
+  REAL ke_mean; // Mean kinetic energy of the last window
+  REAL troo_mean; // Mean volume averaged temperature of the last window
+  REAL change; // Largest relative change of the means of the last window
+  int settled; // 1: The flow has settled; 0: not yet
+}STEADY_DATA;
+
+// Double buffered staging areas of the snapshots for animation. The solver
+// copies the fields into the free area and a writer thread writes the full
+// areas in the order in which they were filled.
+typedef struct {
+  REAL **var[2]; // var[2][nb_var]: Fields of each area, NULL if not staged
+  REAL *arena[2]; // Memory of the copied fields of each area
+  TIME_DATA time[2]; // Time and step of the snapshot in each area
+  int full[2]; // 1: The area waits for the writer; 0: The area is free
+  int next; // Area filled by the next snapshot
+  int stop; // 1: The writer stops after writing the full areas
+#ifdef _MSC_VER
+  HANDLE thread; // Writer thread
+  CRITICAL_SECTION lock; // Protects full, next and stop
+  CONDITION_VARIABLE cond; // Signals a change of full or stop
+#else
+  pthread_t thread; // Writer thread
+  pthread_mutex_t lock; // Protects full, next and stop
+  pthread_cond_t cond; // Signals a change of full or stop
+#endif
+}SNAPSHOT_DATA;
+
+// Timers of the solver phases. The histogram bin b counts the durations in
+// [2^b, 2^(b+1)) microseconds, bin 0 also counts the shorter ones.
+#define PROFILE_BIN 32
+typedef struct {
+  double t_start; // Wall clock time when the timers were started
+  double start[NB_PHASE]; // Start time of the running timer of each phase
+  int depth[NB_PHASE]; // Number of nested timers running for each phase
+  long count[NB_PHASE]; // Number of measured calls of each phase
+  double total[NB_PHASE]; // Total time of each phase in seconds
+  double min[NB_PHASE]; // Shortest call of each phase in seconds
+  double max[NB_PHASE]; // Longest call of each phase in seconds
+  long hist[NB_PHASE][PROFILE_BIN]; // Histogram of the call durations
+}PROFILE_DATA;
+
+// Modelica data for the lagged cosimulation. FFD keeps its own copies of the
+// data received from Modelica, since Modelica may write the shared data again
+// while FFD is still integrating with them.
+typedef struct {
+  ModelicaSharedData data[2]; // Last two data sets received from Modelica
+  ModelicaSharedData guess; // Data used by FFD, extrapolated if not received
+  int nb_read; // Number of data sets received from Modelica
+  int nb_sync; // Number of synchronizations done by FFD
+  int guessed; // 1: guess was extrapolated; 0: guess was received
+}COSIM_LAG_DATA;
+
+// Header of the binary checkpoint file. The boundary values follow the
+// header and the variables start at the offset var_offset.
+typedef struct {
+  char magic[8]; // "FFDCKP" followed by two zero bytes
+  int version; // Version of the file format
+  int byte_order; // 0x01020304 written in the byte order of the writer
+  int size_real; // sizeof(REAL) of the writer
+  int imax; // Number of interior cells in x-direction
+  int jmax; // Number of interior cells in y-direction
+  int kmax; // Number of interior cells in z-direction
+  int nb_var; // Number of variables in var
+  int nb_wall; // Number of wall boundaries
+  int nb_port; // Number of fluid ports
+  int nb_Xi; // Number of species
+  int nb_C; // Number of trace substances
+  int nb_sensor; // Number of sensors
+  int nb_bc_value; // Number of boundary and sensor values after the header
+  int step_current; // Current iteration step
+  int step_mean; // Steps for time average
+  int padding; // Keeps the following doubles aligned
+  double t; // Current time
+  double dt; // Time step size
+  double w_mean; // Sum of the weights for time average
+  long long var_offset; // Offset of the variables in bytes
+}CHECKPOINT_HEADER;
+
+typedef struct {
+  SOLVERTYPE solver;  // Solver type: GS, TDMA, MG, PCG
+  GS_ORDER gs_order; // Cell order of G-S sweeps: LEXICOGRAPHIC, REDBLACK
+  int gs_conv; // 1: Sweep G-S solver until convergence; 0: fixed two sweeps
+  REAL gs_tol; // Residual target of the convergence controlled G-S solver
+  int gs_min_vel; // Minimum number of G-S sweeps for velocities
+  int gs_max_vel; // Maximum number of G-S sweeps for velocities
+  int gs_min_temp; // Minimum number of G-S sweeps for temperature
+  int gs_max_temp; // Maximum number of G-S sweeps for temperature
+  int gs_min_trace; // Minimum number of G-S sweeps for trace substances
+  int gs_max_trace; // Maximum number of G-S sweeps for trace substances
+  int steady; // 1: Stop at the steady state; 0: run step_total steps
+  REAL steady_tol; // Relative change of the window means at steady state
+  int steady_window; // Number of steps in a window of the steady monitor
+  REAL steady_du_max; // Largest mean velocity change of a stagnating window
   int check_residual; // 1: check, 0: donot check
+  PRECONDITIONER pcg_precond; // Preconditioner of PCG solver: JACOBI, SSOR, IC
+  REAL p_tol; // Residual target of the iterative pressure solvers
+  int p_max_iter; // Maximum number of V-cycles of the multigrid solver
+  int pcg_max_iter; // Maximum number of iterations of the PCG solver
   ADVECTION advection_solver; // Tyep of advection solver: SEMI, LAX, UPWIND, UPWIND_NEW 
   INTERPOLATION interpolation; // Internploation in semi-Lagrangian method: BILINEAR, FSJ, HYBRID
   int cosimulation;  // 0: single; 1: cosimulation
+  int cosim_lag; // 1: Lagged coupling with extrapolated Modelica data; 0: no
   int nextstep; // Internal: 1: yes; 0: no, wait
+  MG_DATA *mg; // Internal: grid hierarchy of the multigrid solver
+  TDMA_DATA *tdma; // Internal: workspaces of the TDMA solver
+  PCG_DATA *pcg; // Internal: work vectors of the PCG solver
+  TRACE_DATA *trace; // Internal: distances for the departure point search
+  STEADY_DATA *monitor; // Internal: monitor of the steady state
+  SNAPSHOT_DATA *snapshot; // Internal: staging areas of the snapshots
+  COSIM_LAG_DATA *lag; // Internal: Modelica data for the lagged cosimulation
+  PROFILE_DATA *profile; // Internal: timers of the solver phases
+  int nb_thread; // Number of OpenMP threads of the simulation, 0: default
 }SOLV_DATA;
 
 typedef struct {
@@ -350,6 +581,23 @@ typedef struct {
   INIT_DATA *init;
 }PARA_DATA;
 
+// All the data of one FFD simulation. Each room of a cosimulation runs its
+// own instance in its own thread, so that no data is shared between rooms.
+typedef struct {
+  PARA_DATA para; // Parameters pointing to the data below
+  GEOM_DATA geom;
+  INPU_DATA inpu;
+  OUTP_DATA outp;
+  PROB_DATA prob;
+  TIME_DATA mytime;
+  BC_DATA bc;
+  SOLV_DATA solv;
+  SENSOR_DATA sens;
+  INIT_DATA init;
+  REAL **var; // var[nb_var]: Simulation variables
+  int **BINDEX; // BINDEX[5]: Boundary index
+}FFD_INSTANCE;
+
 typedef struct {
   double number0;
   double number1;
@@ -370,4 +618,12 @@ typedef struct {
   int feedback;
 }ReceivedCommand;
 
-char msg[1000];
\ No newline at end of file
+// Each thread writes its messages into its own buffer. The buffer is thread
+// local for the OpenMP threads as well as for the threads of FFD instances
+// and is defined in utility.c.
+#ifdef _MSC_VER
+#define FFD_THREAD_LOCAL __declspec(thread)
+#else
+#define FFD_THREAD_LOCAL __thread
+#endif
+extern FFD_THREAD_LOCAL char msg[1000];
\ No newline at end of file
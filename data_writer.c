@@ -19,6 +19,8 @@
 
 #include "data_writer.h"
 
+#define OUTPUT_BUFFER 4194304 // Size in bytes of the buffer of binary files
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Write standard output data in a format for tecplot 
 ///
@@ -40,6 +42,17 @@ int write_tecplot_data(PARA_DATA *para, REAL **var, char *name) {
   REAL *flagp = var[FLAGP];
   char *filename;
   FILE *datafile;
+  int id[] = {VX, VY, VZ, TEMP, FLAGP, IP};
+  char *var_name[] = {"U", "V", "W", "T", "FLAGP", "P"};
+
+  // Binary formats
+  if(para->outp->format!=ASCII) {
+    convert_to_tecplot(para, var);
+    if(para->outp->format==VTK)
+      return write_vtk_data(para, var, name, 6, id, var_name);
+    else
+      return write_tecplot_binary(para, var, name, 6, id, var_name);
+  }
 
   /****************************************************************************
   | Allocate memory for filename
@@ -108,6 +121,24 @@ int write_tecplot_all_data(PARA_DATA *para, REAL **var, char *name) {
   REAL *x = var[X], *y = var[Y], *z =var[Z];
   char *filename;
   FILE *dataFile;
+  int id[] = {VX, VY, VZ, VXM, VYM, VZM, VXS, VYS, VZS, IP, TEMP, TEMPM,
+              TEMPS, GX, GY, GZ, FLAGU, FLAGV, FLAGW, FLAGP, VXBC, VYBC,
+              VZBC, TEMPBC, QFLUX, QFLUXBC, AP, AN, AS, AW, AE, AF, AB, B,
+              AP0, PP};
+  char *var_name[] = {"U", "V", "W", "UM", "VM", "WM", "US", "VS", "WS",
+                      "P", "T", "TM", "TS", "GX", "GY", "GZ", "FLAGU",
+                      "FLAGV", "FLAGW", "FLAGP", "VXBC", "VYBC", "VZBC",
+                      "TEMPBC", "QFLUX", "QFLUXBC", "AP", "AN", "AS", "AW",
+                      "AE", "AF", "AB", "B", "AP0", "PP"};
+
+  // Binary formats
+  if(para->outp->format!=ASCII) {
+    convert_to_tecplot(para, var);
+    if(para->outp->format==VTK)
+      return write_vtk_data(para, var, name, 36, id, var_name);
+    else
+      return write_tecplot_binary(para, var, name, 36, id, var_name);
+  }
 
   /****************************************************************************
   | Allocate memory for filename
@@ -567,4 +598,346 @@ int write_SCI(PARA_DATA *para, REAL **var, char *name) {
   free(filename);
   return 0;
 
-} // End of write_SCI()
\ No newline at end of file
+} // End of write_SCI()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Write the data in the binary format of Tecplot
+///
+/// The file uses the format #!TDV112 with one ordered zone. The coordinates
+/// X, Y, Z and the indexes I, J, K are followed by the variables var[id[n]].
+/// Tecplot stores the variables one after the other with I running fastest,
+/// which is the order of the FFD variables, so that each variable is
+/// written by one large write through a buffer of OUTPUT_BUFFER bytes.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param name Pointer to file name without the extension .plt
+///\param nb_var Number of variables after the coordinates and indexes
+///\param id Pointer to the indexes of the variables in var
+///\param var_name Pointer to the names of the variables
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int write_tecplot_binary(PARA_DATA *para, REAL **var, char *name, int nb_var,
+                         int *id, char **var_name) {
+  int i, j, k, n;
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int size = IJMAX*(kmax+2);
+  int *ijk, flag;
+  float marker_zone = 299.0f, marker_eoh = 357.0f;
+  double t = para->mytime->t, range[2];
+  char *coord_name[] = {"X", "Y", "Z", "I", "J", "K"};
+  char title[400], *filename;
+  FILE *datafile;
+
+  filename = (char *) malloc((strlen(name)+5)*sizeof(char));
+  ijk = (int *) malloc(IJMAX*sizeof(int));
+  if(filename==NULL || ijk==NULL) {
+    ffd_log("write_tecplot_binary(): Failed to allocate memory", FFD_ERROR);
+    free(filename);
+    free(ijk);
+    return 1;
+  }
+
+  strcpy(filename, name);
+  strcat(filename, ".plt");
+
+  if((datafile=fopen(filename, "wb"))==NULL) {
+    sprintf(msg, "write_tecplot_binary(): Failed to open file %s.", filename);
+    ffd_log(msg, FFD_ERROR);
+    free(filename);
+    free(ijk);
+    return 1;
+  }
+  setvbuf(datafile, NULL, _IOFBF, OUTPUT_BUFFER);
+
+  /****************************************************************************
+  | Header section: title, variable names and the zone
+  ****************************************************************************/
+  fwrite("#!TDV112", 1, 8, datafile);
+  write_tecplot_int(datafile, 1); // Byte order
+  write_tecplot_int(datafile, 0); // Full file with grid and solution
+  sprintf(title, "dt=%fs, t=%fs, nu=%f, Lx=%f, Ly=%f, Lz=%f, "
+          "Nx=%d, Ny=%d, Nz=%d", para->mytime->dt, para->mytime->t,
+          para->prob->nu, para->geom->Lx, para->geom->Ly, para->geom->Lz,
+          imax+2, jmax+2, kmax+2);
+  write_tecplot_string(datafile, title);
+  write_tecplot_int(datafile, nb_var+6);
+  for(n=0; n<6; n++)
+    write_tecplot_string(datafile, coord_name[n]);
+  for(n=0; n<nb_var; n++)
+    write_tecplot_string(datafile, var_name[n]);
+
+  fwrite(&marker_zone, sizeof(float), 1, datafile);
+  write_tecplot_string(datafile, "FFD");
+  write_tecplot_int(datafile, -1); // No parent zone
+  write_tecplot_int(datafile, -1); // Static strand
+  fwrite(&t, sizeof(double), 1, datafile); // Solution time
+  write_tecplot_int(datafile, -1); // Not used
+  write_tecplot_int(datafile, 0); // Ordered zone
+  write_tecplot_int(datafile, 0); // All the data at the nodes
+  write_tecplot_int(datafile, 0); // No face neighbors
+  write_tecplot_int(datafile, 0); // No user defined face neighbors
+  write_tecplot_int(datafile, imax+2);
+  write_tecplot_int(datafile, jmax+2);
+  write_tecplot_int(datafile, kmax+2);
+  write_tecplot_int(datafile, 0); // No auxiliary data
+  fwrite(&marker_eoh, sizeof(float), 1, datafile);
+
+  /****************************************************************************
+  | Data section: formats and ranges of the variables
+  | 1: single precision, 2: double precision, 3: 32 bit integer
+  ****************************************************************************/
+  fwrite(&marker_zone, sizeof(float), 1, datafile);
+  for(n=0; n<nb_var+6; n++)
+    write_tecplot_int(datafile, n>=3 && n<6 ? 3 : (sizeof(REAL)==4 ? 1 : 2));
+  write_tecplot_int(datafile, 0); // No passive variables
+  write_tecplot_int(datafile, 0); // No variable sharing
+  write_tecplot_int(datafile, -1); // No connectivity sharing
+
+  for(n=0; n<3; n++) {
+    get_range(var[X+n], size, range);
+    fwrite(range, sizeof(double), 2, datafile);
+  }
+  for(n=0; n<3; n++) {
+    range[0] = 0;
+    range[1] = n==0 ? imax+1 : (n==1 ? jmax+1 : kmax+1);
+    fwrite(range, sizeof(double), 2, datafile);
+  }
+  for(n=0; n<nb_var; n++) {
+    get_range(var[id[n]], size, range);
+    fwrite(range, sizeof(double), 2, datafile);
+  }
+
+  /****************************************************************************
+  | Data section: the values
+  ****************************************************************************/
+  for(n=0; n<3; n++)
+    fwrite(var[X+n], sizeof(REAL), size, datafile);
+
+  for(n=0; n<3; n++)
+    for(k=0; k<=kmax+1; k++) {
+      for(j=0; j<=jmax+1; j++)
+        for(i=0; i<=imax+1; i++)
+          ijk[i+IMAX*j] = n==0 ? i : (n==1 ? j : k);
+      fwrite(ijk, sizeof(int), IJMAX, datafile);
+    }
+
+  for(n=0; n<nb_var; n++)
+    fwrite(var[id[n]], sizeof(REAL), size, datafile);
+
+  flag = ferror(datafile);
+  if(fclose(datafile)!=0) flag = 1;
+  free(ijk);
+
+  if(flag!=0) {
+    sprintf(msg, "write_tecplot_binary(): Failed to write file %s.",
+            filename);
+    ffd_log(msg, FFD_ERROR);
+    free(filename);
+    return 1;
+  }
+
+  sprintf(msg, "write_tecplot_binary(): Wrote file %s.", filename);
+  ffd_log(msg, FFD_NORMAL);
+  free(filename);
+  return 0;
+} // End of write_tecplot_binary()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Write the data in the XML format of VTK for rectilinear grids
+///
+/// The variables var[id[n]] and the velocity vector (U, V, W) are written as
+/// point data. The values are appended in raw binary after the XML header,
+/// each variable by one large write through a buffer of OUTPUT_BUFFER
+/// bytes. The velocity vector is interleaved plane by plane.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param name Pointer to file name without the extension .vtr
+///\param nb_var Number of variables
+///\param id Pointer to the indexes of the variables in var
+///\param var_name Pointer to the names of the variables
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int write_vtk_data(PARA_DATA *para, REAL **var, char *name, int nb_var,
+                   int *id, char **var_name) {
+  int i, k, n, c, flag, one = 1;
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int size = IJMAX*(kmax+2);
+  int length[3];
+  unsigned long long offset = 0, nb_byte;
+  char *filename, *type = sizeof(REAL)==4 ? "Float32" : "Float64";
+  char *coord_name[] = {"X", "Y", "Z"};
+  REAL *buffer;
+  FILE *datafile;
+
+  length[0] = imax+2;
+  length[1] = jmax+2;
+  length[2] = kmax+2;
+
+  filename = (char *) malloc((strlen(name)+5)*sizeof(char));
+  buffer = (REAL *) malloc(3*IJMAX*sizeof(REAL));
+  if(filename==NULL || buffer==NULL) {
+    ffd_log("write_vtk_data(): Failed to allocate memory", FFD_ERROR);
+    free(filename);
+    free(buffer);
+    return 1;
+  }
+
+  strcpy(filename, name);
+  strcat(filename, ".vtr");
+
+  if((datafile=fopen(filename, "wb"))==NULL) {
+    sprintf(msg, "write_vtk_data(): Failed to open file %s.", filename);
+    ffd_log(msg, FFD_ERROR);
+    free(filename);
+    free(buffer);
+    return 1;
+  }
+  setvbuf(datafile, NULL, _IOFBF, OUTPUT_BUFFER);
+
+  /****************************************************************************
+  | XML header with the offsets of the appended data
+  | Each array is preceded by its size in bytes as 64 bit integer
+  ****************************************************************************/
+  fprintf(datafile, "<?xml version=\"1.0\"?>\n");
+  fprintf(datafile, "<VTKFile type=\"RectilinearGrid\" version=\"1.0\" "
+          "byte_order=\"%s\" header_type=\"UInt64\">\n",
+          *(char *) &one==1 ? "LittleEndian" : "BigEndian");
+  fprintf(datafile, "  <RectilinearGrid WholeExtent=\"0 %d 0 %d 0 %d\">\n",
+          imax+1, jmax+1, kmax+1);
+  fprintf(datafile, "    <FieldData>\n");
+  fprintf(datafile, "      <DataArray type=\"Float64\" Name=\"TIME\" "
+          "NumberOfTuples=\"1\" format=\"ascii\">%.10g</DataArray>\n",
+          para->mytime->t);
+  fprintf(datafile, "    </FieldData>\n");
+  fprintf(datafile, "    <Piece Extent=\"0 %d 0 %d 0 %d\">\n",
+          imax+1, jmax+1, kmax+1);
+  fprintf(datafile, "      <PointData Vectors=\"Velocity\">\n");
+  fprintf(datafile, "        <DataArray type=\"%s\" Name=\"Velocity\" "
+          "NumberOfComponents=\"3\" format=\"appended\" offset=\"%llu\"/>\n",
+          type, offset);
+  offset += sizeof(unsigned long long) + 3*(unsigned long long) size
+                                         * sizeof(REAL);
+  for(n=0; n<nb_var; n++) {
+    fprintf(datafile, "        <DataArray type=\"%s\" Name=\"%s\" "
+            "format=\"appended\" offset=\"%llu\"/>\n",
+            type, var_name[n], offset);
+    offset += sizeof(unsigned long long) + (unsigned long long) size
+                                           * sizeof(REAL);
+  }
+  fprintf(datafile, "      </PointData>\n");
+  fprintf(datafile, "      <Coordinates>\n");
+  for(n=0; n<3; n++) {
+    fprintf(datafile, "        <DataArray type=\"%s\" Name=\"%s\" "
+            "format=\"appended\" offset=\"%llu\"/>\n",
+            type, coord_name[n], offset);
+    offset += sizeof(unsigned long long) + (unsigned long long) length[n]
+                                           * sizeof(REAL);
+  }
+  fprintf(datafile, "      </Coordinates>\n");
+  fprintf(datafile, "    </Piece>\n");
+  fprintf(datafile, "  </RectilinearGrid>\n");
+  fprintf(datafile, "  <AppendedData encoding=\"raw\">\n_");
+
+  /****************************************************************************
+  | Appended data
+  ****************************************************************************/
+  nb_byte = 3*(unsigned long long) size*sizeof(REAL);
+  fwrite(&nb_byte, sizeof(unsigned long long), 1, datafile);
+  for(k=0; k<=kmax+1; k++) {
+    for(c=0; c<IJMAX; c++)
+      for(n=0; n<3; n++)
+        buffer[3*c+n] = var[VX+n][c+IJMAX*k];
+    fwrite(buffer, sizeof(REAL), 3*IJMAX, datafile);
+  }
+
+  nb_byte = (unsigned long long) size*sizeof(REAL);
+  for(n=0; n<nb_var; n++) {
+    fwrite(&nb_byte, sizeof(unsigned long long), 1, datafile);
+    fwrite(var[id[n]], sizeof(REAL), size, datafile);
+  }
+
+  // The grid is a tensor product, so that one line holds the coordinates
+  for(n=0; n<3; n++) {
+    nb_byte = (unsigned long long) length[n]*sizeof(REAL);
+    fwrite(&nb_byte, sizeof(unsigned long long), 1, datafile);
+    for(i=0; i<length[n]; i++)
+      buffer[i] = var[X+n][n==0 ? IX(i,0,0) : (n==1 ? IX(0,i,0) : IX(0,0,i))];
+    fwrite(buffer, sizeof(REAL), length[n], datafile);
+  }
+
+  fprintf(datafile, "\n  </AppendedData>\n</VTKFile>\n");
+
+  flag = ferror(datafile);
+  if(fclose(datafile)!=0) flag = 1;
+  free(buffer);
+
+  if(flag!=0) {
+    sprintf(msg, "write_vtk_data(): Failed to write file %s.", filename);
+    ffd_log(msg, FFD_ERROR);
+    free(filename);
+    return 1;
+  }
+
+  sprintf(msg, "write_vtk_data(): Wrote file %s.", filename);
+  ffd_log(msg, FFD_NORMAL);
+  free(filename);
+  return 0;
+} // End of write_vtk_data()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Write a 32 bit integer to a binary Tecplot file
+///
+///\param datafile Pointer to the file
+///\param value Value of the integer
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void write_tecplot_int(FILE *datafile, int value) {
+  fwrite(&value, sizeof(int), 1, datafile);
+} // End of write_tecplot_int()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Write a string to a binary Tecplot file
+///
+/// Tecplot stores each character as 32 bit integer followed by a zero.
+///
+///\param datafile Pointer to the file
+///\param string Pointer to the string
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void write_tecplot_string(FILE *datafile, char *string) {
+  do {
+    write_tecplot_int(datafile, (int) *string);
+  } while(*string++!='\0');
+} // End of write_tecplot_string()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Get the minimum and maximum value of a variable
+///
+///\param psi Pointer to the variable
+///\param size Number of values
+///\param range Pointer to the minimum range[0] and the maximum range[1]
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void get_range(REAL *psi, int size, double *range) {
+  int i;
+  REAL lo = psi[0], hi = psi[0];
+
+  for(i=1; i<size; i++) {
+    lo = psi[i]<lo ? psi[i] : lo;
+    hi = psi[i]>hi ? psi[i] : hi;
+  }
+
+  range[0] = lo;
+  range[1] = hi;
+} // End of get_range()
@@ -30,8 +30,6 @@
 #include "utility.h"
 #endif
 
-FILE *file1;
-
 ///////////////////////////////////////////////////////////////////////////////
 /// Write standard output data in a format for tecplot 
 ///
@@ -102,3 +100,70 @@ int write_unsteady(PARA_DATA *para, REAL **var, char *name);
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
 int write_SCI(PARA_DATA *para, REAL **var, char *name);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Write the data in the binary format of Tecplot
+///
+/// The coordinates X, Y, Z and the indexes I, J, K are followed by the
+/// variables var[id[n]].
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param name Pointer to file name without the extension .plt
+///\param nb_var Number of variables after the coordinates and indexes
+///\param id Pointer to the indexes of the variables in var
+///\param var_name Pointer to the names of the variables
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int write_tecplot_binary(PARA_DATA *para, REAL **var, char *name, int nb_var,
+                         int *id, char **var_name);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Write the data in the XML format of VTK for rectilinear grids
+///
+/// The variables var[id[n]] and the velocity vector (U, V, W) are written as
+/// point data in raw binary.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param name Pointer to file name without the extension .vtr
+///\param nb_var Number of variables
+///\param id Pointer to the indexes of the variables in var
+///\param var_name Pointer to the names of the variables
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int write_vtk_data(PARA_DATA *para, REAL **var, char *name, int nb_var,
+                   int *id, char **var_name);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Write a 32 bit integer to a binary Tecplot file
+///
+///\param datafile Pointer to the file
+///\param value Value of the integer
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void write_tecplot_int(FILE *datafile, int value);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Write a string to a binary Tecplot file
+///
+///\param datafile Pointer to the file
+///\param string Pointer to the string
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void write_tecplot_string(FILE *datafile, char *string);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Get the minimum and maximum value of a variable
+///
+///\param psi Pointer to the variable
+///\param size Number of values
+///\param range Pointer to the minimum range[0] and the maximum range[1]
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void get_range(REAL *psi, int size, double *range);
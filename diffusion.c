@@ -40,7 +40,9 @@ int diffusion(PARA_DATA *para, REAL **var, int var_type, int index,
   /****************************************************************************
   | Define the coeffcients for diffusion euqation
   ****************************************************************************/
+  start_timer(para, PHASE_COEF);
   flag = coef_diff(para, var, psi, psi0, var_type, index, BINDEX);
+  stop_timer(para, PHASE_COEF);
   if(flag!=0) {
     ffd_log("diffsuion(): Could not calculate coefficents for "
             "diffusion equation.", FFD_ERROR);
@@ -92,6 +94,73 @@ int diffusion(PARA_DATA *para, REAL **var, int var_type, int index,
   return flag;
 } // End of diffusion( )
 
+///////////////////////////////////////////////////////////////////////////////
+/// Diffusion step for several trace substances
+///
+/// The trace substances have the same diffusivity and boundary cells, so 
+/// that the coefficients of the diffusion equations are assembled only once.
+/// For each trace substance, only the source term and the values of the 
+/// boundary cells are set before the equation is solved. The results are the
+/// same as the ones of \c diffusion() called for each substance.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param nb Number of trace substances
+///\param psi psi[nb]: Pointers to the variables at current time step
+///\param psi0 psi0[nb]: Pointers to the variables at previous time step
+///\param BINDEX Pointer to boundary index
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int diffusion_species(PARA_DATA *para, REAL **var, int nb, REAL **psi,
+                      REAL **psi0, int **BINDEX) {
+  int i, j, k, n, flag = 0;
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  REAL *ap0 = var[AP0], *b = var[B];
+
+  if(nb<1) return 0;
+
+  /****************************************************************************
+  | Define the coeffcients for diffusion euqation of the first substance
+  ****************************************************************************/
+  start_timer(para, PHASE_COEF);
+  flag = coef_diff(para, var, psi[0], psi0[0], TRACE, 0, BINDEX);
+  stop_timer(para, PHASE_COEF);
+  if(flag!=0) {
+    ffd_log("diffusion_species(): Could not calculate coefficents for "
+            "diffusion equation.", FFD_ERROR);
+    return flag;
+  }
+
+  for(n=0; n<nb; n++) {
+    // Set the boundary values and the source term of the other substances
+    if(n>0) {
+      set_bnd(para, var, TRACE, n, psi[n], BINDEX);
+      for(k=1; k<=kmax; k++)
+        for(j=1; j<=jmax; j++)
+          for(i=1; i<=imax; i++)
+            b[IX(i,j,k)] = psi0[n][IX(i,j,k)]*ap0[IX(i,j,k)];
+    }
+
+    // Solve the equations
+    equ_solver(para, var, TRACE, psi[n]);
+
+    // Define B.C.
+    set_bnd(para, var, TRACE, n, psi[n], BINDEX);
+
+    // Check residual
+    if(para->solv->check_residual==1) {
+      sprintf(msg, "diffusion(): Residual of Trace %d is %f",
+              n, check_residual(para, var, psi[n]));
+      ffd_log(msg, FFD_NORMAL);
+    }
+  }
+
+  return flag;
+} // End of diffusion_species( )
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Calcuate coefficients for difussion equation solver
 ///
@@ -107,14 +176,16 @@ int diffusion(PARA_DATA *para, REAL **var, int var_type, int index,
 ///////////////////////////////////////////////////////////////////////////////
 int coef_diff(PARA_DATA *para, REAL **var, REAL *psi, REAL *psi0, 
                int var_type, int index, int **BINDEX) {
-  int i, j, k;
+  int i, j, k, flag = 0;
   int imax = para->geom->imax, jmax = para->geom->jmax;
   int kmax = para->geom->kmax;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
   REAL *aw = var[AW], *ae = var[AE], *as = var[AS], *an = var[AN];
   REAL *af = var[AF], *ab = var[AB], *ap = var[AP], *ap0 = var[AP0], *b = var[B];
-  REAL *x = var[X], *y = var[Y], *z = var[Z];
-  REAL *gx = var[GX], *gy = var[GY], *gz = var[GZ];
+  REAL *lx = para->geom->metric->lx, *ly = para->geom->metric->ly;
+  REAL *lz = para->geom->metric->lz;
+  REAL *dxc = para->geom->metric->dxc, *dyc = para->geom->metric->dyc;
+  REAL *dzc = para->geom->metric->dzc;
   REAL *pp = var[PP];
   REAL *Temp = var[TEMP];
   REAL dxe, dxw, dyn, dys, dzf, dzb, Dx, Dy, Dz;
@@ -123,184 +194,238 @@ int coef_diff(PARA_DATA *para, REAL **var, REAL *psi, REAL *psi0,
   REAL gravx = para->prob->gravx, gravy = para->prob->gravy,
        gravz = para->prob->gravz;
   REAL kapa;
+  REAL *nu; // Diffusivity of the cells in one row
+  int chen = para->prob->tur_model==CHEN;
+
+  nu = (REAL *) malloc((imax+2)*sizeof(REAL));
+  if(nu==NULL) {
+    ffd_log("coef_diff(): Could not allocate memory for nu.", FFD_ERROR);
+    return 1;
+  }
 
   // define kapa
   switch(var_type) {
-    /*-------------------------------------------------------------------------
-    | X-velocity
-    -------------------------------------------------------------------------*/
     case VX:
+    case VY:
+    case VZ:
       if(para->prob->tur_model==LAM)
         kapa = para->prob->nu; 
-      else if(para->prob->tur_model==CONSTANT) 
-        kapa = 101.0f * para->prob->nu;
-
-      FOR_U_CELL
-        dxe = gx[IX(i+1,j  ,k)] - gx[IX(i  ,j,k)];
-        dxw = gx[IX(i  ,j  ,k)] - gx[IX(i-1,j,k)];
-        dyn =  y[IX(i  ,j+1,k)] -  y[IX(i  ,j,k)];
-        dys =  y[IX(i,j,k)] -      y[IX(i,j-1,k)];
-        dzf =  z[IX(i,j,k+1)] -    z[IX(i,j,k)];
-        dzb =  z[IX(i,j,k)] -      z[IX(i,j,k-1)];
-        Dx =   x[IX(i+1,j,k)] -    x[IX(i,j,k)];
-        Dy =  gy[IX(i,j,k)] -     gy[IX(i,j-1,k)];
-        Dz =  gz[IX(i,j,k)] -     gz[IX(i,j,k-1)];
-
-        if(para->prob->tur_model==CHEN)
-          kapa = nu_t_chen_zero_equ(para, var, i, j, k);
+      else
+        kapa = (REAL) 101.0 * para->prob->nu;
+      break;
+    default:
+      if(para->prob->tur_model == LAM)   
+        kapa = para->prob->alpha; 
+      else
+        kapa = (REAL) 101.0 * para->prob->alpha;
+      break;
+  }
+  for(i=0; i<=imax+1; i++)
+    nu[i] = kapa;
 
-        aw[IX(i,j,k)] = kapa*Dy*Dz/dxw;
-        ae[IX(i,j,k)] = kapa*Dy*Dz/dxe;
-        an[IX(i,j,k)] = kapa*Dx*Dz/dyn;
-        as[IX(i,j,k)] = kapa*Dx*Dz/dys;
-        af[IX(i,j,k)] = kapa*Dx*Dy/dzf;
-        ab[IX(i,j,k)] = kapa*Dx*Dy/dzb;
-        ap0[IX(i,j,k)] = Dx*Dy*Dz/dt;
-        b[IX(i,j,k)] = psi0[IX(i,j,k)]*ap0[IX(i,j,k)]
-                     - beta*gravx*(Temp[IX(i,j,k)]-Temp_Buoyancy)*Dx*Dy*Dz
-                     + (pp[IX(i,j,k)]-pp[IX(i+1,j,k)])*Dy*Dz;
-      END_FOR
+  /****************************************************************************
+  | The coefficients and AP are computed in one pass. The loops run with I
+  | innermost, so that the cells of one row are vectorized if the code is
+  | compiled with OpenMP SIMD support. The turbulent viscosity of a row is
+  | computed before the row. The lengths are taken from the cached metrics,
+  | so that the ones in Y and Z direction are constant along a row.
+  ****************************************************************************/
+  switch(var_type) {
+    /*-------------------------------------------------------------------------
+    | X-velocity
+    -------------------------------------------------------------------------*/
+    case VX:
+      for(k=1; k<=kmax; k++)
+        for(j=1; j<=jmax; j++) {
+          if(chen)
+            for(i=1; i<=imax-1; i++)
+              nu[i] = nu_t_chen_zero_equ(para, var, i, j, k);
+          dyn = dyc[j];
+          dys = dyc[j-1];
+          dzf = dzc[k];
+          dzb = dzc[k-1];
+          Dy = ly[j];
+          Dz = lz[k];
+#pragma omp simd private(dxe, dxw, Dx)
+          for(i=1; i<=imax-1; i++) {
+            dxe = lx[i+1];
+            dxw = lx[i];
+            Dx = dxc[i];
 
-      //set_bnd(para, var, var_type, psi, BINDEX);
-      FOR_U_CELL
-          ap[IX(i,j,k)] = ap0[IX(i,j,k)] + ae[IX(i,j,k)] + aw[IX(i,j,k)] 
-                        + an[IX(i,j,k)]  + as[IX(i,j,k)] + af[IX(i,j,k)] 
-                        + ab[IX(i,j,k)];
-      END_FOR
+            aw[IX(i,j,k)] = nu[i]*Dy*Dz/dxw;
+            ae[IX(i,j,k)] = nu[i]*Dy*Dz/dxe;
+            an[IX(i,j,k)] = nu[i]*Dx*Dz/dyn;
+            as[IX(i,j,k)] = nu[i]*Dx*Dz/dys;
+            af[IX(i,j,k)] = nu[i]*Dx*Dy/dzf;
+            ab[IX(i,j,k)] = nu[i]*Dx*Dy/dzb;
+            ap0[IX(i,j,k)] = Dx*Dy*Dz/dt;
+            b[IX(i,j,k)] = psi0[IX(i,j,k)]*ap0[IX(i,j,k)]
+                         - beta*gravx*(Temp[IX(i,j,k)]-Temp_Buoyancy)*Dx*Dy*Dz
+                         + (pp[IX(i,j,k)]-pp[IX(i+1,j,k)])*Dy*Dz;
+            ap[IX(i,j,k)] = ap0[IX(i,j,k)] + ae[IX(i,j,k)] + aw[IX(i,j,k)] 
+                          + an[IX(i,j,k)]  + as[IX(i,j,k)] + af[IX(i,j,k)] 
+                          + ab[IX(i,j,k)];
+          }
+        }
       break;
     /*-------------------------------------------------------------------------
     | Y-velocity
     -------------------------------------------------------------------------*/ 
     case VY:
-      if(para->prob->tur_model==LAM)
-        kapa = para->prob->nu; 
-      else if(para->prob->tur_model==CONSTANT) 
-        kapa = (REAL) 101.0 * para->prob->nu;
-
-      FOR_V_CELL
-        dxe = x[IX(i+1,j,k)] - x[IX(i,j,k)];
-        dxw = x[IX(i,j,k)] - x[IX(i-1,j,k)];
-        dyn = gy[IX(i,j+1,k)] - gy[IX(i,j,k)];
-        dys = gy[IX(i,j,k)] - gy[IX(i,j-1,k)];
-        dzf = z[IX(i,j,k+1)] - z[IX(i,j,k)];
-        dzb = z[IX(i,j,k)] - z[IX(i,j,k-1)];
-        Dx = gx[IX(i,j,k)] - gx[IX(i-1,j,k)];
-        Dy = y[IX(i,j+1,k)] - y[IX(i,j,k)];
-        Dz = gz[IX(i,j,k)] - gz[IX(i,j,k-1)];
+      for(k=1; k<=kmax; k++)
+        for(j=1; j<=jmax-1; j++) {
+          if(chen)
+            for(i=1; i<=imax; i++)
+              nu[i] = nu_t_chen_zero_equ(para, var, i, j, k);
+          dyn = ly[j+1];
+          dys = ly[j];
+          dzf = dzc[k];
+          dzb = dzc[k-1];
+          Dy = dyc[j];
+          Dz = lz[k];
+#pragma omp simd private(dxe, dxw, Dx)
+          for(i=1; i<=imax; i++) {
+            dxe = dxc[i];
+            dxw = dxc[i-1];
+            Dx = lx[i];
 
-        if(para->prob->tur_model==CHEN)
-          kapa = nu_t_chen_zero_equ(para, var, i, j, k);
-
-        aw[IX(i,j,k)] = kapa*Dy*Dz/dxw;
-        ae[IX(i,j,k)] = kapa*Dy*Dz/dxe;
-        an[IX(i,j,k)] = kapa*Dx*Dz/dyn;
-        as[IX(i,j,k)] = kapa*Dx*Dz/dys;
-        af[IX(i,j,k)] = kapa*Dx*Dy/dzf;
-        ab[IX(i,j,k)] = kapa*Dx*Dy/dzb;
-        ap0[IX(i,j,k)] = Dx*Dy*Dz/dt;
-        b[IX(i,j,k)] = psi0[IX(i,j,k)]*ap0[IX(i,j,k)]
-                     - beta*gravy*(Temp[IX(i,j,k)]-Temp_Buoyancy)*Dx*Dy*Dz
-                     + (pp[IX(i,j,k)]-pp[IX(i ,j+1,k)])*Dx*Dz;
-      END_FOR
-
-      //set_bnd(para, var, var_type, psi,BINDEX);
-      FOR_V_CELL
-        ap[IX(i,j,k)] = ap0[IX(i,j,k)] + ae[IX(i,j,k)] + aw[IX(i,j,k)] 
-                      + an[IX(i,j,k)] + as[IX(i,j,k)] + af[IX(i,j,k)] 
-                      + ab[IX(i,j,k)];
-      END_FOR
+            aw[IX(i,j,k)] = nu[i]*Dy*Dz/dxw;
+            ae[IX(i,j,k)] = nu[i]*Dy*Dz/dxe;
+            an[IX(i,j,k)] = nu[i]*Dx*Dz/dyn;
+            as[IX(i,j,k)] = nu[i]*Dx*Dz/dys;
+            af[IX(i,j,k)] = nu[i]*Dx*Dy/dzf;
+            ab[IX(i,j,k)] = nu[i]*Dx*Dy/dzb;
+            ap0[IX(i,j,k)] = Dx*Dy*Dz/dt;
+            b[IX(i,j,k)] = psi0[IX(i,j,k)]*ap0[IX(i,j,k)]
+                         - beta*gravy*(Temp[IX(i,j,k)]-Temp_Buoyancy)*Dx*Dy*Dz
+                         + (pp[IX(i,j,k)]-pp[IX(i ,j+1,k)])*Dx*Dz;
+            ap[IX(i,j,k)] = ap0[IX(i,j,k)] + ae[IX(i,j,k)] + aw[IX(i,j,k)] 
+                          + an[IX(i,j,k)] + as[IX(i,j,k)] + af[IX(i,j,k)] 
+                          + ab[IX(i,j,k)];
+          }
+        }
       break;
     /*-------------------------------------------------------------------------
     | Z-velocity
     -------------------------------------------------------------------------*/
     case VZ:
-      if(para->prob->tur_model==LAM)   
-        kapa = para->prob->nu; 
-      else if(para->prob->tur_model==CONSTANT) 
-        kapa = (REAL) 101.0 * para->prob->nu;
-        
-      FOR_W_CELL
-        dxe = x[IX(i+1,j,k)] - x[IX(i,j,k)];
-        dxw = x[IX(i,j,k)] - x[IX(i-1,j,k)];
-        dyn = y[IX(i,j+1,k)] - y[IX(i,j,k)];
-        dys = y[IX(i,j,k)] - y[IX(i,j-1,k)];
-        dzf = gz[IX(i,j,k+1)] - gz[IX(i,j,k)];
-        dzb = gz[IX(i,j,k)] - gz[IX(i,j,k-1)];
-        Dx = gx[IX(i,j,k)] - gx[IX(i-1,j,k)];
-        Dy = gy[IX(i,j,k)] - gy[IX(i,j-1,k)];
-        Dz = z[IX(i,j,k+1)] - z[IX(i,j,k)];
-
-        if(para->prob->tur_model==CHEN)
-          kapa = nu_t_chen_zero_equ(para, var, i, j, k);
-
-        aw[IX(i,j,k)] = kapa*Dy*Dz/dxw;
-        ae[IX(i,j,k)] = kapa*Dy*Dz/dxe;
-        an[IX(i,j,k)] = kapa*Dx*Dz/dyn;
-        as[IX(i,j,k)] = kapa*Dx*Dz/dys;
-        af[IX(i,j,k)] = kapa*Dx*Dy/dzf;
-        ab[IX(i,j,k)] = kapa*Dx*Dy/dzb;
-        ap0[IX(i,j,k)] = Dx*Dy*Dz/dt;
-        b[IX(i,j,k)] = psi0[IX(i,j,k)]*ap0[IX(i,j,k)]
-                     - beta*gravz*(Temp[IX(i,j,k)]-Temp_Buoyancy)*Dx*Dy*Dz
-                     + (pp[IX(i,j,k)]-pp[IX(i ,j,k+1)])*Dy*Dx;
-      END_FOR
+      for(k=1; k<=kmax-1; k++)
+        for(j=1; j<=jmax; j++) {
+          if(chen)
+            for(i=1; i<=imax; i++)
+              nu[i] = nu_t_chen_zero_equ(para, var, i, j, k);
+          dyn = dyc[j];
+          dys = dyc[j-1];
+          dzf = lz[k+1];
+          dzb = lz[k];
+          Dy = ly[j];
+          Dz = dzc[k];
+#pragma omp simd private(dxe, dxw, Dx)
+          for(i=1; i<=imax; i++) {
+            dxe = dxc[i];
+            dxw = dxc[i-1];
+            Dx = lx[i];
 
-      //set_bnd(para, var, var_type, psi, BINDEX);
-
-      FOR_W_CELL
-        ap[IX(i,j,k)] = ap0[IX(i,j,k)] + ae[IX(i,j,k)] + aw[IX(i,j,k)] 
-                      +  an[IX(i,j,k)] + as[IX(i,j,k)] + af[IX(i,j,k)] 
-                      + ab[IX(i,j,k)];
-      END_FOR
+            aw[IX(i,j,k)] = nu[i]*Dy*Dz/dxw;
+            ae[IX(i,j,k)] = nu[i]*Dy*Dz/dxe;
+            an[IX(i,j,k)] = nu[i]*Dx*Dz/dyn;
+            as[IX(i,j,k)] = nu[i]*Dx*Dz/dys;
+            af[IX(i,j,k)] = nu[i]*Dx*Dy/dzf;
+            ab[IX(i,j,k)] = nu[i]*Dx*Dy/dzb;
+            ap0[IX(i,j,k)] = Dx*Dy*Dz/dt;
+            b[IX(i,j,k)] = psi0[IX(i,j,k)]*ap0[IX(i,j,k)]
+                         - beta*gravz*(Temp[IX(i,j,k)]-Temp_Buoyancy)*Dx*Dy*Dz
+                         + (pp[IX(i,j,k)]-pp[IX(i ,j,k+1)])*Dy*Dx;
+            ap[IX(i,j,k)] = ap0[IX(i,j,k)] + ae[IX(i,j,k)] + aw[IX(i,j,k)] 
+                          +  an[IX(i,j,k)] + as[IX(i,j,k)] + af[IX(i,j,k)] 
+                          + ab[IX(i,j,k)];
+          }
+        }
       break;
     /*-------------------------------------------------------------------------
     | Scalar Variable
     -------------------------------------------------------------------------*/
     case TEMP:
     case TRACE:
-      if(para->prob->tur_model == LAM)   
-        kapa = para->prob->alpha; 
-      else if(para->prob->tur_model == CONSTANT) 
-        kapa = (REAL) 101.0 * para->prob->alpha;
+      for(k=1; k<=kmax; k++)
+        for(j=1; j<=jmax; j++) {
+          dyn = dyc[j];
+          dys = dyc[j-1];
+          dzf = dzc[k];
+          dzb = dzc[k-1];
+          Dy = ly[j];
+          Dz = lz[k];
+#pragma omp simd private(dxe, dxw, Dx)
+          for(i=1; i<=imax; i++) {
+            dxe = dxc[i];
+            dxw = dxc[i-1];
+            Dx = lx[i];
 
-      FOR_EACH_CELL
-        dxe = x[IX(i+1,j,k)] - x[IX(i,j,k)];
-        dxw = x[IX(i,j,k)] - x[IX(i-1,j,k)];
-        dyn = y[IX(i,j+1,k)] - y[IX(i,j,k)];
-        dys = y[IX(i,j,k)] - y[IX(i,j-1,k)];
-        dzf = z[IX(i,j,k+1)] - z[IX(i,j,k)];
-        dzb = z[IX(i,j,k)] - z[IX(i,j,k-1)];
-        Dx = gx[IX(i,j,k)] - gx[IX(i-1,j,k)];
-        Dy = gy[IX(i,j,k)] - gy[IX(i,j-1,k)];
-        Dz = gz[IX(i,j,k)] - gz[IX(i,j,k-1)];
- 
-        aw[IX(i,j,k)] = kapa*Dy*Dz/dxw;
-        ae[IX(i,j,k)] = kapa*Dy*Dz/dxe;
-        an[IX(i,j,k)] = kapa*Dx*Dz/dyn;
-        as[IX(i,j,k)] = kapa*Dx*Dz/dys;
-        af[IX(i,j,k)] = kapa*Dx*Dy/dzf;
-        ab[IX(i,j,k)] = kapa*Dx*Dy/dzb;
-        ap0[IX(i,j,k)] = Dx*Dy*Dz/dt;
-        b[IX(i,j,k)] = psi0[IX(i,j,k)]*ap0[IX(i,j,k)];
-      END_FOR
+            aw[IX(i,j,k)] = kapa*Dy*Dz/dxw;
+            ae[IX(i,j,k)] = kapa*Dy*Dz/dxe;
+            an[IX(i,j,k)] = kapa*Dx*Dz/dyn;
+            as[IX(i,j,k)] = kapa*Dx*Dz/dys;
+            af[IX(i,j,k)] = kapa*Dx*Dy/dzf;
+            ab[IX(i,j,k)] = kapa*Dx*Dy/dzb;
+            ap0[IX(i,j,k)] = Dx*Dy*Dz/dt;
+            b[IX(i,j,k)] = psi0[IX(i,j,k)]*ap0[IX(i,j,k)];
+            ap[IX(i,j,k)] = ap0[IX(i,j,k)] + ae[IX(i,j,k)] + aw[IX(i,j,k)] 
+                          +  an[IX(i,j,k)] + as[IX(i,j,k)] + af[IX(i,j,k)] + ab[IX(i,j,k)];
+          }
+        }
 
+      // The boundary conditions only change the coefficients of the
+      // neighbors of the boundary cells, whose AP is computed again
       set_bnd(para, var, var_type, index, psi, BINDEX);
-
-      FOR_EACH_CELL
-        ap[IX(i,j,k)] = ap0[IX(i,j,k)] + ae[IX(i,j,k)] + aw[IX(i,j,k)] 
-                      +  an[IX(i,j,k)] + as[IX(i,j,k)] + af[IX(i,j,k)] + ab[IX(i,j,k)];
-      END_FOR
+      coef_ap_boundary(para, var, BINDEX);
       break;
     default:
       sprintf(msg, "coe_diff(): No function for variable type %d", var_type);
       ffd_log(msg, FFD_ERROR);
-      return 1;
+      flag = 1;
       break;
   }
 
-  return 0;
+  free(nu);
+  return flag;
 }// End of coef_diff( )
 
+///////////////////////////////////////////////////////////////////////////////
+/// Calculate AP of the neighbors of the boundary cells
+///
+/// This is used after the boundary conditions have changed the coefficients
+/// toward the boundary cells.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param BINDEX Pointer to boundary index
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void coef_ap_boundary(PARA_DATA *para, REAL **var, int **BINDEX) {
+  int i, j, k, it, n;
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int index = para->geom->index;
+  REAL *aw = var[AW], *ae = var[AE], *as = var[AS], *an = var[AN];
+  REAL *af = var[AF], *ab = var[AB], *ap = var[AP], *ap0 = var[AP0];
+  int di[6] = {1, -1, 0, 0, 0, 0};
+  int dj[6] = {0, 0, 1, -1, 0, 0};
+  int dk[6] = {0, 0, 0, 0, 1, -1};
+
+  for(it=0; it<index; it++)
+    for(n=0; n<6; n++) {
+      i = BINDEX[0][it] + di[n];
+      j = BINDEX[1][it] + dj[n];
+      k = BINDEX[2][it] + dk[n];
+      if(i<1 || i>imax || j<1 || j>jmax || k<1 || k>kmax) continue;
+
+      ap[IX(i,j,k)] = ap0[IX(i,j,k)] + ae[IX(i,j,k)] + aw[IX(i,j,k)] 
+                    +  an[IX(i,j,k)] + as[IX(i,j,k)] + af[IX(i,j,k)] + ab[IX(i,j,k)];
+    }
+} // End of coef_ap_boundary()
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Calcuate source term in the difussion equation
 ///
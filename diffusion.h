@@ -62,6 +62,27 @@
 int diffusion(PARA_DATA *para, REAL **var, int var_type, int index,
                REAL *psi, REAL *psi0, int **BINDEX);
 
+///////////////////////////////////////////////////////////////////////////////
+/// Diffusion step for several trace substances
+///
+/// The trace substances have the same diffusivity and boundary cells, so 
+/// that the coefficients of the diffusion equations are assembled only once.
+/// For each trace substance, only the source term and the values of the 
+/// boundary cells are set before the equation is solved. The results are the
+/// same as the ones of \c diffusion() called for each substance.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param nb Number of trace substances
+///\param psi psi[nb]: Pointers to the variables at current time step
+///\param psi0 psi0[nb]: Pointers to the variables at previous time step
+///\param BINDEX Pointer to boundary index
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int diffusion_species(PARA_DATA *para, REAL **var, int nb, REAL **psi,
+                      REAL **psi0, int **BINDEX);
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Calcuate coefficients for difussion equation solver
 ///
@@ -78,6 +99,20 @@ int diffusion(PARA_DATA *para, REAL **var, int var_type, int index,
 int coef_diff(PARA_DATA *para, REAL **var, REAL *psi, REAL *psi0, 
                int var_type, int index, int **BINDEX);
 
+///////////////////////////////////////////////////////////////////////////////
+/// Calculate AP of the neighbors of the boundary cells
+///
+/// This is used after the boundary conditions have changed the coefficients
+/// toward the boundary cells.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param BINDEX Pointer to boundary index
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void coef_ap_boundary(PARA_DATA *para, REAL **var, int **BINDEX);
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Calcuate source term in the difussion equation
 ///
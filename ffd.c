@@ -17,54 +17,68 @@
 
 #include "ffd.h"
 
-/* global variables */
-REAL **var;
-int  **BINDEX;
-REAL *locmin,*locmax;
-
-static GEOM_DATA geom;
-static PROB_DATA prob;
-static TIME_DATA mytime;
-static INPU_DATA inpu;
-static OUTP_DATA outp1;
-static BC_DATA bc;
-static SOLV_DATA solv;
-static SENSOR_DATA sens;
-static INIT_DATA init;
-
-clock_t start, end;
+// Instance shown in the GLUT window of the demo version
+static FFD_INSTANCE *demo;
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Allcoate memory for variables
 ///
-///\param para Pointer to FFD parameters
+///\param inst Pointer to the FFD instance
 ///
 ///\return No return needed
 ///////////////////////////////////////////////////////////////////////////////
-int allocate_memory (PARA_DATA *para) {
+int allocate_memory (FFD_INSTANCE *inst) {
+  PARA_DATA *para = &inst->para;
+  REAL **var;
+  int **BINDEX;
+  int nb_var, i, k;
+  int size = (para->geom->imax+2) * (para->geom->jmax+2)
+           * (para->geom->kmax+2);
+  int IJMAX = (para->geom->imax+2) * (para->geom->jmax+2);
+  int stride, stride_index;
+  size_t arena_size;
+  REAL *arena;
 
-  int nb_var, i;
-  int size = (geom.imax+2) * (geom.jmax+2) * (geom.kmax+2);
+  /****************************************************************************
+  | Allocate one arena for the variables and the boundary cells
+  | Each variable is padded to a multiple of FFD_ALIGN bytes so that all of
+  | them start at an aligned address
+  ****************************************************************************/
+  nb_var = NB_VAR(para);
+  stride = (int) ((size*sizeof(REAL) + FFD_ALIGN-1) / FFD_ALIGN * FFD_ALIGN
+                  / sizeof(REAL));
+  stride_index = (int) ((size*sizeof(int) + FFD_ALIGN-1) / FFD_ALIGN
+                        * FFD_ALIGN / sizeof(int));
+  arena_size = (size_t) nb_var * stride * sizeof(REAL)
+             + (size_t) 5 * stride_index * sizeof(int);
+
+  arena = (REAL *) ffd_aligned_malloc(arena_size);
+  if(arena==NULL) {
+    sprintf(msg, "allocate_memory(): Could not allocate %lu bytes for "
+            "the variables", (unsigned long) arena_size);
+    ffd_log(msg, FFD_ERROR);
+    return 1;
+  }
 
   /****************************************************************************
   | Allocate memory for variables
   ****************************************************************************/
-  nb_var = 46 + para->bc->nb_Xi + para->bc->nb_C;
   var       = (REAL **) malloc ( nb_var*sizeof(REAL*) );
   if(var==NULL) {
     ffd_log("allocate_memory(): Could not allocate memory for var.",
             FFD_ERROR);
+    ffd_aligned_free(arena);
     return 1;
   }
+  inst->var = var;
 
   for(i=0; i<nb_var; i++) {
-    var[i] = (REAL *) calloc(size, sizeof(REAL));
-    if(var[i]==NULL) {
-      sprintf(msg, 
-              "allocate_memory(): Could not allocate memory for var[%d]", i);
-      ffd_log(msg, FFD_ERROR);
-      return 1;
-    }
+    var[i] = arena + (size_t) i * stride;
+    // Set the values to zero plane by plane in the same order as the solvers
+    // run in parallel, so that the pages are placed on their NUMA nodes
+#pragma omp parallel for schedule(static)
+    for(k=0; k<=para->geom->kmax+1; k++)
+      memset(var[i]+k*IJMAX, 0, IJMAX*sizeof(REAL));
   }
 
   /****************************************************************************
@@ -82,14 +96,12 @@ int allocate_memory (PARA_DATA *para) {
     return 1;
   }
 
-  for(i=0; i<5; i++)
-    BINDEX[i] = (int *) malloc(size*sizeof(int));
-    if(BINDEX[i]==NULL) {
-      sprintf(msg, 
-              "allocate_memory(): Could not allocate memory for BINDEX[%d]", i);
-      ffd_log(msg, FFD_ERROR);
-      return 1;
-    }
+  for(i=0; i<5; i++) {
+    BINDEX[i] = (int *) (arena + (size_t) nb_var * stride)
+              + (size_t) i * stride_index;
+    memset(BINDEX[i], 0, size*sizeof(int));
+  }
+  inst->BINDEX = BINDEX;
 
   return 0;
 } // End of allocate_memory()
@@ -100,7 +112,7 @@ int allocate_memory (PARA_DATA *para) {
 ///\return No return needed
 ///////////////////////////////////////////////////////////////////////////////
 static void display_func(void) {
-  ffd_display_func(&para, var);
+  ffd_display_func(&demo->para, demo->var);
 } // End of display_func()
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -114,7 +126,7 @@ static void display_func(void) {
 ///////////////////////////////////////////////////////////////////////////////
 
 static void key_func(unsigned char key, int x, int y) {
-  ffd_key_func(&para, var, BINDEX, key);
+  ffd_key_func(&demo->para, demo->var, demo->BINDEX, key);
 } // End of key_func()
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -123,7 +135,7 @@ static void key_func(unsigned char key, int x, int y) {
 ///\return No return needed
 ///////////////////////////////////////////////////////////////////////////////
 static void idle_func(void) {
-  ffd_idle_func(&para, var, BINDEX);
+  ffd_idle_func(&demo->para, demo->var, demo->BINDEX);
 } // End of idle_func()
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -135,7 +147,7 @@ static void idle_func(void) {
 ///\return No return needed
 ///////////////////////////////////////////////////////////////////////////////
 static void motion_func(int x, int y) {
-  ffd_motion_func(&para, x, y);
+  ffd_motion_func(&demo->para, x, y);
 } // End of motion_func()
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -148,7 +160,7 @@ static void motion_func(int x, int y) {
 ///\return No return needed
 ///////////////////////////////////////////////////////////////////////////////
 static void mouse_func(int button, int state, int x, int y) {
-  ffd_mouse_func(&para, button, state, x, y);
+  ffd_mouse_func(&demo->para, button, state, x, y);
 } // End of mouse_func()
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -171,10 +183,10 @@ static void open_glut_window() {
   | void glutInitWindowSize(int width, int height);
   | width: Width in pixels; height: Height in pixels
   ---------------------------------------------------------------------------*/
-  glutInitWindowSize(para.outp->winx, para.outp->winy);
+  glutInitWindowSize(demo->para.outp->winx, demo->para.outp->winy);
   
 
-  para.outp->win_id = glutCreateWindow("FFD, Author: W. Zuo, Q. Chen");
+  demo->para.outp->win_id = glutCreateWindow("FFD, Author: W. Zuo, Q. Chen");
 
   /*---------------------------------------------------------------------------
   |void glClearColor(GLclampf red, GLclampf green, GLclampf blue,
@@ -200,7 +212,7 @@ static void open_glut_window() {
   glClear(GL_COLOR_BUFFER_BIT);
   glutSwapBuffers();
 
-  pre_2d_display(&para);
+  pre_2d_display(&demo->para);
 
   /*---------------------------------------------------------------------------
   | void glutKeyboardFunc(void (*func)(unsigned char key, int x, int y));
@@ -253,114 +265,244 @@ static void open_glut_window() {
 ///\return No return needed
 ///////////////////////////////////////////////////////////////////////////////
 static void reshape_func(int width, int height) {
-  ffd_reshape_func(&para, width, height);
+  ffd_reshape_func(&demo->para, width, height);
 } // End of reshape_func()
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Lanuch the FFD simulation through a thread
 ///
-///\param p Pointer to the cosimulaiton data
+/// The thread owns the instance and frees it when the simulation ends.
+///
+///\param p Pointer to the FFD instance
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
 #ifdef _MSC_VER //Windows
 DWORD WINAPI ffd_thread(void *p){ 
-  ULONG workerID = (ULONG)(ULONG_PTR)p;
 #else //Linux
-void  ffd_thread(void* p){
+void *ffd_thread(void *p){
 #endif
-
-  CosimulationData *cosim = (CosimulationData *) p;
+  FFD_INSTANCE *inst = (FFD_INSTANCE *) p;
+  CosimulationData *cosim = inst->para.cosim;
   int cosimulation = 1;
+  char name[40];
+
+  // The first instance writes into log.ffd and the others into their own file
+  if(inst->outp.id>1) {
+    output_name(&inst->para, "log", name);
+    strcat(name, ".ffd");
+    if(ffd_log_open(name)==0) {
+      sprintf(msg, "ffd_thread(): Start FFD instance %d.", inst->outp.id);
+      ffd_log(msg, FFD_NEW);
+    }
+  }
 
 #ifdef _MSC_VER //Windows
-  sprintf(msg, "Start Fast Fluid Dynamics Simulation with Thread ID %lu", workerID);
+  sprintf(msg, "Start Fast Fluid Dynamics Simulation with Thread ID %lu",
+          GetCurrentThreadId());
 #else //Linux
   sprintf(msg, "Start Fast Fluid Dynamics Simulation with Thread");
 #endif
 
   printf("%s\n", msg);
-  ffd_log(msg, FFD_NEW);
+  ffd_log(msg, FFD_NORMAL);
 
   sprintf(msg, "fileName=\"%s\"", cosim->para->fileName);
   ffd_log(msg, FFD_NORMAL);
 
-  para.cosim = (CosimulationData *) malloc(sizeof(CosimulationData)); 
-  para.cosim = cosim;
-
-  if(ffd(cosimulation)!=0)
+  if(ffd_run(inst, cosimulation)!=0)
     cosim->para->ffdError = 1;
 
+  free_ffd_instance(inst);
+
   ffd_log("Successfully exit FFD.", FFD_NORMAL);
+  ffd_log_flush();
   return 0;
 } // End of ffd_thread()
 
 ///////////////////////////////////////////////////////////////////////////////
-/// Main routine of FFD
+/// Main routine of FFD for a stand alone simulation
 ///
 ///\para cosimulation Integer to identify the simulation type
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
 int ffd(int cosimulation) {
-  // Initialize the parameters
-  para.geom = &geom;
-  para.inpu = &inpu;
-  para.outp = &outp1;
-  para.prob = &prob;
-  para.mytime = &mytime;
-  para.bc     = &bc;
-  para.solv   = &solv;
-  para.sens   = &sens;
-  para.init   = &init;
+  FFD_INSTANCE *inst;
+  int flag;
+
+  inst = new_ffd_instance(NULL);
+  if(inst==NULL) {
+    ffd_log("ffd(): Could not allocate memory for the FFD instance.",
+            FFD_ERROR);
+    return 1;
+  }
+
+  flag = ffd_run(inst, cosimulation);
+  free_ffd_instance(inst);
+  ffd_log_flush();
+
+  return flag;
+} // End of ffd( )
+
+///////////////////////////////////////////////////////////////////////////////
+/// Create an FFD instance
+///
+///\param cosim Pointer to the cosimulation data, NULL for a stand alone
+///             simulation
+///
+///\return Pointer to the instance, NULL if an error occurred
+///////////////////////////////////////////////////////////////////////////////
+FFD_INSTANCE *new_ffd_instance(CosimulationData *cosim) {
+  FFD_INSTANCE *inst;
+
+  inst = (FFD_INSTANCE *) calloc(1, sizeof(FFD_INSTANCE));
+  if(inst==NULL) return NULL;
+
+  inst->para.geom = &inst->geom;
+  inst->para.inpu = &inst->inpu;
+  inst->para.outp = &inst->outp;
+  inst->para.prob = &inst->prob;
+  inst->para.mytime = &inst->mytime;
+  inst->para.bc = &inst->bc;
+  inst->para.solv = &inst->solv;
+  inst->para.sens = &inst->sens;
+  inst->para.init = &inst->init;
+  inst->para.cosim = cosim;
+
+  return inst;
+} // End of new_ffd_instance()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free an FFD instance and the memory of its simulation
+///
+///\param inst Pointer to the FFD instance
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_ffd_instance(FFD_INSTANCE *inst) {
+  if(inst==NULL) return;
+  free_ffd_memory(inst);
+  free(inst);
+} // End of free_ffd_instance()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free the memory of the simulation of an FFD instance
+///
+/// The memory which has already been freed is skipped, so that the function
+/// can be called again after an error.
+///
+///\param inst Pointer to the FFD instance
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_ffd_memory(FFD_INSTANCE *inst) {
+  PARA_DATA *para = &inst->para;
+
+  free_snapshot_data(para);
+  free_data(inst->var);
+  free_index(inst->BINDEX);
+  inst->var = NULL;
+  inst->BINDEX = NULL;
+  free_mg_data(para);
+  free_tdma_data(para);
+  free_pcg_data(para);
+  free_trace_data(para);
+  free_steady_data(para);
+  free_metric(para);
+  free_cosim_lag_data(para);
+  free_profile_data(para);
+} // End of free_ffd_memory()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Run the simulation of an FFD instance
+///
+///\param inst Pointer to the FFD instance
+///\para cosimulation Integer to identify the simulation type
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int ffd_run(FFD_INSTANCE *inst, int cosimulation) {
+  PARA_DATA *para = &inst->para;
+  char name[40];
+
   // Stand alone simulation: 0; Cosimulaiton: 1
-  para.solv->cosimulation = cosimulation; 
+  para->solv->cosimulation = cosimulation; 
 
-#ifndef _MSC_VER //Linux
-  //Initialize glut library
-  char fakeParam[] = "fake";
-  char *fakeargv[] = { fakeParam, NULL };
-  int fakeargc = 1;
-  glutInit( &fakeargc, fakeargv );
+  if(initialize(para)!=0) {
+    ffd_log("ffd(): Could not initialize simulation parameters.", FFD_ERROR);
+    return 1;
+  }
+
+#ifdef _OPENMP
+  // Share the cores between the instances running at the same time
+  if(para->solv->nb_thread>0)
+    omp_set_num_threads(para->solv->nb_thread);
 #endif
 
-  if(initialize(&para)!=0) {
-    ffd_log("ffd(): Could not initialize simulation parameters.", FFD_ERROR);
+  // Only keep the messages up to the log level of the simulation. The
+  // OpenMP threads log into the file of the instance as well. The settings
+  // are thread-local, so this relies on the runtime reusing the threads of
+  // this team for the later parallel regions of this thread, which the GCC
+  // and LLVM runtimes do. A thread that joins only when the team grows
+  // would log into log.ffd at level 3. The team is therefore created here
+  // with the final number of threads, which is not changed afterwards.
+  open_instance_log(para);
+#pragma omp parallel
+  open_instance_log(para);
+
+  // Time the phases of the solver
+  if(para->outp->profile==1 && allocate_profile_data(para)!=0) {
+    ffd_log("ffd(): Could not allocate memory for the timers.", FFD_ERROR);
     return 1;
   }
   
   // Overwrite the mesh and simulation data using SCI generated file
-  if(para.inpu->parameter_file_format == SCI) {
-    if(read_sci_max(&para, var)!=0) {
+  if(para->inpu->parameter_file_format == SCI) {
+    if(read_sci_max(para, inst->var)!=0) {
       ffd_log("ffd(): Could not read SCi data.", FFD_ERROR);
       return 1;
     }
   }
   
   // Allocate memory for the variables
-  if(allocate_memory(&para)!=0) {
+  if(allocate_memory(inst)!=0) {
     ffd_log("ffd(): Could not allocate memory for the simulation.", FFD_ERROR);
     return 1;
   }
 
   // Set the initial values for the simulation data
-  if(set_initial_data(&para, var, BINDEX)) {
+  if(set_initial_data(para, inst->var, inst->BINDEX)) {
     ffd_log("ffd(): Could not set initial data.", FFD_ERROR);
     return 1;
   }
 
   // Read previous simulation data as initial values
-  if(para.inpu->read_old_ffd_file==1) read_ffd_data(&para, var);
+  if(para->inpu->read_old_ffd_file==1) {
+    if(read_ffd_data(para, inst->var)!=0) {
+      ffd_log("ffd(): Could not read previous simulation data.", FFD_ERROR);
+      return 1;
+    }
+  }
 
   ffd_log("ffd.c: Start FFD solver.", FFD_NORMAL);
 
   // Solve the problem
-  if(para.outp->version==DEMO) {
+  if(para->outp->version==DEMO) {
+#ifndef _MSC_VER //Linux
+    //Initialize glut library
+    char fakeParam[] = "fake";
+    char *fakeargv[] = { fakeParam, NULL };
+    int fakeargc = 1;
+    glutInit( &fakeargc, fakeargv );
+#endif
+    // The GLUT window can only show one instance
+    demo = inst;
     open_glut_window();
     glutMainLoop();
   }
   else
-    if(FFD_solver(&para, var, BINDEX)!=0) {
+    if(FFD_solver(para, inst->var, inst->BINDEX)!=0) {
       ffd_log("ffd(): FFD solver failed.", FFD_ERROR);
       return 1;
     }
@@ -368,40 +510,68 @@ int ffd(int cosimulation) {
   /*---------------------------------------------------------------------------
   | Post Process
   ---------------------------------------------------------------------------*/
+  // Wait until the snapshots for the animation are written
+  free_snapshot_data(para);
+
+  // Write the checkpoint before the data is averaged or converted for output
+  if(para->outp->checkpoint==1) {
+    output_name(para, "checkpoint", name);
+    if(write_checkpoint(para, inst->var, name)!=0) {
+      sprintf(msg, "ffd(): Could not write the file %s.ckp.", name);
+      ffd_log(msg, FFD_ERROR);
+      return 1;
+    }
+  }
+
   // Calculate mean value
-  if(para.outp->cal_mean == 1)
-    average_time(&para, var);
+  if(para->outp->cal_mean == 1)
+    average_time(para, inst->var);
   
   // Fixme: Simulaiton stops here
-  if(write_unsteady(&para, var, "unsteady")!=0) {
-    ffd_log("FFD_solver(): Could not write the file unsteady.plt.", FFD_ERROR);
+  output_name(para, "unsteady", name);
+  if(write_unsteady(para, inst->var, name)!=0) {
+    sprintf(msg, "FFD_solver(): Could not write the file %s.plt.", name);
+    ffd_log(msg, FFD_ERROR);
     return 1;
   }
 
-  if(write_tecplot_data(&para, var, "result")!=0) {
-    ffd_log("FFD_solver(): Could not write the file result.plt.", FFD_ERROR);
+  output_name(para, "result", name);
+  if(write_tecplot_data(para, inst->var, name)!=0) {
+    sprintf(msg, "FFD_solver(): Could not write the file %s.plt.", name);
+    ffd_log(msg, FFD_ERROR);
     return 1;
   }
 
 
-  if(para.outp->version == DEBUG)
-    write_tecplot_all_data(&para, var, "result_all");
+  if(para->outp->version == DEBUG) {
+    output_name(para, "result_all", name);
+    write_tecplot_all_data(para, inst->var, name);
+  }
 
   // Write the data in SCI format
-  write_SCI(&para, var, "output");
+  output_name(para, "output", name);
+  write_SCI(para, inst->var, name);
+
+  // Write the report of the timers
+  if(para->solv->profile!=NULL) {
+    output_name(para, "profile", name);
+    if(write_profile(para, name)!=0) {
+      ffd_log("ffd(): Could not write the profile of the timers.", FFD_ERROR);
+      return 1;
+    }
+  }
 
-  // Free the memory
-  free_data(var);
-  free_index(BINDEX);
+  // Free the memory before Modelica may release the cosimulation data
+  free_ffd_memory(inst);
 
   // End the simulation
-  if(para.outp->version==DEBUG || para.outp->version==DEMO) {}//getchar();
+  if(para->outp->version==DEBUG || para->outp->version==DEMO) {}//getchar();
 
   // Inform Modelica the stopping command has been received 
-  if(para.solv->cosimulation==1) {
-    para.cosim->para->flag = 2; 
+  if(para->solv->cosimulation==1) {
+    cosim_set_flag(&para->cosim->para->flag, 2);
     ffd_log("ffd(): Sent stopping signal to Modelica", FFD_NORMAL);
   }
 
   return 0;
-} // End of ffd( )
+} // End of ffd_run()
@@ -18,6 +18,10 @@
 #define _FFD_H
 #endif
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #ifndef _DATA_STRUCTURE_H
 #define _DATA_STRUCTURE_H
 #include "data_structure.h"
@@ -43,11 +47,31 @@
 #include "utility.h"
 #endif
 
+#ifndef _SOLVER_MG_H
+#define _SOLVER_MG_H
+#include "solver_mg.h"
+#endif
+
+#ifndef _SOLVER_PCG_H
+#define _SOLVER_PCG_H
+#include "solver_pcg.h"
+#endif
+
 #ifndef _DATA_WRITER_H
 #define _DATA_WRITER_H
 #include "data_writer.h"
 #endif
 
+#ifndef _CHECKPOINT_H
+#define _CHECKPOINT_H
+#include "checkpoint.h"
+#endif
+
+#ifndef _SNAPSHOT_H
+#define _SNAPSHOT_H
+#include "snapshot.h"
+#endif
+
 #ifndef _INITIALIZATION_H
 #define _INITIALIZATION_H
 #include "initialization.h"
@@ -61,18 +85,20 @@
 ///////////////////////////////////////////////////////////////////////////////
 /// Lanuch the FFD simulation through a thread
 ///
-///\param p Pointer to the cosimulaiton data
+/// The thread owns the instance and frees it when the simulation ends.
+///
+///\param p Pointer to the FFD instance
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
 #ifdef _MSC_VER //Windows
 DWORD WINAPI ffd_thread(void *p);
 #else //Linux
-void ffd_thread(void *p);
+void *ffd_thread(void *p);
 #endif
 
 ///////////////////////////////////////////////////////////////////////////////
-/// Main routine of FFD
+/// Main routine of FFD for a stand alone simulation
 ///
 ///\para cosimulation Integer to identify the simulation type
 ///
@@ -80,14 +106,55 @@ void ffd_thread(void *p);
 ///////////////////////////////////////////////////////////////////////////////
 int ffd(int cosimulation);
 
+///////////////////////////////////////////////////////////////////////////////
+/// Create an FFD instance
+///
+///\param cosim Pointer to the cosimulation data, NULL for a stand alone
+///             simulation
+///
+///\return Pointer to the instance, NULL if an error occurred
+///////////////////////////////////////////////////////////////////////////////
+FFD_INSTANCE *new_ffd_instance(CosimulationData *cosim);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free an FFD instance and the memory of its simulation
+///
+///\param inst Pointer to the FFD instance
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_ffd_instance(FFD_INSTANCE *inst);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free the memory of the simulation of an FFD instance
+///
+/// The memory which has already been freed is skipped, so that the function
+/// can be called again after an error.
+///
+///\param inst Pointer to the FFD instance
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_ffd_memory(FFD_INSTANCE *inst);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Run the simulation of an FFD instance
+///
+///\param inst Pointer to the FFD instance
+///\para cosimulation Integer to identify the simulation type
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int ffd_run(FFD_INSTANCE *inst, int cosimulation);
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Allcoate memory for variables
 ///
-///\param para Pointer to FFD parameters
+///\param inst Pointer to the FFD instance
 ///
 ///\return No return needed
 ///////////////////////////////////////////////////////////////////////////////
-int allocate_memory (PARA_DATA *para);
+int allocate_memory (FFD_INSTANCE *inst);
 
 ///////////////////////////////////////////////////////////////////////////////
 /// GLUT display callback routines
@@ -20,6 +20,11 @@
 ///////////////////////////////////////////////////////////////////////////////
 /// Read the previous FFD simulation data in a format of standard output
 ///
+/// If the file is a binary checkpoint written by write_checkpoint(), the
+/// whole state of the simulation is restored by read_checkpoint(). Otherwise
+/// the file is read as text file written by write_unsteady(), which only
+/// contains the velocities, temperature, trace substance and pressure.
+///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
 ///
@@ -32,11 +37,15 @@ int read_ffd_data(PARA_DATA *para, REAL **var) {
   int kmax = para->geom->kmax;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
   char string[400];
+  FILE *file_old_ffd;
+
+  if(is_checkpoint(para->inpu->old_ffd_file_name))
+    return read_checkpoint(para, var, para->inpu->old_ffd_file_name);
 
   if((file_old_ffd=fopen(para->inpu->old_ffd_file_name,"r"))==NULL) {
     sprintf(msg, "ffd_data_reader.c: Can not open %s.", 
             para->inpu->old_ffd_file_name);
-    ffd_log("ffd_data_reader.c: Can not open %s.", FFD_ERROR);
+    ffd_log(msg, FFD_ERROR);
     return 1;
   }
  
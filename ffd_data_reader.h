@@ -26,11 +26,16 @@
 
 #include "utility.h"
 
-FILE *file_old_ffd;
+#ifndef _CHECKPOINT_H
+#define _CHECKPOINT_H
+#include "checkpoint.h"
+#endif
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Read the previous FFD simulation data in a format of standard output
 ///
+/// Binary checkpoint files are read by read_checkpoint().
+///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
 ///
@@ -1,28 +1,67 @@
 
 
 #include "ffd_dll.h"
+
+// Number of FFD instances launched in this process
+static int nb_instance = 0;
+
 /******************************************************************************
 | DLL interface to launch a separated thread for FFD. 
 | Called by the the other program
+|
+| Each call creates its own FFD instance, so that the program can simulate
+| several rooms at the same time by calling it once for each room. The
+| instances do not share any data and the function can be called from
+| several threads.
 ******************************************************************************/
 int ffd_dll(CosimulationData *cosim) {
+  FFD_INSTANCE *inst;
+  int id;
 // Windows
 #ifdef _MSC_VER 
-  DWORD dummy;
   HANDLE workerThreadHandle;
 //  Linux
 #else 
-    pthread_t thread1;
+  pthread_t thread1;
+#endif
+
+#ifdef _MSC_VER
+  id = (int) InterlockedIncrement((volatile LONG *) &nb_instance);
+#else
+  id = __atomic_add_fetch(&nb_instance, 1, __ATOMIC_RELAXED);
 #endif
+  // The first instance starts a new log file
+  if(id==1)
+    ffd_log("ffd_dll(): Start Fast Fluid Dynamics Simulation.", FFD_NEW);
+
+  printf("ffd_dll():Start to launch FFD instance %d\n", id);
 
-  printf("ffd_dll():Start to launch FFD\n");
+  inst = new_ffd_instance(cosim);
+  if(inst==NULL) {
+    ffd_log("ffd_dll(): Could not allocate memory for the FFD instance.",
+            FFD_ERROR);
+    return 1;
+  }
+  inst->outp.id = id;
 
 // Windows
 #ifdef _MSC_VER
-  workerThreadHandle = CreateThread(NULL, 0, ffd_thread, (void *)cosim, 0, &dummy);
+  workerThreadHandle = CreateThread(NULL, 0, ffd_thread, (void *)inst, 0,
+                                    NULL);
+  if(workerThreadHandle==NULL) {
+    ffd_log("ffd_dll(): Could not launch the FFD thread.", FFD_ERROR);
+    free_ffd_instance(inst);
+    return 1;
+  }
+  CloseHandle(workerThreadHandle);
 // Linux
 #else 
-  pthread_create( &thread1, NULL, ffd_thread, (void*)cosim);
+  if(pthread_create(&thread1, NULL, ffd_thread, (void*)inst)!=0) {
+    ffd_log("ffd_dll(): Could not launch the FFD thread.", FFD_ERROR);
+    free_ffd_instance(inst);
+    return 1;
+  }
+  pthread_detach(thread1);
 #endif
 
   printf("ffd_dll(): Launched FFD simulation.\n");
@@ -9,8 +9,6 @@
 #include "ffd.h"
 #endif
 
-static PARA_DATA para;
-
 // Windows
 #ifdef _MSC_VER
 __declspec(dllexport)
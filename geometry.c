@@ -44,6 +44,9 @@ REAL vol(PARA_DATA *para, REAL **var, int i, int j, int k) {
 ///\return Area of XY surface
 ///////////////////////////////////////////////////////////////////////////////
 REAL area_xy(PARA_DATA *para, REAL **var, int i, int j, int k) {
+  if(para->geom->metric!=NULL)
+    return para->geom->metric->axy[i+(para->geom->imax+2)*j];
+
   return length_x(para, var, i, j, k) 
        * length_y(para, var, i, j, k);
 } // End of area_xy()
@@ -60,6 +63,9 @@ REAL area_xy(PARA_DATA *para, REAL **var, int i, int j, int k) {
 ///\return Area of YZ surface
 ///////////////////////////////////////////////////////////////////////////////
 REAL area_yz(PARA_DATA *para, REAL **var, int i, int j, int k) {
+  if(para->geom->metric!=NULL)
+    return para->geom->metric->ayz[j+(para->geom->jmax+2)*k];
+
   return length_y(para, var, i, j, k) 
        * length_z(para, var, i, j, k);
 } // End of area_yz();
@@ -76,6 +82,9 @@ REAL area_yz(PARA_DATA *para, REAL **var, int i, int j, int k) {
 ///\return Area of ZX surface
 ///////////////////////////////////////////////////////////////////////////////
 REAL area_zx(PARA_DATA *para, REAL **var, int i, int j, int k) {
+  if(para->geom->metric!=NULL)
+    return para->geom->metric->azx[i+(para->geom->imax+2)*k];
+
   return length_z(para, var, i, j, k) 
        * length_x(para, var, i, j, k);
 } // End of area_zx()
@@ -95,7 +104,9 @@ REAL length_x(PARA_DATA *para, REAL **var, int i, int j, int k) {
   int imax = para->geom->imax, jmax = para->geom->jmax; 
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
 
-  if(i==0)
+  if(para->geom->metric!=NULL)
+    return para->geom->metric->lx[i];
+  else if(i==0)
     return 0;
   else
     return (REAL) fabs(var[GX][IX(i,j,k)]-var[GX][IX(i-1,j,k)]); 
@@ -116,9 +127,11 @@ REAL length_y(PARA_DATA *para, REAL **var, int i, int j, int k) {
   int imax = para->geom->imax, jmax = para->geom->jmax; 
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
 
-  if(j==0)
+  if(para->geom->metric!=NULL)
+    return para->geom->metric->ly[j];
+  else if(j==0)
     return 0;
-  else 
+  else
     return (REAL) fabs(var[GY][IX(i,j,k)]-var[GY][IX(i,j-1,k)]); 
 } // End of length_y()
 
@@ -137,9 +150,11 @@ REAL length_z(PARA_DATA *para, REAL **var, int i, int j, int k) {
   int imax = para->geom->imax, jmax = para->geom->jmax; 
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
 
-  if(k==0)
+  if(para->geom->metric!=NULL)
+    return para->geom->metric->lz[k];
+  else if(k==0)
     return 0;
-  else 
+  else
     return (REAL) fabs(var[GZ][IX(i,j,k)]-var[GZ][IX(i,j,k-1)]); 
 } // End of length_z()
 
@@ -268,4 +283,144 @@ int bounary_area(PARA_DATA *para, REAL **var, int **BINDEX) {
     }
   }
   return 0;
-} // End of bounary_area()
\ No newline at end of file
+} // End of bounary_area()
+///////////////////////////////////////////////////////////////////////////////
+/// Build the cache of the geometric metrics
+///
+/// The lengths, distances and surface areas are computed once from the
+/// coordinates in the same way as length_x(), area_xy() and so on. Since the
+/// grid is a tensor product, the coordinates and the other values are taken
+/// along the first row of each direction. All the tables share one block of
+/// memory.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int build_metric(PARA_DATA *para, REAL **var) {
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int JMAX = jmax+2, KMAX = kmax+2;
+  int i, j, k;
+  REAL *gx = var[GX], *gy = var[GY], *gz = var[GZ];
+  REAL *x = var[X], *y = var[Y], *z = var[Z];
+  METRIC_DATA *metric;
+  REAL *block;
+
+  free_metric(para);
+
+  metric = (METRIC_DATA *) malloc(sizeof(METRIC_DATA));
+  block = (REAL *) malloc((6*(IMAX+JMAX+KMAX) + IMAX*JMAX + JMAX*KMAX
+                          + KMAX*IMAX) * sizeof(REAL));
+  if(metric==NULL || block==NULL) {
+    ffd_log("build_metric(): Could not allocate memory for the metrics.",
+            FFD_ERROR);
+    free(metric);
+    free(block);
+    return 1;
+  }
+
+  metric->lx = block;
+  metric->rlx = metric->lx + IMAX;
+  metric->dxc = metric->rlx + IMAX;
+  metric->rdxc = metric->dxc + IMAX;
+  metric->ly = metric->rdxc + IMAX;
+  metric->rly = metric->ly + JMAX;
+  metric->dyc = metric->rly + JMAX;
+  metric->rdyc = metric->dyc + JMAX;
+  metric->lz = metric->rdyc + JMAX;
+  metric->rlz = metric->lz + KMAX;
+  metric->dzc = metric->rlz + KMAX;
+  metric->rdzc = metric->dzc + KMAX;
+  metric->axy = metric->rdzc + KMAX;
+  metric->ayz = metric->axy + IMAX*JMAX;
+  metric->azx = metric->ayz + JMAX*KMAX;
+  metric->x = metric->azx + KMAX*IMAX;
+  metric->gx = metric->x + IMAX;
+  metric->y = metric->gx + IMAX;
+  metric->gy = metric->y + JMAX;
+  metric->z = metric->gy + JMAX;
+  metric->gz = metric->z + KMAX;
+
+  /****************************************************************************
+  | Coordinates
+  ****************************************************************************/
+  for(i=0; i<=imax+1; i++) {
+    metric->x[i] = x[IX(i,0,0)];
+    metric->gx[i] = gx[IX(i,0,0)];
+  }
+  for(j=0; j<=jmax+1; j++) {
+    metric->y[j] = y[IX(0,j,0)];
+    metric->gy[j] = gy[IX(0,j,0)];
+  }
+  for(k=0; k<=kmax+1; k++) {
+    metric->z[k] = z[IX(0,0,k)];
+    metric->gz[k] = gz[IX(0,0,k)];
+  }
+
+  /****************************************************************************
+  | Lengths of the cells and distances between the cell centers
+  ****************************************************************************/
+  for(i=0; i<=imax+1; i++) {
+    metric->lx[i] = i==0 ? 0 : (REAL) fabs(gx[IX(i,0,0)]-gx[IX(i-1,0,0)]);
+    metric->dxc[i] = i>imax ? 0 : x[IX(i+1,0,0)] - x[IX(i,0,0)];
+  }
+  for(j=0; j<=jmax+1; j++) {
+    metric->ly[j] = j==0 ? 0 : (REAL) fabs(gy[IX(0,j,0)]-gy[IX(0,j-1,0)]);
+    metric->dyc[j] = j>jmax ? 0 : y[IX(0,j+1,0)] - y[IX(0,j,0)];
+  }
+  for(k=0; k<=kmax+1; k++) {
+    metric->lz[k] = k==0 ? 0 : (REAL) fabs(gz[IX(0,0,k)]-gz[IX(0,0,k-1)]);
+    metric->dzc[k] = k>kmax ? 0 : z[IX(0,0,k+1)] - z[IX(0,0,k)];
+  }
+
+  /****************************************************************************
+  | Inverse values, which are 0 for the cells without volume
+  ****************************************************************************/
+  for(i=0; i<=imax+1; i++) {
+    metric->rlx[i] = metric->lx[i]==0 ? 0 : 1 / metric->lx[i];
+    metric->rdxc[i] = metric->dxc[i]==0 ? 0 : 1 / metric->dxc[i];
+  }
+  for(j=0; j<=jmax+1; j++) {
+    metric->rly[j] = metric->ly[j]==0 ? 0 : 1 / metric->ly[j];
+    metric->rdyc[j] = metric->dyc[j]==0 ? 0 : 1 / metric->dyc[j];
+  }
+  for(k=0; k<=kmax+1; k++) {
+    metric->rlz[k] = metric->lz[k]==0 ? 0 : 1 / metric->lz[k];
+    metric->rdzc[k] = metric->dzc[k]==0 ? 0 : 1 / metric->dzc[k];
+  }
+
+  /****************************************************************************
+  | Surface areas
+  ****************************************************************************/
+  for(j=0; j<=jmax+1; j++)
+    for(i=0; i<=imax+1; i++)
+      metric->axy[i+IMAX*j] = metric->lx[i] * metric->ly[j];
+  for(k=0; k<=kmax+1; k++)
+    for(j=0; j<=jmax+1; j++)
+      metric->ayz[j+JMAX*k] = metric->ly[j] * metric->lz[k];
+  for(k=0; k<=kmax+1; k++)
+    for(i=0; i<=imax+1; i++)
+      metric->azx[i+IMAX*k] = metric->lz[k] * metric->lx[i];
+
+  para->geom->metric = metric;
+
+  return 0;
+} // End of build_metric()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free the cache of the geometric metrics
+///
+///\param para Pointer to FFD parameters
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_metric(PARA_DATA *para) {
+  if(para->geom->metric==NULL) return;
+
+  free(para->geom->metric->lx);
+  free(para->geom->metric);
+  para->geom->metric = NULL;
+} // End of free_metric()
@@ -127,4 +127,22 @@ REAL length_z(PARA_DATA *para, REAL **var, int i, int j, int k);
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int bounary_area(PARA_DATA *para, REAL **var, int **BINDEX);
\ No newline at end of file
+int bounary_area(PARA_DATA *para, REAL **var, int **BINDEX);
+///////////////////////////////////////////////////////////////////////////////
+/// Build the cache of the geometric metrics
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int build_metric(PARA_DATA *para, REAL **var);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free the cache of the geometric metrics
+///
+///\param para Pointer to FFD parameters
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_metric(PARA_DATA *para);
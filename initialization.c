@@ -73,11 +73,21 @@ void set_default_parameter(PARA_DATA *para) {
   para->mytime->t  = 0.0;
   para->mytime->step_current = 0;
   para->mytime->t_start = clock();
+  para->mytime->adaptive = 0; // Fixed time step size
+  para->mytime->cfl = (REAL) 1.0; // Target CFL number of adaptive time step
+  para->mytime->fourier = (REAL) 10.0; // Maximum diffusion number
+  para->mytime->dt_min = 0.0; // No lower limit for adaptive time step
+  para->mytime->dt_max = 0.0; // No upper limit for adaptive time step
+  para->mytime->dt_log = 0.0; // No adaptive time step size in the log yet
+
+  para->geom->metric = NULL; // Metrics are built after the grid is set
 
   para->prob->alpha = (REAL) 2.376e-5; // Thermal diffusity
   para->prob->diff = (REAL) 0.00001;
   para->prob->force = (REAL) 1.0; 
   para->prob->source = (REAL) 1.0;
+  para->prob->movie = 0; // No snapshots for animation
+  para->prob->movie_step = 10; // Snapshot every 10 time steps for animation
 
   para->prob->chen_a = (REAL) 0.03874; // Coeffcient of Chen's model
   para->prob->Prt = (REAL) 0.9; // Turbulent Prandl number
@@ -86,7 +96,34 @@ void set_default_parameter(PARA_DATA *para) {
 
   para->solv->check_residual = 0; // Donot check residual */
   para->solv->solver = GS; // Gauss-Seidel Solver
+  para->solv->gs_order = LEXICOGRAPHIC; // Serial sweeps in the index order
+  para->solv->gs_conv = 0; // Fixed number of G-S sweeps
+  para->solv->gs_tol = (REAL) 1.0e-4; // Residual target for G-S solver
+  para->solv->gs_min_vel = 2; // Minimum G-S sweeps for velocities
+  para->solv->gs_max_vel = 20; // Maximum G-S sweeps for velocities
+  para->solv->gs_min_temp = 2; // Minimum G-S sweeps for temperature
+  para->solv->gs_max_temp = 20; // Maximum G-S sweeps for temperature
+  para->solv->gs_min_trace = 2; // Minimum G-S sweeps for trace substances
+  para->solv->gs_max_trace = 20; // Maximum G-S sweeps for trace substances
+  para->solv->steady = 0; // Run all the time steps
+  para->solv->steady_tol = (REAL) 1.0e-3; // Relative change at steady state
+  para->solv->steady_window = 50; // Steps in a window of the steady monitor
+  para->solv->steady_du_max = (REAL) 1.0e-2; // Velocity change of stagnation
   para->solv->interpolation = BILINEAR; // Bilinear interpolation
+  para->solv->pcg_precond = IC; // Incomplete Cholesky preconditioner
+  para->solv->p_tol = (REAL) 1.0e-4; // Residual target for MG and PCG solvers
+  para->solv->p_max_iter = 20; // Maximum V-cycles of MG solver
+  para->solv->pcg_max_iter = 500; // Maximum iterations of PCG solver
+  para->solv->mg = NULL; // Multigrid hierarchy is built at the first call
+  para->solv->tdma = NULL; // TDMA workspaces are allocated at the first call
+  para->solv->pcg = NULL; // PCG work vectors are allocated at the first call
+  para->solv->trace = NULL; // Distances are computed at the first advection
+  para->solv->monitor = NULL; // Steady state monitor is allocated at first use
+  para->solv->snapshot = NULL; // Snapshot writer is started at first use
+  para->solv->cosim_lag = 0; // Wait for Modelica at each synchronization
+  para->solv->lag = NULL; // Lagged cosimulation data are allocated at first use
+  para->solv->nb_thread = 0; // Number of threads chosen by OpenMP
+  para->solv->profile = NULL; // Timers are allocated if outp.profile is 1
 
   // Default values for Input
   para->inpu->read_old_ffd_file = 0; // Do not read the old FFD data as initial value
@@ -102,6 +139,10 @@ void set_default_parameter(PARA_DATA *para) {
   para->outp->i_N        = 1;
   para->outp->j_N        = 1;
   para->outp->tstep_display = 10; // Update the display for every 10 time steps
+  para->outp->checkpoint = 0; // Do not write the checkpoint file
+  para->outp->format = ASCII; // Write the result files as Tecplot text files
+  para->outp->log_level = 3; // Write all the messages into the log file
+  para->outp->profile = 0; // Do not time the solver phases
 
   para->bc->nb_port = 0;
   para->bc->nb_Xi = 0;
@@ -191,6 +232,16 @@ int set_initial_data(PARA_DATA *para, REAL **var, int **BINDEX) {
     mark_cell(para, var);
   }
 
+  /****************************************************************************
+  | Cache the geometric metrics since the grid does not change any more
+  ****************************************************************************/
+  flag = build_metric(para, var);
+  if(flag != 0) {
+    ffd_log("set_initial_data(): Could not build the geometric metrics.",
+            FFD_ERROR);
+    return flag;
+  }
+
   /****************************************************************************
   | Allocate memory for sensor data if there is at least one sensor
   ****************************************************************************/
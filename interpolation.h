@@ -63,3 +63,95 @@ REAL interpolation(PARA_DATA *para, REAL *d0, REAL x_1, REAL y_1, REAL z_1,
 REAL interpolation_bilinear(REAL x_1, REAL y_1, REAL z_1,
                             REAL d000, REAL d010, REAL d100, REAL d110,
                             REAL d001, REAL d011, REAL d101, REAL d111);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Interpolation of a batch of points
+///
+/// The value at point n is stored in d[cell[n]]. The cell of point n is
+/// given by its index oc[n]=IX(p,q,r) and the location in the cell by
+/// x_1[n], y_1[n] and z_1[n].
+///
+///\param para Pointer to FFD parameters
+///\param d0 Pointer to the variable for interpolation
+///\param nb Number of points
+///\param oc oc[nb]: Index of the cells of the points
+///\param x_1 x_1[nb]: Relative X-location of the points in their cells
+///\param y_1 y_1[nb]: Relative Y-location of the points in their cells
+///\param z_1 z_1[nb]: Relative Z-location of the points in their cells
+///\param cell cell[nb]: Index of the interpolated values in d
+///\param d Pointer to the interpolated variable
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void interpolation_batch(PARA_DATA *para, REAL *d0, int nb, int *oc,
+                         REAL *x_1, REAL *y_1, REAL *z_1, int *cell,
+                         REAL *d);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Monotone cubic interpolation of Fedkiw, Stam and Jensen
+///
+/// The values at the 4x4x4 cells from (p-1,q-1,r-1) to (p+2,q+2,r+2) are
+/// interpolated in X, then in Y and at last in Z direction. The indices
+/// outside of the domain are replaced by the ones of the boundary cells.
+/// The distances between the nodes are the ones between the cell centers.
+/// For a velocity, whose nodes are on the cell surfaces in its own
+/// direction, they approximate the distances between the surfaces.
+///
+///\param para Pointer to FFD parameters
+///\param d0 Pointer to the variable for interpolation
+///\param x_1 Relative X-location in the cell
+///\param y_1 Relative Y-location in the cell
+///\param z_1 Relative Z-location in the cell
+///\param p I-index of the control volume
+///\param q J-index of the control volume
+///\param r K-index of the control volume
+///
+///\return Interpolated value
+///////////////////////////////////////////////////////////////////////////////
+REAL interpolation_fsj(PARA_DATA *para, REAL *d0, REAL x_1, REAL y_1,
+                       REAL z_1, int p, int q, int r);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Hybrid interpolation
+///
+/// The monotone cubic interpolation is used if its value is within the range
+/// of the eight corners. Otherwise the bilinear interpolation is used.
+///
+///\param para Pointer to FFD parameters
+///\param d0 Pointer to the variable for interpolation
+///\param x_1 Relative X-location in the cell
+///\param y_1 Relative Y-location in the cell
+///\param z_1 Relative Z-location in the cell
+///\param p I-index of the control volume
+///\param q J-index of the control volume
+///\param r K-index of the control volume
+///
+///\return Interpolated value
+///////////////////////////////////////////////////////////////////////////////
+REAL interpolation_hybrid(PARA_DATA *para, REAL *d0, REAL x_1, REAL y_1,
+                          REAL z_1, int p, int q, int r);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Monotone cubic interpolation in one direction
+///
+/// The slopes at f0 and f1 are the ones of the parabolas through the three
+/// nodes around them, so that the spacing of a stretched grid is taken into
+/// account. A slope is one-sided if the distance to the outer node is 0.
+/// The slopes are limited as proposed by Fritsch and Carlson: they are set
+/// to zero if their sign differs from the one of f1-f0 and are at most 3
+/// times f1-f0. The result is then monotone between f0 and f1 and has no
+/// overshoot.
+///
+///\param t Relative location between f0 (t=0) and f1 (t=1)
+///\param fm Value before f0
+///\param f0 Value at t=0
+///\param f1 Value at t=1
+///\param f2 Value after f1
+///\param hm Distance between the nodes of fm and f0
+///\param h0 Distance between the nodes of f0 and f1
+///\param h1 Distance between the nodes of f1 and f2
+///
+///\return Interpolated value
+///////////////////////////////////////////////////////////////////////////////
+REAL interpolation_cubic(REAL t, REAL fm, REAL f0, REAL f1, REAL f2,
+                         REAL hm, REAL h0, REAL h1);
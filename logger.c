@@ -0,0 +1,373 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// \file   logger.c
+///
+/// \brief  Buffered log files written by a background thread
+///
+/// \author agent
+///         agent@local
+///
+/// \date   10/17/2026
+///
+/// The messages are kept in a ring buffer of LOG_RING entries. A thread
+/// claims an entry by advancing log_head with a compare-and-swap, copies its
+/// message and marks the entry as full, so that the threads never wait on
+/// each other to log. The entries are written in the order of log_head by
+/// the flusher thread, or by a thread calling ffd_log_flush(), under
+/// log_lock. The flusher thread ends after LOG_IDLE rounds without messages
+/// and is started again by the next message.
+///
+///////////////////////////////////////////////////////////////////////////////
+
+#include "logger.h"
+
+#ifndef _MSC_VER
+#include <sched.h>
+#endif
+
+// Number of entries in the ring buffer, must be a power of 2
+#define LOG_RING 256
+// Length of the longest message including the ending '\0'
+#define LOG_LENGTH 1000
+// Largest number of log files
+#define LOG_MAX_FILE 64
+// Time between two writes of the flusher thread in milliseconds
+#define LOG_FLUSH_MS 200
+// Number of rounds without messages before the flusher thread ends
+#define LOG_IDLE 5
+
+// States of the flusher thread
+#define LOG_STOPPED 0
+#define LOG_RUNNING 1
+#define LOG_SYNC 2 // The thread could not be started: write at once
+
+#ifdef _MSC_VER
+// Interlocked functions are full memory barriers
+#define LOG_LOAD(x) \
+  ((unsigned int) InterlockedCompareExchange((volatile LONG *) &(x), 0, 0))
+#define LOG_STORE(x, v) \
+  InterlockedExchange((volatile LONG *) &(x), (LONG) (v))
+#define LOG_CAS(x, old, v) \
+  (InterlockedCompareExchange((volatile LONG *) &(x), (LONG) (v), \
+                              (LONG) (old))==(LONG) (old))
+#define LOG_LOCK() AcquireSRWLockExclusive(&log_lock)
+#define LOG_UNLOCK() ReleaseSRWLockExclusive(&log_lock)
+#define LOG_YIELD() SwitchToThread()
+#define LOG_SLEEP() Sleep(LOG_FLUSH_MS)
+#else
+#define LOG_LOAD(x) __atomic_load_n(&(x), __ATOMIC_SEQ_CST)
+#define LOG_STORE(x, v) __atomic_store_n(&(x), (v), __ATOMIC_SEQ_CST)
+#define LOG_CAS(x, old, v) __sync_bool_compare_and_swap(&(x), (old), (v))
+#define LOG_LOCK() pthread_mutex_lock(&log_lock)
+#define LOG_UNLOCK() pthread_mutex_unlock(&log_lock)
+#define LOG_YIELD() sched_yield()
+#define LOG_SLEEP() usleep(LOG_FLUSH_MS*1000)
+#endif
+
+// Value of the sequence number of the entry for position pos when the entry
+// is empty. The entry is full if the sequence number is one larger. The
+// buffer initialized with 0 is empty.
+#define LOG_EMPTY(pos) (2 * ((unsigned int) (pos) / LOG_RING))
+
+typedef struct {
+  unsigned int seq; // Sequence number, see LOG_EMPTY()
+  int file; // Index of the log file
+  FFD_MSG_TYPE type; // Type of the message
+  char text[LOG_LENGTH]; // Message
+} LOG_ENTRY;
+
+typedef struct {
+  char name[400]; // Name of the log file
+  FILE *file; // Pointer to the file, NULL if it is not open
+  int written; // 1: Messages were written since the last fflush(); 0: no
+} LOG_FILE;
+
+static LOG_ENTRY log_ring[LOG_RING];
+static unsigned int log_head = 0; // Position of the next new message
+static unsigned int log_tail = 0; // Position of the next message to write
+static unsigned int log_state = LOG_STOPPED; // State of the flusher thread
+static int log_atexit = 0; // 1: ffd_log_close() is called at exit; 0: no
+
+// Log files, log.ffd is the default one
+static LOG_FILE log_file[LOG_MAX_FILE] = {{"log.ffd", NULL, 0}};
+static int nb_log_file = 1;
+
+// Log file and level of the thread
+static FFD_THREAD_LOCAL int log_id = 0;
+static FFD_THREAD_LOCAL int log_level = 3;
+
+// Lock of the log files and of log_tail
+#ifdef _MSC_VER
+static SRWLOCK log_lock = SRWLOCK_INIT;
+#else
+static pthread_mutex_t log_lock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+static void start_log_thread();
+static int write_log();
+
+///////////////////////////////////////////////////////////////////////////////
+/// Write the log file
+///
+/// The message is queued and written by the flusher thread. FFD_NEW empties
+/// the log file before the message is written. FFD_ERROR waits until all
+/// the queued messages are written.
+///
+///\param message Pointer the message
+///\param msg_type Type ogf message
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void ffd_log(char *message, FFD_MSG_TYPE msg_type) {
+  LOG_ENTRY *entry;
+  unsigned int pos;
+  size_t len;
+  int level;
+
+  switch(msg_type) {
+    case FFD_ERROR:
+    case FFD_NEW:
+      level = 1;
+      break;
+    case FFD_WARNING:
+      level = 2;
+      break;
+    default:
+      level = 3;
+  }
+  if(level>FFD_LOG_LEVEL || level>log_level) return;
+
+  /****************************************************************************
+  | Claim the entry at log_head
+  ****************************************************************************/
+  while(1) {
+    pos = LOG_LOAD(log_head);
+    if(LOG_LOAD(log_ring[pos%LOG_RING].seq)==LOG_EMPTY(pos)) {
+      if(LOG_CAS(log_head, pos, pos+1)) break;
+    }
+    // The buffer is full since the entry still has the message of last round
+    else if(LOG_LOAD(log_head)==pos)
+      ffd_log_flush();
+  }
+
+  entry = &log_ring[pos%LOG_RING];
+  len = strlen(message);
+  if(len>LOG_LENGTH-1) len = LOG_LENGTH - 1;
+  memcpy(entry->text, message, len);
+  entry->text[len] = '\0';
+  entry->file = log_id;
+  entry->type = msg_type;
+  LOG_STORE(entry->seq, LOG_EMPTY(pos)+1);
+
+  /****************************************************************************
+  | Make sure that the message will be written. The state is read after the
+  | message is queued, so that a flusher thread ending at the same time
+  | either writes it or is started again.
+  ****************************************************************************/
+  if(LOG_LOAD(log_state)==LOG_STOPPED)
+    start_log_thread();
+
+  if(msg_type==FFD_ERROR || LOG_LOAD(log_state)==LOG_SYNC)
+    ffd_log_flush();
+} // End of ffd_log()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Write the messages of the calling thread into another log file
+///
+/// The file is opened at its first message. The messages are appended to the
+/// file, unless the first one is of type FFD_NEW.
+///
+///\param name Name of the log file
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int ffd_log_open(char *name) {
+  int i;
+
+  LOG_LOCK();
+  for(i=0; i<nb_log_file; i++)
+    if(!strcmp(log_file[i].name, name)) break;
+
+  if(i==nb_log_file) {
+    if(nb_log_file==LOG_MAX_FILE || strlen(name)>=400) {
+      LOG_UNLOCK();
+      sprintf(msg, "ffd_log_open(): Could not open the log file %s.", name);
+      ffd_log(msg, FFD_ERROR);
+      return 1;
+    }
+    strcpy(log_file[i].name, name);
+    log_file[i].file = NULL;
+    log_file[i].written = 0;
+    nb_log_file++;
+  }
+  LOG_UNLOCK();
+
+  log_id = i;
+  return 0;
+} // End of ffd_log_open()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Set the level of the messages written by the calling thread
+///
+///\param level 0: none, 1: errors, 2: errors and warnings, 3: all messages
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void ffd_log_set_level(int level) {
+  log_level = level;
+} // End of ffd_log_set_level()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Write all the queued messages into the log files
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void ffd_log_flush() {
+  LOG_LOCK();
+  write_log();
+  LOG_UNLOCK();
+} // End of ffd_log_flush()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Write all the queued messages and close the log files
+///
+/// Called at the exit of the program. The files are opened again if more
+/// messages are logged.
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void ffd_log_close() {
+  int i;
+
+  LOG_LOCK();
+  write_log();
+  for(i=0; i<nb_log_file; i++)
+    if(log_file[i].file!=NULL) {
+      fclose(log_file[i].file);
+      log_file[i].file = NULL;
+    }
+  LOG_UNLOCK();
+} // End of ffd_log_close()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Write the queued messages into the log files
+///
+/// The caller must hold log_lock. Entries which have been claimed but are
+/// still being copied are waited for.
+///
+///\return Number of messages written
+///////////////////////////////////////////////////////////////////////////////
+static int write_log() {
+  LOG_ENTRY *entry;
+  LOG_FILE *f;
+  unsigned int end = LOG_LOAD(log_head);
+  int i, nb = 0;
+
+  while(log_tail!=end) {
+    entry = &log_ring[log_tail%LOG_RING];
+    while(LOG_LOAD(entry->seq)!=LOG_EMPTY(log_tail)+1)
+      LOG_YIELD();
+
+    f = &log_file[entry->file];
+    if(entry->type==FFD_NEW && f->file!=NULL) {
+      fclose(f->file);
+      f->file = NULL;
+    }
+    if(f->file==NULL)
+      f->file = fopen(f->name, entry->type==FFD_NEW ? "w" : "a+");
+
+    if(f->file==NULL)
+      fprintf(stderr, "Error:can not open log file %s!\n", f->name);
+    else {
+      switch(entry->type) {
+        case FFD_WARNING:
+          fprintf(f->file, "WARNING in %s\n", entry->text);
+          break;
+        case FFD_ERROR:
+          fprintf(f->file, "ERROR in %s\n", entry->text);
+          break;
+        // Normal log
+        default:
+          fprintf(f->file, "%s\n", entry->text);
+      }
+      f->written = 1;
+    }
+
+    // Release the entry for the next round
+    LOG_STORE(entry->seq, LOG_EMPTY(log_tail+LOG_RING));
+    log_tail++;
+    nb++;
+  }
+
+  for(i=0; i<nb_log_file; i++)
+    if(log_file[i].written) {
+      fflush(log_file[i].file);
+      log_file[i].written = 0;
+    }
+
+  return nb;
+} // End of write_log()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Flusher thread writing the log files every LOG_FLUSH_MS milliseconds
+///
+///\param p Not used
+///
+///\return 0
+///////////////////////////////////////////////////////////////////////////////
+#ifdef _MSC_VER
+static DWORD WINAPI log_thread(void *p) {
+#else
+static void *log_thread(void *p) {
+#endif
+  int idle = 0;
+
+  (void) p;
+
+  while(idle<LOG_IDLE) {
+    LOG_SLEEP();
+    LOG_LOCK();
+    idle = write_log()>0 ? 0 : idle+1;
+    LOG_UNLOCK();
+  }
+
+  // Messages queued before the state is changed are written here, the later
+  // ones start a new thread
+  LOG_STORE(log_state, LOG_STOPPED);
+  ffd_log_flush();
+
+  return 0;
+} // End of log_thread()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Start the flusher thread if it is not running
+///
+/// If the thread can not be started, the messages are written at once.
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+static void start_log_thread() {
+#ifdef _MSC_VER
+  HANDLE handle;
+#else
+  pthread_t thread;
+#endif
+
+  if(!LOG_CAS(log_state, LOG_STOPPED, LOG_RUNNING)) return;
+
+  if(LOG_CAS(log_atexit, 0, 1))
+    atexit(ffd_log_close);
+
+#ifdef _MSC_VER
+  handle = CreateThread(NULL, 0, log_thread, NULL, 0, NULL);
+  if(handle==NULL)
+    LOG_STORE(log_state, LOG_SYNC);
+  else
+    CloseHandle(handle);
+#else
+  if(pthread_create(&thread, NULL, log_thread, NULL)!=0)
+    LOG_STORE(log_state, LOG_SYNC);
+  else
+    pthread_detach(thread);
+#endif
+} // End of start_log_thread()
@@ -0,0 +1,89 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// \file   logger.h
+///
+/// \brief  Buffered log files written by a background thread
+///
+/// \author agent
+///         agent@local
+///
+/// \date   10/17/2026
+///
+/// ffd_log() copies the message into a ring buffer and returns. A flusher
+/// thread writes the buffer into the log files every LOG_FLUSH_MS
+/// milliseconds, so that the log file is neither opened nor flushed for each
+/// message. Errors are written before ffd_log() returns.
+///
+/// Each thread writes into the log file opened with ffd_log_open(), or into
+/// log.ffd by default. Messages above the level of the thread are discarded.
+/// The level is 3 (all messages) by default and can be lowered with
+/// outp.log_level, or at compile time with FFD_LOG_LEVEL.
+///
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef _LOGGER_H
+#define _LOGGER_H
+#endif
+
+#ifndef _DATA_STRUCTURE_H
+#define _DATA_STRUCTURE_H
+#include "data_structure.h"
+#endif
+
+// Highest level of the messages kept by the compiled program:
+// 0: none, 1: errors, 2: errors and warnings, 3: all messages
+#ifndef FFD_LOG_LEVEL
+#define FFD_LOG_LEVEL 3
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+/// Write the log file
+///
+/// The message is queued and written by the flusher thread. FFD_NEW empties
+/// the log file before the message is written. FFD_ERROR waits until all
+/// the queued messages are written.
+///
+///\param message Pointer the message
+///\param msg_type Type ogf message
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void ffd_log(char *message, FFD_MSG_TYPE msg_type);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Write the messages of the calling thread into another log file
+///
+/// The file is opened at its first message. The messages are appended to the
+/// file, unless the first one is of type FFD_NEW.
+///
+///\param name Name of the log file
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int ffd_log_open(char *name);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Set the level of the messages written by the calling thread
+///
+///\param level 0: none, 1: errors, 2: errors and warnings, 3: all messages
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void ffd_log_set_level(int level);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Write all the queued messages into the log files
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void ffd_log_flush();
+
+///////////////////////////////////////////////////////////////////////////////
+/// Write all the queued messages and close the log files
+///
+/// Called at the exit of the program. The files are opened again if more
+/// messages are logged.
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void ffd_log_close();
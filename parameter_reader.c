@@ -99,6 +99,21 @@ int assign_parameter(PARA_DATA *para, char *string) {
     sprintf(msg, "assign_parameter(): %s=%d", tmp, para->outp->cal_mean);
     ffd_log(msg, FFD_NORMAL);
   }
+  else if(!strcmp(tmp, "outp.checkpoint")) {
+    sscanf(string, "%s%d", tmp, &para->outp->checkpoint);
+    sprintf(msg, "assign_parameter(): %s=%d", tmp, para->outp->checkpoint);
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "outp.profile")) {
+    sscanf(string, "%s%d", tmp, &para->outp->profile);
+    sprintf(msg, "assign_parameter(): %s=%d", tmp, para->outp->profile);
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "outp.log_level")) {
+    sscanf(string, "%s%d", tmp, &para->outp->log_level);
+    sprintf(msg, "assign_parameter(): %s=%d", tmp, para->outp->log_level);
+    ffd_log(msg, FFD_NORMAL);
+  }
   else if(!strcmp(tmp, "outp.v_ref")) {
     sscanf(string, "%s%f", tmp, &para->outp->v_ref);
     sprintf(msg, "assign_parameter(): %s=%f", tmp, para->outp->v_ref);
@@ -150,6 +165,22 @@ int assign_parameter(PARA_DATA *para, char *string) {
     }
     ffd_log(msg, FFD_NORMAL);
   }
+  else if(!strcmp(tmp, "outp.format")) {
+    sscanf(string, "%s%s", tmp, tmp2);
+    sprintf(msg, "assign_parameter(): %s=%s", tmp, tmp2);
+    if(!strcmp(tmp2, "ASCII"))
+      para->outp->format = ASCII;
+    else if(!strcmp(tmp2, "BINARY"))
+      para->outp->format = BINARY;
+    else if(!strcmp(tmp2, "VTK"))
+      para->outp->format = VTK;
+    else {
+      sprintf(msg, "assign_parameter(): %s is not valid input for %s", tmp2, tmp);
+      ffd_log(msg, FFD_ERROR);
+      return 1;
+    }
+    ffd_log(msg, FFD_NORMAL);
+  }
   else if(!strcmp(tmp, "inpu.parameter_file_format")) {
     sscanf(string, "%s%s", tmp, tmp2);
     sprintf(msg, "assign_parameter(): %s=%s", tmp, tmp2);
@@ -247,6 +278,11 @@ int assign_parameter(PARA_DATA *para, char *string) {
     sprintf(msg, "assign_parameter(): %s=%d", tmp, para->prob->movie);
     ffd_log(msg, FFD_NORMAL);
   }
+  else if(!strcmp(tmp, "prob.movie_step")) {
+    sscanf(string, "%s%d", tmp, &para->prob->movie_step);
+    sprintf(msg, "assign_parameter(): %s=%d", tmp, para->prob->movie_step);
+    ffd_log(msg, FFD_NORMAL);
+  }
   else if(!strcmp(tmp, "prob.tur_model")) {
     sscanf(string, "%s%s", tmp, tmp2);
     sprintf(msg, "assign_parameter(): %s=%s", tmp, tmp2);
@@ -283,6 +319,31 @@ int assign_parameter(PARA_DATA *para, char *string) {
     sprintf(msg, "assign_parameter(): %s=%f", tmp, para->mytime->t_steady);
     ffd_log(msg, FFD_NORMAL);
   }
+  else if(!strcmp(tmp, "mytime.adaptive")) {
+    sscanf(string, "%s%d", tmp, &para->mytime->adaptive);
+    sprintf(msg, "assign_parameter(): %s=%d", tmp, para->mytime->adaptive);
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "mytime.cfl")) {
+    sscanf(string, "%s%f", tmp, &para->mytime->cfl);
+    sprintf(msg, "assign_parameter(): %s=%f", tmp, para->mytime->cfl);
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "mytime.fourier")) {
+    sscanf(string, "%s%f", tmp, &para->mytime->fourier);
+    sprintf(msg, "assign_parameter(): %s=%f", tmp, para->mytime->fourier);
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "mytime.dt_min")) {
+    sscanf(string, "%s%lf", tmp, &para->mytime->dt_min);
+    sprintf(msg, "assign_parameter(): %s=%f", tmp, para->mytime->dt_min);
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "mytime.dt_max")) {
+    sscanf(string, "%s%lf", tmp, &para->mytime->dt_max);
+    sprintf(msg, "assign_parameter(): %s=%f", tmp, para->mytime->dt_max);
+    ffd_log(msg, FFD_NORMAL);
+  }
   else if(!strcmp(tmp, "solv.solver")) {
     sscanf(string, "%s%s", tmp, tmp2);
     sprintf(msg, "assign_parameter(): %s=%s", tmp, tmp2);
@@ -290,6 +351,10 @@ int assign_parameter(PARA_DATA *para, char *string) {
       para->solv->solver = GS;
     else if(!strcmp(tmp2, "TDMA")) 
       para->solv->solver = TDMA;
+    else if(!strcmp(tmp2, "MG")) 
+      para->solv->solver = MG;
+    else if(!strcmp(tmp2, "PCG")) 
+      para->solv->solver = PCG;
     else {
       sprintf(msg, "assign_parameter(): %s is not valid input for %s", tmp2, tmp);
       ffd_log(msg, FFD_ERROR);
@@ -302,6 +367,111 @@ int assign_parameter(PARA_DATA *para, char *string) {
     sprintf(msg, "assign_parameter(): %s=%d", tmp, para->solv->check_residual);
     ffd_log(msg, FFD_NORMAL);
   }
+  else if(!strcmp(tmp, "solv.gs_order")) {
+    sscanf(string, "%s%s", tmp, tmp2);
+    sprintf(msg, "assign_parameter(): %s=%s", tmp, tmp2);
+    if(!strcmp(tmp2, "LEXICOGRAPHIC")) 
+      para->solv->gs_order = LEXICOGRAPHIC;
+    else if(!strcmp(tmp2, "REDBLACK")) 
+      para->solv->gs_order = REDBLACK;
+    else {
+      sprintf(msg, "assign_parameter(): %s is not valid input for %s", tmp2, tmp);
+      ffd_log(msg, FFD_ERROR);
+      return 1;
+    }
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "solv.gs_conv")) {
+    sscanf(string, "%s%d", tmp, &para->solv->gs_conv);
+    sprintf(msg, "assign_parameter(): %s=%d", tmp, para->solv->gs_conv);
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "solv.gs_tol")) {
+    sscanf(string, "%s%f", tmp, &para->solv->gs_tol);
+    sprintf(msg, "assign_parameter(): %s=%f", tmp, para->solv->gs_tol);
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "solv.gs_min_vel")) {
+    sscanf(string, "%s%d", tmp, &para->solv->gs_min_vel);
+    sprintf(msg, "assign_parameter(): %s=%d", tmp, para->solv->gs_min_vel);
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "solv.gs_max_vel")) {
+    sscanf(string, "%s%d", tmp, &para->solv->gs_max_vel);
+    sprintf(msg, "assign_parameter(): %s=%d", tmp, para->solv->gs_max_vel);
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "solv.gs_min_temp")) {
+    sscanf(string, "%s%d", tmp, &para->solv->gs_min_temp);
+    sprintf(msg, "assign_parameter(): %s=%d", tmp, para->solv->gs_min_temp);
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "solv.gs_max_temp")) {
+    sscanf(string, "%s%d", tmp, &para->solv->gs_max_temp);
+    sprintf(msg, "assign_parameter(): %s=%d", tmp, para->solv->gs_max_temp);
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "solv.gs_min_trace")) {
+    sscanf(string, "%s%d", tmp, &para->solv->gs_min_trace);
+    sprintf(msg, "assign_parameter(): %s=%d", tmp, para->solv->gs_min_trace);
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "solv.gs_max_trace")) {
+    sscanf(string, "%s%d", tmp, &para->solv->gs_max_trace);
+    sprintf(msg, "assign_parameter(): %s=%d", tmp, para->solv->gs_max_trace);
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "solv.steady")) {
+    sscanf(string, "%s%d", tmp, &para->solv->steady);
+    sprintf(msg, "assign_parameter(): %s=%d", tmp, para->solv->steady);
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "solv.steady_tol")) {
+    sscanf(string, "%s%f", tmp, &para->solv->steady_tol);
+    sprintf(msg, "assign_parameter(): %s=%f", tmp, para->solv->steady_tol);
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "solv.steady_window")) {
+    sscanf(string, "%s%d", tmp, &para->solv->steady_window);
+    sprintf(msg, "assign_parameter(): %s=%d", tmp, para->solv->steady_window);
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "solv.steady_du_max")) {
+    sscanf(string, "%s%f", tmp, &para->solv->steady_du_max);
+    sprintf(msg, "assign_parameter(): %s=%f", tmp, para->solv->steady_du_max);
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "solv.pcg_precond")) {
+    sscanf(string, "%s%s", tmp, tmp2);
+    sprintf(msg, "assign_parameter(): %s=%s", tmp, tmp2);
+    if(!strcmp(tmp2, "JACOBI")) 
+      para->solv->pcg_precond = JACOBI;
+    else if(!strcmp(tmp2, "SSOR")) 
+      para->solv->pcg_precond = SSOR;
+    else if(!strcmp(tmp2, "IC")) 
+      para->solv->pcg_precond = IC;
+    else {
+      sprintf(msg, "assign_parameter(): %s is not valid input for %s", tmp2, tmp);
+      ffd_log(msg, FFD_ERROR);
+      return 1;
+    }
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "solv.p_tol")) {
+    sscanf(string, "%s%f", tmp, &para->solv->p_tol);
+    sprintf(msg, "assign_parameter(): %s=%f", tmp, para->solv->p_tol);
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "solv.p_max_iter")) {
+    sscanf(string, "%s%d", tmp, &para->solv->p_max_iter);
+    sprintf(msg, "assign_parameter(): %s=%d", tmp, para->solv->p_max_iter);
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "solv.pcg_max_iter")) {
+    sscanf(string, "%s%d", tmp, &para->solv->pcg_max_iter);
+    sprintf(msg, "assign_parameter(): %s=%d", tmp, para->solv->pcg_max_iter);
+    ffd_log(msg, FFD_NORMAL);
+  }
   else if(!strcmp(tmp, "solv.advection_solver")) {
     sscanf(string, "%s%s", tmp, tmp2);
     sprintf(msg, "assign_parameter(): %s=%s", tmp, tmp2);
@@ -341,6 +511,16 @@ int assign_parameter(PARA_DATA *para, char *string) {
     sprintf(msg, "assign_parameter(): %s=%d", tmp, para->solv->cosimulation);
     ffd_log(msg, FFD_NORMAL);
   }
+  else if(!strcmp(tmp, "solv.nb_thread")) {
+    sscanf(string, "%s%d", tmp, &para->solv->nb_thread);
+    sprintf(msg, "assign_parameter(): %s=%d", tmp, para->solv->nb_thread);
+    ffd_log(msg, FFD_NORMAL);
+  }
+  else if(!strcmp(tmp, "solv.cosim_lag")) {
+    sscanf(string, "%s%d", tmp, &para->solv->cosim_lag);
+    sprintf(msg, "assign_parameter(): %s=%d", tmp, para->solv->cosim_lag);
+    ffd_log(msg, FFD_NORMAL);
+  }
   /****************************************************************************
   | get the initial condition
   ****************************************************************************/
@@ -430,6 +610,7 @@ int assign_parameter(PARA_DATA *para, char *string) {
 ///////////////////////////////////////////////////////////////////////////////
 int read_parameter(PARA_DATA *para) {
   char string[400];
+  FILE *file_para;
 
   /****************************************************************************
   | Open the FFD parameter file
@@ -23,9 +23,6 @@
 
 #include "utility.h"
 
-FILE *file_para;
-FILE *file_log;
-
 ///////////////////////////////////////////////////////////////////////////////
 /// Assign the FFD parameters
 ///
@@ -32,8 +32,14 @@ int project(PARA_DATA *para, REAL **var, int **BINDEX) {
   int kmax = para->geom->kmax;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
   REAL dt= para->mytime->dt;
-  REAL *x = var[X], *y = var[Y], *z = var[Z];
-  REAL *gx = var[GX], *gy = var[GY], *gz = var[GZ]; 
+  REAL *lx = para->geom->metric->lx, *ly = para->geom->metric->ly;
+  REAL *lz = para->geom->metric->lz;
+  REAL *rlx = para->geom->metric->rlx, *rly = para->geom->metric->rly;
+  REAL *rlz = para->geom->metric->rlz;
+  REAL *dxc = para->geom->metric->dxc, *dyc = para->geom->metric->dyc;
+  REAL *dzc = para->geom->metric->dzc;
+  REAL *rdxc = para->geom->metric->rdxc, *rdyc = para->geom->metric->rdyc;
+  REAL *rdzc = para->geom->metric->rdzc;
   REAL *u = var[VX], *v = var[VY], *w = var[VZ];  
   REAL *p = var[IP], *b = var[B], *ap = var[AP], *ab = var[AB], *af = var[AF];
   REAL *ae = var[AE], *aw =var[AW], *an = var[AN], *as = var[AS];
@@ -43,40 +49,62 @@ int project(PARA_DATA *para, REAL **var, int **BINDEX) {
   
   /****************************************************************************
   | Calculate all coefficents
+  | The lengths are taken from the cached metrics. The loops run with I
+  | innermost, so that the lengths in Y and Z direction are constant in a row.
   ****************************************************************************/
-  FOR_EACH_CELL
-    dxe =  x[IX(i+1,j,  k)]   -  x[IX(i,  j,  k)];
-    dxw =  x[IX(i,  j,  k)]   -  x[IX(i-1,j,  k)];
-    dyn =  y[IX(i,  j+1,k)]   -  y[IX(i,  j,  k)];
-    dys =  y[IX(i,  j,  k)]   -  y[IX(i,  j-1,k)];
-    dzf =  z[IX(i,  j,  k+1)] -  z[IX(i,  j,  k)];
-    dzb =  z[IX(i,  j,  k)]   -  z[IX(i,  j,  k-1)];
-    Dx  = gx[IX(i,  j,  k)]   - gx[IX(i-1,j,  k)];
-    Dy  = gy[IX(i,  j,  k)]   - gy[IX(i,  j-1,k)];
-    Dz  = gz[IX(i,  j,  k)]   - gz[IX(i,  j,  k-1)];
- 
-    ae[IX(i,j,k)] = Dy*Dz/dxe;
-    aw[IX(i,j,k)] = Dy*Dz/dxw;      
-    an[IX(i,j,k)] = Dx*Dz/dyn;
-    as[IX(i,j,k)] = Dx*Dz/dys;
-    af[IX(i,j,k)] = Dx*Dy/dzf;
-    ab[IX(i,j,k)] = Dx*Dy/dzb;
-    b[IX(i,j,k)] = Dx*Dy*Dz/dt*((u[IX(i-1,j,k)]-u[IX(i,j,k)])/Dx
-                 + (v[IX(i,j-1,k)]-v[IX(i,j,k)])/Dy
-                 + (w[IX(i,j,k-1)]-w[IX(i,j,k)])/Dz);
-  END_FOR
+  for(k=1; k<=kmax; k++)
+    for(j=1; j<=jmax; j++) {
+      dyn = dyc[j];
+      dys = dyc[j-1];
+      dzf = dzc[k];
+      dzb = dzc[k-1];
+      Dy = ly[j];
+      Dz = lz[k];
+      for(i=1; i<=imax; i++) {
+        dxe = dxc[i];
+        dxw = dxc[i-1];
+        Dx = lx[i];
+
+        ae[IX(i,j,k)] = Dy*Dz/dxe;
+        aw[IX(i,j,k)] = Dy*Dz/dxw;
+        an[IX(i,j,k)] = Dx*Dz/dyn;
+        as[IX(i,j,k)] = Dx*Dz/dys;
+        af[IX(i,j,k)] = Dx*Dy/dzf;
+        ab[IX(i,j,k)] = Dx*Dy/dzb;
+        b[IX(i,j,k)] = Dx*Dy*Dz/dt*((u[IX(i-1,j,k)]-u[IX(i,j,k)])*rlx[i]
+                     + (v[IX(i,j-1,k)]-v[IX(i,j,k)])*rly[j]
+                     + (w[IX(i,j,k-1)]-w[IX(i,j,k)])*rlz[k]);
+      }
+    }
 
   /****************************************************************************
   | Projection step
   ****************************************************************************/
   set_bnd_pressure(para, var, p,BINDEX); 
 
-  FOR_EACH_CELL    
-    ap[IX(i,j,k)] = ae[IX(i,j,k)] + aw[IX(i,j,k)] + as[IX(i,j,k)] + an[IX(i,j,k)]
-                  + af[IX(i,j,k)] + ab[IX(i,j,k)];
-  END_FOR
+  for(k=1; k<=kmax; k++)
+    for(j=1; j<=jmax; j++)
+      for(i=1; i<=imax; i++)
+        ap[IX(i,j,k)] = ae[IX(i,j,k)] + aw[IX(i,j,k)] + as[IX(i,j,k)]
+                      + an[IX(i,j,k)] + af[IX(i,j,k)] + ab[IX(i,j,k)];
 
-  GS_P(para, var, IP, p);
+  start_timer(para, PHASE_SOLVE);
+  switch(para->solv->solver) {
+    case MG:
+      residual = MG_P(para, var, IP, p);
+      break;
+    case PCG:
+      residual = PCG_P(para, var, IP, p);
+      break;
+    default:
+      residual = GS_P(para, var, IP, p);
+      break;
+  }
+  stop_timer(para, PHASE_SOLVE);
+  if(residual<0) {
+    ffd_log("project(): Could not solve pressure equation.", FFD_ERROR);
+    return 1;
+  }
   set_bnd_pressure(para, var, p,BINDEX); 
    
   /****************************************************************************
@@ -84,17 +112,17 @@ int project(PARA_DATA *para, REAL **var, int **BINDEX) {
   ****************************************************************************/
   FOR_U_CELL
     if (flagu[IX(i,j,k)]>=0) continue;
-    u[IX(i,j,k)] -= dt*(p[IX(i+1,j,k)]-p[IX(i,j,k)]) / (x[IX(i+1,j,k)]-x[IX(i,j,k)]);
+    u[IX(i,j,k)] -= dt*(p[IX(i+1,j,k)]-p[IX(i,j,k)]) * rdxc[i];
   END_FOR
 
   FOR_V_CELL
     if (flagv[IX(i,j,k)]>=0) continue;
-    v[IX(i,j,k)] -= dt*(p[IX(i,j+1,k)]-p[IX(i,j,k)]) / (y[IX(i,j+1,k)]-y[IX(i,j,k)]);
+    v[IX(i,j,k)] -= dt*(p[IX(i,j+1,k)]-p[IX(i,j,k)]) * rdyc[j];
   END_FOR
 
   FOR_W_CELL
     if (flagw[IX(i,j,k)]>=0) continue;
-    w[IX(i,j,k)] -= dt*(p[IX(i,j,k+1)]-p[IX(i,j,k)]) / (z[IX(i,j,k+1)]-z[IX(i,j,k)]);
+    w[IX(i,j,k)] -= dt*(p[IX(i,j,k+1)]-p[IX(i,j,k)]) * rdzc[k];
   END_FOR
 
   return 0;
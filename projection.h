@@ -28,6 +28,16 @@
 #include "solver_gs.h"
 #endif
 
+#ifndef _SOLVER_MG_H
+#define _SOLVER_MG_H
+#include "solver_mg.h"
+#endif
+
+#ifndef _SOLVER_PCG_H
+#define _SOLVER_PCG_H
+#include "solver_pcg.h"
+#endif
+
 #ifndef _SOLVER_TDMA_H
 #define _SOLVER_TDMA_H
 #include "solver_tdma.h"
@@ -38,6 +48,11 @@
 #include "utility.h"
 #endif
 
+#ifndef _TIMING_H
+#define _TIMING_H
+#include "timing.h"
+#endif
+
 #ifndef _BOUNDARY_H
 #define _BOUNDARY_H
 #include "boundary.h"
@@ -30,6 +30,7 @@
 ///////////////////////////////////////////////////////////////////////////////
 int read_sci_max(PARA_DATA *para, REAL **var) {  
   char string[400];
+  FILE *file_params;
 
   // Open the file
   if((file_params=fopen(para->inpu->parameter_file_name,"r")) == NULL) {
@@ -71,6 +72,7 @@ int read_sci_input(PARA_DATA *para, REAL **var, int **BINDEX) {
   REAL Lz = para->geom->Lz;
   REAL *gx = var[GX], *gy = var[GY], *gz = var[GZ];
   REAL *x = var[X], *y = var[Y], *z = var[Z];
+  FILE *file_params;
   int IWWALL,IEWALL,ISWALL,INWALL,IBWALL,ITWALL;
   int SI,SJ,SK,EI,EJ,EK,FLTMP;
   REAL TMP,MASS,U,V,W;
@@ -834,6 +836,7 @@ int read_sci_zeroone(PARA_DATA *para, REAL **var, int **BINDEX) {
   int index = para->geom->index;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2); 
   REAL *flagp = var[FLAGP];
+  FILE *file_params;
 
   if( (file_params=fopen("zeroone.dat","r")) == NULL )
   {
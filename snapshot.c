@@ -0,0 +1,256 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// \file   snapshot.c
+///
+/// \brief  Write snapshots for animation in a background thread
+///
+/// \author agent
+///         agent@local
+///
+/// \date   10/17/2026
+///
+/// If prob.movie is 1, the solver takes a snapshot every prob.movie_step
+/// time steps. The fields of the result file are copied into one of two
+/// staging areas and a writer thread converts and writes them in the format
+/// outp.format, while the solver continues with the next time steps. The
+/// solver only waits if both areas are still waiting for the writer.
+///
+///////////////////////////////////////////////////////////////////////////////
+
+#include "snapshot.h"
+
+// Fields copied into the staging areas. These are the fields of the result
+// file and the fields that are changed by convert_to_tecplot().
+#define SNAPSHOT_FIELD {VX, VY, VZ, VXM, VYM, VZM, IP, TEMP, TEMPM, TRACE}
+#define SNAPSHOT_NB_FIELD 10
+
+#ifdef _MSC_VER
+#define SNAPSHOT_LOCK(s) EnterCriticalSection(&(s)->lock)
+#define SNAPSHOT_UNLOCK(s) LeaveCriticalSection(&(s)->lock)
+#define SNAPSHOT_WAIT(s) SleepConditionVariableCS(&(s)->cond, &(s)->lock, \
+                                                  INFINITE)
+#define SNAPSHOT_SIGNAL(s) WakeAllConditionVariable(&(s)->cond)
+#else
+#define SNAPSHOT_LOCK(s) pthread_mutex_lock(&(s)->lock)
+#define SNAPSHOT_UNLOCK(s) pthread_mutex_unlock(&(s)->lock)
+#define SNAPSHOT_WAIT(s) pthread_cond_wait(&(s)->cond, &(s)->lock)
+#define SNAPSHOT_SIGNAL(s) pthread_cond_broadcast(&(s)->cond)
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+/// Copy the fields of the current time step into a staging area
+///
+/// The writer thread is started at the first call. The snapshot is written
+/// as movie_<step> with the extension of outp.format, or as
+/// movie_<id>_<step> for the instances after the first one.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int take_snapshot(PARA_DATA *para, REAL **var) {
+  int size = (para->geom->imax+2)*(para->geom->jmax+2)*(para->geom->kmax+2);
+  int field[] = SNAPSHOT_FIELD;
+  int n, b;
+  SNAPSHOT_DATA *snap;
+
+  if(para->solv->snapshot==NULL) {
+    if(allocate_snapshot_data(para, var)!=0) {
+      ffd_log("take_snapshot(): Could not start the snapshot writer.",
+              FFD_ERROR);
+      return 1;
+    }
+  }
+  snap = para->solv->snapshot;
+
+  // Wait until the writer has released the area
+  SNAPSHOT_LOCK(snap);
+  b = snap->next;
+  while(snap->full[b]==1)
+    SNAPSHOT_WAIT(snap);
+  SNAPSHOT_UNLOCK(snap);
+
+#pragma omp parallel for schedule(static)
+  for(n=0; n<SNAPSHOT_NB_FIELD; n++)
+    memcpy(snap->var[b][field[n]], var[field[n]], size*sizeof(REAL));
+  snap->time[b] = *para->mytime;
+
+  // Hand the area to the writer
+  SNAPSHOT_LOCK(snap);
+  snap->full[b] = 1;
+  snap->next = 1 - b;
+  SNAPSHOT_SIGNAL(snap);
+  SNAPSHOT_UNLOCK(snap);
+
+  return 0;
+} // End of take_snapshot()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Allocate the staging areas and start the writer thread
+///
+/// The coordinates and FLAGP do not change during the simulation, so that
+/// the staging areas point to the variables of the solver for them.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int allocate_snapshot_data(PARA_DATA *para, REAL **var) {
+  int size = (para->geom->imax+2)*(para->geom->jmax+2)*(para->geom->kmax+2);
+  int nb_var = NB_VAR(para);
+  int field[] = SNAPSHOT_FIELD;
+  int n, b, flag;
+  SNAPSHOT_DATA *snap;
+
+  snap = (SNAPSHOT_DATA *) calloc(1, sizeof(SNAPSHOT_DATA));
+  if(snap==NULL) {
+    ffd_log("allocate_snapshot_data(): Could not allocate memory for "
+            "snapshot.", FFD_ERROR);
+    return 1;
+  }
+
+  for(b=0; b<2; b++) {
+    snap->var[b] = (REAL **) calloc(nb_var, sizeof(REAL *));
+    snap->arena[b] = (REAL *) ffd_aligned_malloc(SNAPSHOT_NB_FIELD*size
+                                                 *sizeof(REAL));
+    if(snap->var[b]==NULL || snap->arena[b]==NULL) {
+      ffd_log("allocate_snapshot_data(): Could not allocate memory for "
+              "the staging areas.", FFD_ERROR);
+      for(b=0; b<2; b++) {
+        free(snap->var[b]);
+        ffd_aligned_free(snap->arena[b]);
+      }
+      free(snap);
+      return 1;
+    }
+
+    for(n=0; n<SNAPSHOT_NB_FIELD; n++)
+      snap->var[b][field[n]] = snap->arena[b] + n*size;
+    snap->var[b][X] = var[X];
+    snap->var[b][Y] = var[Y];
+    snap->var[b][Z] = var[Z];
+    snap->var[b][FLAGP] = var[FLAGP];
+  }
+
+  /****************************************************************************
+  | Start the writer thread
+  ****************************************************************************/
+  para->solv->snapshot = snap;
+#ifdef _MSC_VER
+  InitializeCriticalSection(&snap->lock);
+  InitializeConditionVariable(&snap->cond);
+  snap->thread = CreateThread(NULL, 0, snapshot_thread, (void *) para, 0,
+                              NULL);
+  flag = snap->thread==NULL;
+#else
+  pthread_mutex_init(&snap->lock, NULL);
+  pthread_cond_init(&snap->cond, NULL);
+  flag = pthread_create(&snap->thread, NULL, snapshot_thread, (void *) para);
+#endif
+
+  if(flag!=0) {
+    ffd_log("allocate_snapshot_data(): Could not start the writer thread.",
+            FFD_ERROR);
+    for(b=0; b<2; b++) {
+      free(snap->var[b]);
+      ffd_aligned_free(snap->arena[b]);
+    }
+    free(snap);
+    para->solv->snapshot = NULL;
+    return 1;
+  }
+
+  return 0;
+} // End of allocate_snapshot_data()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Wait until all the snapshots are written and stop the writer thread
+///
+///\param para Pointer to FFD parameters
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_snapshot_data(PARA_DATA *para) {
+  SNAPSHOT_DATA *snap = para->solv->snapshot;
+  int b;
+
+  if(snap==NULL) return;
+
+  SNAPSHOT_LOCK(snap);
+  snap->stop = 1;
+  SNAPSHOT_SIGNAL(snap);
+  SNAPSHOT_UNLOCK(snap);
+
+#ifdef _MSC_VER
+  WaitForSingleObject(snap->thread, INFINITE);
+  CloseHandle(snap->thread);
+  DeleteCriticalSection(&snap->lock);
+#else
+  pthread_join(snap->thread, NULL);
+  pthread_mutex_destroy(&snap->lock);
+  pthread_cond_destroy(&snap->cond);
+#endif
+
+  for(b=0; b<2; b++) {
+    free(snap->var[b]);
+    ffd_aligned_free(snap->arena[b]);
+  }
+  free(snap);
+  para->solv->snapshot = NULL;
+} // End of free_snapshot_data()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Writer thread of the snapshots
+///
+/// The areas are written in the order in which they were filled. The writer
+/// works on its own copy of the parameters with the time of the snapshot,
+/// since the solver keeps advancing para->mytime. Its messages go into the
+/// log of the instance.
+///
+///\param p Pointer to FFD parameters
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+#ifdef _MSC_VER
+DWORD WINAPI snapshot_thread(void *p) {
+#else
+void *snapshot_thread(void *p) {
+#endif
+  PARA_DATA *para = (PARA_DATA *) p;
+  PARA_DATA local;
+  SNAPSHOT_DATA *snap = para->solv->snapshot;
+  int b = 0;
+  char base[40], name[50];
+
+  local = *para;
+  open_instance_log(para);
+  output_name(para, "movie", base);
+
+  while(1) {
+    SNAPSHOT_LOCK(snap);
+    while(snap->full[b]==0 && snap->stop==0)
+      SNAPSHOT_WAIT(snap);
+    if(snap->full[b]==0) {
+      SNAPSHOT_UNLOCK(snap);
+      break;
+    }
+    SNAPSHOT_UNLOCK(snap);
+
+    local.mytime = &snap->time[b];
+    sprintf(name, "%s_%06d", base, snap->time[b].step_current);
+    if(write_tecplot_data(&local, snap->var[b], name)!=0) {
+      sprintf(msg, "snapshot_thread(): Could not write snapshot %s.", name);
+      ffd_log(msg, FFD_ERROR);
+    }
+
+    SNAPSHOT_LOCK(snap);
+    snap->full[b] = 0;
+    SNAPSHOT_SIGNAL(snap);
+    SNAPSHOT_UNLOCK(snap);
+    b = 1 - b;
+  }
+
+  return 0;
+} // End of snapshot_thread()
@@ -0,0 +1,83 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// \file   snapshot.h
+///
+/// \brief  Write snapshots for animation in a background thread
+///
+/// \author agent
+///         agent@local
+///
+/// \date   10/17/2026
+///
+/// If prob.movie is 1, the solver takes a snapshot every prob.movie_step
+/// time steps. The fields of the result file are copied into one of two
+/// staging areas and a writer thread converts and writes them in the format
+/// outp.format, while the solver continues with the next time steps. The
+/// solver only waits if both areas are still waiting for the writer.
+///
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef _SNAPSHOT_H
+#define _SNAPSHOT_H
+#endif
+
+#ifndef _DATA_STRUCTURE_H
+#define _DATA_STRUCTURE_H
+#include "data_structure.h"
+#endif
+
+#ifndef _UTILITY_H
+#define _UTILITY_H
+#include "utility.h"
+#endif
+
+#ifndef _DATA_WRITER_H
+#define _DATA_WRITER_H
+#include "data_writer.h"
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+/// Copy the fields of the current time step into a staging area
+///
+/// The writer thread is started at the first call. The snapshot is written
+/// as movie_<step> with the extension of outp.format, or as
+/// movie_<id>_<step> for the instances after the first one.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int take_snapshot(PARA_DATA *para, REAL **var);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Allocate the staging areas and start the writer thread
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int allocate_snapshot_data(PARA_DATA *para, REAL **var);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Wait until all the snapshots are written and stop the writer thread
+///
+///\param para Pointer to FFD parameters
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_snapshot_data(PARA_DATA *para);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Writer thread of the snapshots
+///
+///\param p Pointer to FFD parameters
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+#ifdef _MSC_VER
+DWORD WINAPI snapshot_thread(void *p);
+#else
+void *snapshot_thread(void *p);
+#endif
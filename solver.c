@@ -20,6 +20,17 @@
 ///////////////////////////////////////////////////////////////////////////////
 /// FFD solver
 ///
+/// If mytime.adaptive is 1, the time step size is set before each step by
+/// \c set_time_step(), so that the steps end exactly at the synchronization
+/// times of the cosimulation. A single simulation then runs until the time
+/// that the fixed time step would reach after step_total steps from t=0,
+/// also if it was restarted from a checkpoint.
+///
+/// If solv.steady is 1, a single simulation stops once \c monitor_steady()
+/// finds that the flow has settled, but after step_total steps at the
+/// latest. Together with the adaptive time step, a large mytime.cfl then
+/// serves as pseudo time step towards the steady state.
+///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
 ///\param BINDEX Pointer to boundary index
@@ -31,34 +42,64 @@ int FFD_solver(PARA_DATA *para, REAL **var, int **BINDEX) {
   int kmax = para->geom->kmax;
   int step_total = para->mytime->step_total;
   REAL t_steady = para->mytime->t_steady;
-  int cal_mean = para->outp->cal_mean;
-  double t_cosim;
+  // A restart from a checkpoint continues the time average
+  int cal_mean = para->outp->cal_mean==1 || para->mytime->step_mean>0;
+  double t_cosim, t_stop;
   int flag, next;
 
-  if(para->solv->cosimulation == 1)
+  if(para->solv->cosimulation == 1 && para->solv->cosim_lag == 1)
+    t_cosim = para->mytime->t + para->solv->lag->guess.dt;
+  else if(para->solv->cosimulation == 1)
     t_cosim = para->mytime->t + para->cosim->modelica->dt;
 
+  // The adaptive time step runs over the same time as the fixed one. The
+  // time is counted from 0, so that a restart stops at the same time.
+  t_stop = step_total*para->mytime->dt;
+
   /***************************************************************************
   | Solver Loop
   ***************************************************************************/
   next = 1;
   while(next==1) {
+    //-------------------------------------------------------------------------
+    // Set the time step size for the adaptive time step
+    //-------------------------------------------------------------------------
+    if(para->mytime->adaptive==1) {
+      // The steady state mode has no synchronization time
+      if(para->solv->cosimulation==1)
+        flag = set_time_step(para, var, t_cosim);
+      else if(para->solv->steady==1)
+        flag = set_time_step(para, var, para->mytime->t);
+      else
+        flag = set_time_step(para, var, t_stop);
+      if(flag != 0) {
+        ffd_log("FFD_solver(): Could not set the time step size.", FFD_ERROR);
+        return flag;
+      }
+    }
+
     //-------------------------------------------------------------------------
     // Integration
     //-------------------------------------------------------------------------
+    start_timer(para, PHASE_VEL);
     flag = vel_step(para, var, BINDEX);
+    stop_timer(para, PHASE_VEL);
     if(flag != 0) {
       ffd_log("FFD_solver(): Could not solve velocity.", FFD_ERROR);
       return flag;
     }
 
+    start_timer(para, PHASE_TEMP);
     flag = temp_step(para, var, BINDEX);
+    stop_timer(para, PHASE_TEMP);
     if(flag != 0) {
       ffd_log("FFD_solver(): Could not solve temperature.", FFD_ERROR);
       return flag;
     }
     
+    start_timer(para, PHASE_DEN);
     flag = den_step(para, var, BINDEX);
+    stop_timer(para, PHASE_DEN);
     if(flag != 0) {
       ffd_log("FFD_solver(): Could not solve trace substance.", FFD_ERROR);
       return flag;
@@ -66,6 +107,15 @@ int FFD_solver(PARA_DATA *para, REAL **var, int **BINDEX) {
 
     timing(para);
 
+    // Stage a snapshot for the animation, it is written in the background
+    if(para->prob->movie==1 && para->prob->movie_step>0
+       && para->mytime->step_current%para->prob->movie_step==0) {
+      if(take_snapshot(para, var)!=0) {
+        ffd_log("FFD_solver(): Could not take the snapshot.", FFD_ERROR);
+        return 1;
+      }
+    }
+
     //-------------------------------------------------------------------------
     // Process for Cosimulation
     //-------------------------------------------------------------------------
@@ -76,7 +126,9 @@ int FFD_solver(PARA_DATA *para, REAL **var, int **BINDEX) {
       .......................................................................*/
       if(fabs(para->mytime->t - t_cosim)<SMALL) {
         // Average the FFD simulation data
+        start_timer(para, PHASE_AVERAGE);
         flag = average_time(para, var);
+        stop_timer(para, PHASE_AVERAGE);
         if(flag != 0) {
           ffd_log("FFD_solver(): Could not average the data over time.",
             FFD_ERROR);
@@ -84,13 +136,17 @@ int FFD_solver(PARA_DATA *para, REAL **var, int **BINDEX) {
         }
 
         // the data for cosimulation
+        start_timer(para, PHASE_COSIM_READ);
         flag = read_cosim_data(para, var, BINDEX);
+        stop_timer(para, PHASE_COSIM_READ);
         if(flag != 0) {
           ffd_log("FFD_solver(): Could not read cosimulation data.", FFD_ERROR);
           return flag;
         }
 
+        start_timer(para, PHASE_COSIM_WRITE);
         flag =  write_cosim_data(para, var);
+        stop_timer(para, PHASE_COSIM_WRITE);
         if(flag != 0) {
           ffd_log("FFD_solver(): Could not write cosimulation data.", FFD_ERROR);
           return flag;
@@ -99,10 +155,16 @@ int FFD_solver(PARA_DATA *para, REAL **var, int **BINDEX) {
         sprintf(msg, "ffd_solver(): Synchronized data at t=%f[s]\n", para->mytime->t);
         ffd_log(msg, FFD_NORMAL);
 
-        // Set the next synchronization time
-        t_cosim += para->cosim->modelica->dt;
+        // Set the next synchronization time. The lagged coupling uses its
+        // own copy, since Modelica may already write the next data.
+        if(para->solv->cosim_lag==1)
+          t_cosim += para->solv->lag->guess.dt;
+        else
+          t_cosim += para->cosim->modelica->dt;
         // Reset all the averaged data to 0
+        start_timer(para, PHASE_AVERAGE);
         flag = reset_time_averaged_data(para, var);
+        stop_timer(para, PHASE_AVERAGE);
         if(flag != 0) {
           ffd_log("FFD_solver(): Could not reset averaged data.",
             FFD_ERROR);
@@ -112,7 +174,7 @@ int FFD_solver(PARA_DATA *para, REAL **var, int **BINDEX) {
         /*.......................................................................
         | Check if Modelica asks to stop the simulation 
         .......................................................................*/
-        if(para->cosim->para->flag==0) {
+        if(cosim_get_flag(&para->cosim->para->flag)==0) {
           // Stop the solver
           next = 0; 
           sprintf(msg, 
@@ -157,7 +219,9 @@ int FFD_solver(PARA_DATA *para, REAL **var, int **BINDEX) {
             FFD_ERROR);
           return flag;
         }
+        start_timer(para, PHASE_AVERAGE);
         flag = add_time_averaged_data(para, var);
+        stop_timer(para, PHASE_AVERAGE);
         if(flag != 0) {
           ffd_log("FFD_solver(): "
             "Could not add the averaged data.",
@@ -173,7 +237,9 @@ int FFD_solver(PARA_DATA *para, REAL **var, int **BINDEX) {
       // Start to record data for calculating mean velocity if needed
       if(para->mytime->t>t_steady && cal_mean==0) {
         cal_mean = 1;
+        start_timer(para, PHASE_AVERAGE);
         flag = reset_time_averaged_data(para, var);
+        stop_timer(para, PHASE_AVERAGE);
         if(flag != 0) {
           ffd_log("FFD_solver(): Could not reset averaged data.",
             FFD_ERROR);
@@ -185,14 +251,41 @@ int FFD_solver(PARA_DATA *para, REAL **var, int **BINDEX) {
       }   
 
       if(cal_mean==1) {
+        start_timer(para, PHASE_AVERAGE);
         flag = add_time_averaged_data(para, var);
+        stop_timer(para, PHASE_AVERAGE);
         if(flag != 0) {
           ffd_log("FFD_solver(): Could not add the averaged data.",
             FFD_ERROR);
           return 1;
         }
       }
-      next = para->mytime->step_current < step_total ? 1 : 0;
+      if(para->mytime->adaptive==1 && para->solv->steady==0)
+        next = t_stop - para->mytime->t > SMALL ? 1 : 0;
+      else
+        next = para->mytime->step_current < step_total ? 1 : 0;
+
+      // Stop when the flow has settled in the steady state mode
+      if(para->solv->steady==1) {
+        flag = monitor_steady(para, var);
+        if(flag != 0) {
+          ffd_log("FFD_solver(): Could not monitor the steady state.",
+            FFD_ERROR);
+          return flag;
+        }
+        if(para->solv->monitor->settled==1) {
+          sprintf(msg, "FFD_solver(): Reached steady state at t=%f[s] "
+                  "after %d steps, change=%e", para->mytime->t,
+                  para->mytime->step_current, para->solv->monitor->change);
+          ffd_log(msg, FFD_NORMAL);
+          next = 0;
+        }
+        else if(next==0) {
+          sprintf(msg, "FFD_solver(): Did not reach steady state in %d steps, "
+                  "change=%e", step_total, para->solv->monitor->change);
+          ffd_log(msg, FFD_WARNING);
+        }
+      }
     }    
   } // End of While loop  
 
@@ -212,13 +305,17 @@ int temp_step(PARA_DATA *para, REAL **var, int **BINDEX) {
   REAL *T = var[TEMP], *T0 = var[TMP1];
   int flag = 0;
 
+  start_timer(para, PHASE_ADVECT);
   flag = advect(para, var, TEMP, 0, T0, T, BINDEX); 
+  stop_timer(para, PHASE_ADVECT);
   if(flag!=0) {
     ffd_log("temp_step(): Could not advect temperature.", FFD_ERROR);
     return flag;
   }
 
+  start_timer(para, PHASE_DIFFUSION);
   flag = diffusion(para, var, TEMP, 0, T, T0, BINDEX);
+  stop_timer(para, PHASE_DIFFUSION);
   if(flag!=0) {
     ffd_log("temp_step(): Could not diffuse temperature.", FFD_ERROR);
     return flag;
@@ -230,6 +327,9 @@ int temp_step(PARA_DATA *para, REAL **var, int **BINDEX) {
 ///////////////////////////////////////////////////////////////////////////////
 /// Calculate the contaminant concentration
 ///
+/// All the trace substances are advected with one tracing of the departure 
+/// points and diffused with one set of coefficients.
+///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
 ///\param BINDEX Pointer to boundary index
@@ -237,25 +337,36 @@ int temp_step(PARA_DATA *para, REAL **var, int **BINDEX) {
 ///\return 0 if no error occurred
 /////////////////////////////////////////////////////////////////////////////// 
 int den_step(PARA_DATA *para, REAL **var, int **BINDEX) {
-  REAL *den, *den0 = var[TMP1];
-  int i, flag = 0;
+  REAL **den = var + TRACE, **den0;
+  int flag = 0;
 
-  for(i=0; i<para->bc->nb_Xi; i++) {
-    den = var[TRACE+i];
-    flag = advect(para, var, TRACE, i, den0, den, BINDEX);
-    if(flag!=0) {
-      sprintf(msg, "den_step(): Could not advect for trace substance %d", i);
-      ffd_log(msg, FFD_ERROR);
-      return flag;
-    }
+  if(para->bc->nb_Xi<1) return 0;
 
-    flag = diffusion(para, var, TRACE, i, den, den0, BINDEX);
-    if(flag!=0) {
-      sprintf(msg, "den_step(): Could not diffuse trace substance %d", i);
-      ffd_log(msg, FFD_ERROR);
-      return flag;
+  // The workspaces of the advection are allocated at the first call
+  if(para->solv->trace==NULL) {
+    if(allocate_trace_data(para, var)!=0) {
+      ffd_log("den_step(): Could not allocate memory for trace substances.",
+              FFD_ERROR);
+      return 1;
     }
   }
+  den0 = para->solv->trace->den0;
+
+  start_timer(para, PHASE_ADVECT);
+  flag = advect_species(para, var, para->bc->nb_Xi, den0, den, BINDEX);
+  stop_timer(para, PHASE_ADVECT);
+  if(flag!=0) {
+    ffd_log("den_step(): Could not advect for trace substances.", FFD_ERROR);
+    return flag;
+  }
+
+  start_timer(para, PHASE_DIFFUSION);
+  flag = diffusion_species(para, var, para->bc->nb_Xi, den, den0, BINDEX);
+  stop_timer(para, PHASE_DIFFUSION);
+  if(flag!=0) {
+    ffd_log("den_step(): Could not diffuse trace substances.", FFD_ERROR);
+    return flag;
+  }
 
   return flag;
 } // End of den_step( )
@@ -274,49 +385,49 @@ int vel_step(PARA_DATA *para, REAL **var,int **BINDEX) {
   REAL *u0 = var[TMP1], *v0 = var[TMP2], *w0 = var[TMP3];
   int flag = 0;
 
-  flag = advect(para, var, VX, 0, u0, u, BINDEX);
-  if(flag!=0) {
-    ffd_log("vel_step(): Could not advect for velocity X.", FFD_ERROR);
-    return flag;
-  }
-
-  flag = advect(para, var, VY, 0, v0, v, BINDEX);
+  start_timer(para, PHASE_ADVECT);
+  flag = advect_velocity(para, var, u0, v0, w0, BINDEX);
+  stop_timer(para, PHASE_ADVECT);
   if(flag!=0) {
-    ffd_log("vel_step(): Could not advect for velocity Y.", FFD_ERROR);
-    return flag;
-  }
-
-  flag = advect(para, var, VZ, 0, w0, w, BINDEX); 
-  if(flag!=0) {
-    ffd_log("vel_step(): Could not advect for velocity Z.", FFD_ERROR);
+    ffd_log("vel_step(): Could not advect velocity.", FFD_ERROR);
     return flag;
   }
 
+  start_timer(para, PHASE_DIFFUSION);
   flag = diffusion(para, var, VX, 0, u, u0, BINDEX);
+  stop_timer(para, PHASE_DIFFUSION);
   if(flag!=0) {
     ffd_log("vel_step(): Could not diffuse velocity X.", FFD_ERROR);
     return flag;
   }
 
+  start_timer(para, PHASE_DIFFUSION);
   flag = diffusion(para, var, VY, 0, v, v0, BINDEX);
+  stop_timer(para, PHASE_DIFFUSION);
   if(flag!=0) {
     ffd_log("vel_step(): Could not diffuse velocity Y.", FFD_ERROR);
     return flag;
   }
 
+  start_timer(para, PHASE_DIFFUSION);
   flag = diffusion(para, var, VZ, 0, w, w0, BINDEX); 
+  stop_timer(para, PHASE_DIFFUSION);
   if(flag!=0) {
     ffd_log("vel_step(): Could not diffuse velocity Z.", FFD_ERROR);
     return flag;
   }
 
+  start_timer(para, PHASE_PROJECT);
   flag = project(para, var,BINDEX);
+  stop_timer(para, PHASE_PROJECT);
   if(flag!=0) {
     ffd_log("vel_step(): Could not project velocity.", FFD_ERROR);
     return flag;
   }
 
+  start_timer(para, PHASE_BC);
   if(para->bc->nb_outlet!=0) flag = mass_conservation(para, var,BINDEX);
+  stop_timer(para, PHASE_BC);
   if(flag!=0) {
     ffd_log("vel_step(): Could not conduct mass conservation correction.",
             FFD_ERROR);
@@ -339,30 +450,43 @@ int vel_step(PARA_DATA *para, REAL **var,int **BINDEX) {
 int equ_solver(PARA_DATA *para, REAL **var, int var_type, REAL *psi) {
   REAL *flagp = var[FLAGP], *flagu = var[FLAGU],
        *flagv = var[FLAGV], *flagw = var[FLAGW];
+  REAL *cell;
   int flag = 0;
 
   switch(var_type) {
     case VX:
-      Gauss_Seidel(para, var, flagu, psi);
+      cell = flagu;
       break;
     case VY:
-      Gauss_Seidel(para, var, flagv, psi);
+      cell = flagv;
       break;
     case VZ:
-      Gauss_Seidel(para, var, flagw, psi);
+      cell = flagw;
       break;
     case TEMP:
     case IP:
     case TRACE:
-      Gauss_Seidel(para, var, flagp, psi);
+      cell = flagp;
       break;
     default:
       sprintf(msg, "equ_solver(): Solver for variable type %d is not defined.", 
               var_type);
       ffd_log(msg, FFD_ERROR);
-      flag = 1;
-      break;
+      return 1;
+  }
+
+  start_timer(para, PHASE_SOLVE);
+  if(para->solv->solver==TDMA) {
+    flag = TDMA_3D(para, var, cell, psi);
+    if(flag!=0) {
+      sprintf(msg, "equ_solver(): Could not solve variable type %d with TDMA.",
+              var_type);
+      ffd_log(msg, FFD_ERROR);
+    }
   }
+  else
+    Gauss_Seidel(para, var, var_type, cell, psi);
+  stop_timer(para, PHASE_SOLVE);
 
   return flag;
 }// end of equ_solver
\ No newline at end of file
@@ -58,6 +58,11 @@
 #include "solver_tdma.h"
 #endif
 
+#ifndef _SNAPSHOT_H
+#define _SNAPSHOT_H
+#include "snapshot.h"
+#endif
+
 #ifndef _BOUNDARY_H
 #define _BOUNDARY_H
 #include "boundary.h"
@@ -81,6 +86,17 @@
 ///////////////////////////////////////////////////////////////////////////////
 /// FFD solver
 ///
+/// If mytime.adaptive is 1, the time step size is set before each step by
+/// \c set_time_step(), so that the steps end exactly at the synchronization
+/// times of the cosimulation. A single simulation then runs until the time
+/// that the fixed time step would reach after step_total steps from t=0,
+/// also if it was restarted from a checkpoint.
+///
+/// If solv.steady is 1, a single simulation stops once \c monitor_steady()
+/// finds that the flow has settled, but after step_total steps at the
+/// latest. Together with the adaptive time step, a large mytime.cfl then
+/// serves as pseudo time step towards the steady state.
+///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
 ///\param BINDEX Pointer to boundary index
@@ -103,6 +119,9 @@ int temp_step(PARA_DATA *para, REAL **var, int **BINDEX);
 ///////////////////////////////////////////////////////////////////////////////
 /// Calculate the contaminant concentration
 ///
+/// All the trace substances are advected with one tracing of the departure 
+/// points and diffused with one set of coefficients.
+///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
 ///\param BINDEX Pointer to boundary index
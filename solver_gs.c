@@ -38,74 +38,28 @@ REAL GS_P(PARA_DATA *para, REAL **var, int Type, REAL *x) {
   REAL *flagp = var[FLAGP];
 
   /****************************************************************************
-  | Solve the space using G-S sovler for 5 * 6 = 30 times
+  | Solve the space using red-black G-S sovler for 5 * 4 = 20 times
   ****************************************************************************/
-  for(it=0; it<5; it++) {
-    /*-------------------------------------------------------------------------
-    | Solve in X(1->imax), Y(1->jmax), Z(1->kmax)
-    -------------------------------------------------------------------------*/
-    for(i=1; i<=imax; i++)
-      for(j=1; j<=jmax; j++)
-        for(k=1; k<=kmax; k++) {
-          if (flagp[IX(i,j,k)]>=0) continue;
-
-          x[IX(i,j,k)] = (  ae[IX(i,j,k)]*x[IX(i+1,j,k)] 
-                          + aw[IX(i,j,k)]*x[IX(i-1,j,k)]
-                          + an[IX(i,j,k)]*x[IX(i,j+1,k)]
-                          + as[IX(i,j,k)]*x[IX(i,j-1,k)]
-                          + af[IX(i,j,k)]*x[IX(i,j,k+1)]
-                          + ab[IX(i,j,k)]*x[IX(i,j,k-1)]
-                          + b[IX(i,j,k)] ) / ap[IX(i,j,k)];
-    }
-
-    /*-------------------------------------------------------------------------
-    | Solve in Y(1->kmax), X(1->imax), Z(1->kmax)
-    -------------------------------------------------------------------------*/
-    for(j=1; j<=jmax; j++)
-      for(i=1; i<=imax; i++)
-        for(k=1; k<=kmax; k++) {
-          if (flagp[IX(i,j,k)]>=0) continue;
-
-          x[IX(i,j,k)] = (  ae[IX(i,j,k)]*x[IX(i+1,j,k)] 
-                          + aw[IX(i,j,k)]*x[IX(i-1,j,k)]
-                          + an[IX(i,j,k)]*x[IX(i,j+1,k)]
-                          + as[IX(i,j,k)]*x[IX(i,j-1,k)]
-                          + af[IX(i,j,k)]*x[IX(i,j,k+1)]
-                          + ab[IX(i,j,k)]*x[IX(i,j,k-1)]
-                          + b[IX(i,j,k)] ) / ap[IX(i,j,k)];
-    }
-    /*-------------------------------------------------------------------------
-    | Solve in X(imax->), Y(jmax->1), Z(1->kmax)
-    -------------------------------------------------------------------------*/
-    for(i=imax; i>=1; i--)
-      for(j=jmax; j>=1; j--)
-        for(k=1; k<=kmax; k++) {
-          if (flagp[IX(i,j,k)]>=0) continue;
-
-          x[IX(i,j,k)] = (  ae[IX(i,j,k)]*x[IX(i+1,j,k)] 
-                          + aw[IX(i,j,k)]*x[IX(i-1,j,k)]
-                          + an[IX(i,j,k)]*x[IX(i,j+1,k)]
-                          + as[IX(i,j,k)]*x[IX(i,j-1,k)]
-                          + af[IX(i,j,k)]*x[IX(i,j,k+1)]
-                          + ab[IX(i,j,k)]*x[IX(i,j,k-1)]
-                          + b[IX(i,j,k)] ) / ap[IX(i,j,k)];
-    }
-    /*-------------------------------------------------------------------------
-    | Solve in Y(jmax->1), X(imax->1), Z(1->kmax)
-    -------------------------------------------------------------------------*/
-    for(j=jmax; j>=1; j--)
-      for(i=imax; i>=1; i--)
-        for(k=1; k<=kmax; k++) {
-          if (flagp[IX(i,j,k)]>=0) continue;
-
-          x[IX(i,j,k)] = (  ae[IX(i,j,k)]*x[IX(i+1,j,k)] 
-                          + aw[IX(i,j,k)]*x[IX(i-1,j,k)]
-                          + an[IX(i,j,k)]*x[IX(i,j+1,k)]
-                          + as[IX(i,j,k)]*x[IX(i,j-1,k)]
-                          + af[IX(i,j,k)]*x[IX(i,j,k+1)]
-                          + ab[IX(i,j,k)]*x[IX(i,j,k-1)]
-                          + b[IX(i,j,k)] ) / ap[IX(i,j,k)];
-    }
+  if(para->solv->gs_order==REDBLACK) {
+    for(it=0; it<5*4; it++)
+      GS_red_black(para, var, flagp, x, NULL);
+  }
+  /****************************************************************************
+  | Solve the space using G-S sovler for 5 * 4 = 20 times
+  |
+  | The sweeps which first go along Y give the same result as the ones which
+  | first go along X, since the result of a G-S sweep only depends on the
+  | sweep direction in each dimension and not on the loop order
+  ****************************************************************************/
+  else for(it=0; it<5; it++) {
+    // Solve in X(1->imax), Y(1->jmax), Z(1->kmax)
+    GS_sweep(para, var, flagp, x, 1, 1, 1, NULL);
+    // Solve in Y(1->jmax), X(1->imax), Z(1->kmax)
+    GS_sweep(para, var, flagp, x, 1, 1, 1, NULL);
+    // Solve in X(imax->1), Y(jmax->1), Z(1->kmax)
+    GS_sweep(para, var, flagp, x, -1, -1, 1, NULL);
+    // Solve in Y(jmax->1), X(imax->1), Z(1->kmax)
+    GS_sweep(para, var, flagp, x, -1, -1, 1, NULL);
   }
 
   /****************************************************************************
@@ -132,54 +86,91 @@ REAL GS_P(PARA_DATA *para, REAL **var, int Type, REAL *x) {
 ///////////////////////////////////////////////////////////////////////////////
 /// Gauss-Seidel solver
 ///
+/// By default, one forward and one backward sweep are done. With
+/// para->solv->gs_conv=1, the sweeps alternate between forward and backward
+/// until the residual is below para->solv->gs_tol. The minimum and maximum
+/// numbers of sweeps are set for each type of variable. The residual is
+/// estimated within the sweeps once the minimum number is reached, so that
+/// no extra pass over the cells is needed.
+///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
+///\param var_type Type of variable
 ///\param flag Pointer to the cell property flag
 ///\param x Pointer to variable
 ///
 ///\return Residual
 ///////////////////////////////////////////////////////////////////////////////
-REAL Gauss_Seidel(PARA_DATA *para, REAL **var, REAL *flag, REAL *x) {
+REAL Gauss_Seidel(PARA_DATA *para, REAL **var, int var_type, REAL *flag,
+                  REAL *x) {
   REAL *as = var[AS], *aw = var[AW], *ae = var[AE], *an = var[AN];
   REAL *ap = var[AP], *af = var[AF], *ab = var[AB], *b = var[B];
   int imax = para->geom->imax, jmax= para->geom->jmax;
   int kmax = para->geom->kmax;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);  
   int i, j, k, it=0;
+  int min_sweep, max_sweep;
   float tmp1, tmp2, residual;
 
   /****************************************************************************
-  | Gauss-Seidel solver
+  | Convergence controlled solver
   ****************************************************************************/
-  for(it=0; it<1; it++) {
-    for(i=1; i<=imax; i++)
-      for(j=1; j<=jmax; j++)
-        for(k=1; k<=kmax; k++) {
-          if (flag[IX(i,j,k)]>=0) continue;
+  if(para->solv->gs_conv==1) {
+    switch(var_type) {
+      case VX:
+      case VY:
+      case VZ:
+        min_sweep = para->solv->gs_min_vel;
+        max_sweep = para->solv->gs_max_vel;
+        break;
+      case TEMP:
+        min_sweep = para->solv->gs_min_temp;
+        max_sweep = para->solv->gs_max_temp;
+        break;
+      default:
+        min_sweep = para->solv->gs_min_trace;
+        max_sweep = para->solv->gs_max_trace;
+        break;
+    }
+    min_sweep = max(min_sweep, 1);
+    max_sweep = max(max_sweep, min_sweep);
 
-          x[IX(i,j,k)] = (  ae[IX(i,j,k)]*x[IX(i+1,j,k)] 
-                          + aw[IX(i,j,k)]*x[IX(i-1,j,k)]
-                          + an[IX(i,j,k)]*x[IX(i,j+1,k)]
-                          + as[IX(i,j,k)]*x[IX(i,j-1,k)]
-                          + af[IX(i,j,k)]*x[IX(i,j,k+1)]
-                          + ab[IX(i,j,k)]*x[IX(i,j,k-1)]
-                          + b[IX(i,j,k)] ) / ap[IX(i,j,k)];
+    residual = 0;
+    for(it=1; it<=max_sweep; it++) {
+      if(para->solv->gs_order==REDBLACK)
+        GS_red_black(para, var, flag, x, it<min_sweep ? NULL : &residual);
+      else if(it%2==1)
+        GS_sweep(para, var, flag, x, 1, 1, 1,
+                 it<min_sweep ? NULL : &residual);
+      else
+        GS_sweep(para, var, flag, x, -1, -1, 1,
+                 it<min_sweep ? NULL : &residual);
 
-        }
-    
-    for(i=imax; i>=1; i--)
-      for(j=jmax; j>=1; j--)
-        for(k=1; k<=kmax; k++) {
-          if (flag[IX(i,j,k)]>=0) continue;
+      if(it>=min_sweep && residual<para->solv->gs_tol) break;
+    }
 
-          x[IX(i,j,k)] = (  ae[IX(i,j,k)]*x[IX(i+1,j,k)] 
-                          + aw[IX(i,j,k)]*x[IX(i-1,j,k)]
-                          + an[IX(i,j,k)]*x[IX(i,j+1,k)]
-                          + as[IX(i,j,k)]*x[IX(i,j-1,k)]
-                          + af[IX(i,j,k)]*x[IX(i,j,k+1)]
-                          + ab[IX(i,j,k)]*x[IX(i,j,k-1)]
-                          + b[IX(i,j,k)] ) / ap[IX(i,j,k)];
-        }    
+    if(it>max_sweep) {
+      sprintf(msg, "Gauss_Seidel(): Variable type %d did not converge in %d "
+              "sweeps, residual=%e", var_type, max_sweep, residual);
+      ffd_log(msg, FFD_WARNING);
+    }
+
+    return residual;
+  }
+
+  /****************************************************************************
+  | Red-black Gauss-Seidel solver with the same number of sweeps
+  ****************************************************************************/
+  if(para->solv->gs_order==REDBLACK) {
+    GS_red_black(para, var, flag, x, NULL);
+    GS_red_black(para, var, flag, x, NULL);
+  }
+  /****************************************************************************
+  | Gauss-Seidel solver
+  ****************************************************************************/
+  else {
+    GS_sweep(para, var, flag, x, 1, 1, 1, NULL);
+    GS_sweep(para, var, flag, x, -1, -1, 1, NULL);
   }
 
   /****************************************************************************
@@ -203,3 +194,113 @@ REAL Gauss_Seidel(PARA_DATA *para, REAL **var, REAL *flag, REAL *x) {
   return residual;
 } // End of Gauss-Seidel( )
 
+///////////////////////////////////////////////////////////////////////////////
+/// One red-black Gauss-Seidel sweep
+///
+/// The cells are split into two colors by the parity of i+j+k. Cells of one
+/// color only depend on cells of the other color, so each half sweep can be
+/// updated in parallel if the code is compiled with OpenMP.
+///
+/// If residual is not NULL, the residual before the update of each cell is
+/// summed up during the sweep. The sum is normalized in the same way as in
+/// \c Gauss_Seidel().
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param flag Pointer to the cell property flag
+///\param x Pointer to variable
+///\param residual Pointer to the estimated residual or NULL
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void GS_red_black(PARA_DATA *para, REAL **var, REAL *flag, REAL *x,
+                  REAL *residual) {
+  REAL *as = var[AS], *aw = var[AW], *ae = var[AE], *an = var[AN];
+  REAL *ap = var[AP], *af = var[AF], *ab = var[AB], *b = var[B];
+  int imax = para->geom->imax, jmax= para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int i, j, k, color;
+  REAL tmp, sum = 0, norm = (REAL) 0.0000000001;
+
+  for(color=0; color<2; color++) {
+#pragma omp parallel for private(i, j, tmp) reduction(+:sum, norm) \
+                         schedule(static)
+    for(k=1; k<=kmax; k++)
+      for(j=1; j<=jmax; j++)
+        // Start from the first cell with (i+j+k)%2==color
+        for(i=1+(1+j+k+color)%2; i<=imax; i+=2) {
+          if (flag[IX(i,j,k)]>=0) continue;
+
+          tmp = (  ae[IX(i,j,k)]*x[IX(i+1,j,k)]
+                 + aw[IX(i,j,k)]*x[IX(i-1,j,k)]
+                 + an[IX(i,j,k)]*x[IX(i,j+1,k)]
+                 + as[IX(i,j,k)]*x[IX(i,j-1,k)]
+                 + af[IX(i,j,k)]*x[IX(i,j,k+1)]
+                 + ab[IX(i,j,k)]*x[IX(i,j,k-1)]
+                 + b[IX(i,j,k)] ) / ap[IX(i,j,k)];
+          if(residual!=NULL) {
+            sum += (REAL) fabs(ap[IX(i,j,k)]*(tmp-x[IX(i,j,k)]));
+            norm += (REAL) fabs(ap[IX(i,j,k)]*tmp);
+          }
+          x[IX(i,j,k)] = tmp;
+        }
+  }
+
+  if(residual!=NULL) *residual = sum / norm;
+} // End of GS_red_black()
+
+///////////////////////////////////////////////////////////////////////////////
+/// One Gauss-Seidel sweep in the given direction
+///
+/// The loops run with I innermost so that the cells are visited in the order
+/// of the memory. Since every neighbor in the sweep direction is updated
+/// before the cell and every other neighbor after it, the result is the
+/// same as the one of the loops with K innermost.
+///
+/// If residual is not NULL, the residual before the update of each cell is
+/// summed up during the sweep. The sum is normalized in the same way as in
+/// \c Gauss_Seidel().
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param flag Pointer to the cell property flag
+///\param x Pointer to variable
+///\param di Sweep direction in X: 1 for 1->imax, -1 for imax->1
+///\param dj Sweep direction in Y: 1 for 1->jmax, -1 for jmax->1
+///\param dk Sweep direction in Z: 1 for 1->kmax, -1 for kmax->1
+///\param residual Pointer to the estimated residual or NULL
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void GS_sweep(PARA_DATA *para, REAL **var, REAL *flag, REAL *x,
+              int di, int dj, int dk, REAL *residual) {
+  REAL *as = var[AS], *aw = var[AW], *ae = var[AE], *an = var[AN];
+  REAL *ap = var[AP], *af = var[AF], *ab = var[AB], *b = var[B];
+  int imax = para->geom->imax, jmax= para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int i, j, k, ni, nj, nk;
+  REAL tmp, sum = 0, norm = (REAL) 0.0000000001;
+
+  for(nk=0, k=dk>0 ? 1 : kmax; nk<kmax; nk++, k+=dk)
+    for(nj=0, j=dj>0 ? 1 : jmax; nj<jmax; nj++, j+=dj)
+      for(ni=0, i=di>0 ? 1 : imax; ni<imax; ni++, i+=di) {
+        if (flag[IX(i,j,k)]>=0) continue;
+
+        tmp = (  ae[IX(i,j,k)]*x[IX(i+1,j,k)]
+               + aw[IX(i,j,k)]*x[IX(i-1,j,k)]
+               + an[IX(i,j,k)]*x[IX(i,j+1,k)]
+               + as[IX(i,j,k)]*x[IX(i,j-1,k)]
+               + af[IX(i,j,k)]*x[IX(i,j,k+1)]
+               + ab[IX(i,j,k)]*x[IX(i,j,k-1)]
+               + b[IX(i,j,k)] ) / ap[IX(i,j,k)];
+        if(residual!=NULL) {
+          sum += (REAL) fabs(ap[IX(i,j,k)]*(tmp-x[IX(i,j,k)]));
+          norm += (REAL) fabs(ap[IX(i,j,k)]*tmp);
+        }
+        x[IX(i,j,k)] = tmp;
+      }
+
+  if(residual!=NULL) *residual = sum / norm;
+} // End of GS_sweep()
@@ -49,12 +49,68 @@ REAL GS_P(PARA_DATA *para, REAL **var, int Type, REAL *x);
 ///////////////////////////////////////////////////////////////////////////////
 /// Gauss-Seidel solver
 ///
+/// By default, one forward and one backward sweep are done. With
+/// para->solv->gs_conv=1, the sweeps alternate between forward and backward
+/// until the residual is below para->solv->gs_tol. The minimum and maximum
+/// numbers of sweeps are set for each type of variable. The residual is
+/// estimated within the sweeps once the minimum number is reached, so that
+/// no extra pass over the cells is needed.
+///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
+///\param var_type Type of variable
 ///\param flag Pointer to the cell property flag
 ///\param x Pointer to variable
 ///
 ///\return Residual
 ///////////////////////////////////////////////////////////////////////////////
-REAL Gauss_Seidel(PARA_DATA *para, REAL **var, REAL *flagp, REAL *x);
+REAL Gauss_Seidel(PARA_DATA *para, REAL **var, int var_type, REAL *flag,
+                  REAL *x);
+
+///////////////////////////////////////////////////////////////////////////////
+/// One red-black Gauss-Seidel sweep
+///
+/// The cells are split into two colors by the parity of i+j+k. Cells of one
+/// color only depend on cells of the other color, so each half sweep can be
+/// updated in parallel if the code is compiled with OpenMP.
+///
+/// If residual is not NULL, the residual before the update of each cell is
+/// summed up during the sweep. The sum is normalized in the same way as in
+/// \c Gauss_Seidel().
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param flag Pointer to the cell property flag
+///\param x Pointer to variable
+///\param residual Pointer to the estimated residual or NULL
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void GS_red_black(PARA_DATA *para, REAL **var, REAL *flag, REAL *x,
+                  REAL *residual);
 
+///////////////////////////////////////////////////////////////////////////////
+/// One Gauss-Seidel sweep in the given direction
+///
+/// The loops run with I innermost so that the cells are visited in the order
+/// of the memory. Since every neighbor in the sweep direction is updated
+/// before the cell and every other neighbor after it, the result is the
+/// same as the one of the loops with K innermost.
+///
+/// If residual is not NULL, the residual before the update of each cell is
+/// summed up during the sweep. The sum is normalized in the same way as in
+/// \c Gauss_Seidel().
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param flag Pointer to the cell property flag
+///\param x Pointer to variable
+///\param di Sweep direction in X: 1 for 1->imax, -1 for imax->1
+///\param dj Sweep direction in Y: 1 for 1->jmax, -1 for jmax->1
+///\param dk Sweep direction in Z: 1 for 1->kmax, -1 for kmax->1
+///\param residual Pointer to the estimated residual or NULL
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void GS_sweep(PARA_DATA *para, REAL **var, REAL *flag, REAL *x,
+              int di, int dj, int dk, REAL *residual);
@@ -0,0 +1,540 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// \file   solver_mg.c
+///
+/// \brief  Geometric multigrid solver for the pressure equation
+///
+/// \author agent
+///         agent@local
+///
+/// \date   10/17/2026
+///
+/// This file provides a V-cycle multigrid solver that works on the same
+/// coefficients (AP, AE, AW, AN, AS, AF, AB and B) as the Gauss-Seidel
+/// solver. The coarse grids are built by merging pairs of cells in each
+/// direction of the non-uniform FFD grid and the coarse equations are
+/// assembled from the fine ones, so that walls and internal blocks defined
+/// by FLAGP are kept on all the levels.
+///
+///////////////////////////////////////////////////////////////////////////////
+
+#include "solver_mg.h"
+
+#define MG_MAX_LEVEL  10 // Maximum number of grid levels
+#define MG_PRE_SWEEP  2  // Gauss-Seidel sweeps before restriction
+#define MG_POST_SWEEP 2  // Gauss-Seidel sweeps after prolongation
+#define MG_COARSEST_SWEEP 50 // Gauss-Seidel sweeps on the coarsest level
+#define MG_OVER_CORRECTION 1.8f // Scaling of the piecewise constant correction
+
+///////////////////////////////////////////////////////////////////////////////
+/// Multigrid solver for pressure
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param Type Type of variable
+///\param x Pointer to variable
+///
+///\return Residual
+///////////////////////////////////////////////////////////////////////////////
+REAL MG_P(PARA_DATA *para, REAL **var, int Type, REAL *x) {
+  MG_DATA *mg;
+  MG_LEVEL *fine;
+  int l, it;
+  REAL residual;
+
+  /****************************************************************************
+  | Build the grid hierarchy at the first call
+  ****************************************************************************/
+  if(para->solv->mg==NULL) {
+    if(allocate_mg_data(para, var)!=0) {
+      ffd_log("MG_P(): Could not allocate memory for multigrid solver.",
+              FFD_ERROR);
+      return -1;
+    }
+  }
+
+  mg = para->solv->mg;
+  fine = &mg->level[0];
+  fine->x = x;
+
+  /****************************************************************************
+  | Assemble the coarse equations since the coefficients of the FFD grid
+  | are recomputed before each call
+  ****************************************************************************/
+  for(l=1; l<mg->nb_level; l++)
+    mg_coarse_equation(&mg->level[l-1], &mg->level[l]);
+
+  mg_compatible_source(fine);
+
+  /****************************************************************************
+  | V-cycles until the residual target is reached
+  ****************************************************************************/
+  residual = mg_residual(fine);
+  for(it=0; it<para->solv->p_max_iter && residual>para->solv->p_tol; it++) {
+    mg_vcycle(mg, 0);
+    residual = mg_residual(fine);
+  }
+
+  if(para->solv->check_residual==1) {
+    sprintf(msg, "MG_P(): Residual is %e after %d V-cycles", residual, it);
+    ffd_log(msg, FFD_NORMAL);
+  }
+
+  return residual;
+} // End of MG_P()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Allocate memory for the grid hierarchy of the multigrid solver
+///
+/// If an error occurs, the memory allocated so far is freed and
+/// para->solv->mg is reset to NULL, so that the next call starts again.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int allocate_mg_data(PARA_DATA *para, REAL **var) {
+  MG_DATA *mg;
+  MG_LEVEL *lev, *fine;
+  int l, i, j, k, size;
+  int imax, jmax, kmax, IMAX, IJMAX;
+  int fimax, fjmax, fkmax, FIMAX, FIJMAX;
+
+  mg = (MG_DATA *) malloc(sizeof(MG_DATA));
+  if(mg==NULL) {
+    ffd_log("allocate_mg_data(): Could not allocate memory for mg.",
+            FFD_ERROR);
+    return 1;
+  }
+  mg->level = (MG_LEVEL *) calloc(MG_MAX_LEVEL, sizeof(MG_LEVEL));
+  if(mg->level==NULL) {
+    ffd_log("allocate_mg_data(): Could not allocate memory for mg->level.",
+            FFD_ERROR);
+    free(mg);
+    return 1;
+  }
+  para->solv->mg = mg;
+
+  /****************************************************************************
+  | The finest level uses the FFD variables directly
+  ****************************************************************************/
+  lev = &mg->level[0];
+  lev->imax = para->geom->imax;
+  lev->jmax = para->geom->jmax;
+  lev->kmax = para->geom->kmax;
+  lev->ap = var[AP];
+  lev->ae = var[AE];
+  lev->aw = var[AW];
+  lev->an = var[AN];
+  lev->as = var[AS];
+  lev->af = var[AF];
+  lev->ab = var[AB];
+  lev->b = var[B];
+  lev->flag = var[FLAGP];
+  size = (lev->imax+2) * (lev->jmax+2) * (lev->kmax+2);
+  lev->r = (REAL *) calloc(size, sizeof(REAL));
+  if(lev->r==NULL) {
+    ffd_log("allocate_mg_data(): Could not allocate memory for residual.",
+            FFD_ERROR);
+    free_mg_data(para);
+    return 1;
+  }
+  mg->nb_level = 1;
+
+  /****************************************************************************
+  | Coarsen the grid until no direction can be coarsened any more
+  ****************************************************************************/
+  for(l=1; l<MG_MAX_LEVEL; l++) {
+    fine = &mg->level[l-1];
+    fimax = fine->imax;
+    fjmax = fine->jmax;
+    fkmax = fine->kmax;
+    // Merge two cells in the direction with more than 2 cells
+    imax = fimax>2 ? (fimax+1)/2 : fimax;
+    jmax = fjmax>2 ? (fjmax+1)/2 : fjmax;
+    kmax = fkmax>2 ? (fkmax+1)/2 : fkmax;
+    if(imax==fimax && jmax==fjmax && kmax==fkmax) break;
+
+    /*-------------------------------------------------------------------------
+    | Map the fine cells to the coarse cells
+    -------------------------------------------------------------------------*/
+    fine->ic = (int *) malloc((fimax+2)*sizeof(int));
+    fine->jc = (int *) malloc((fjmax+2)*sizeof(int));
+    fine->kc = (int *) malloc((fkmax+2)*sizeof(int));
+    if(fine->ic==NULL || fine->jc==NULL || fine->kc==NULL) {
+      sprintf(msg, "allocate_mg_data(): Could not allocate memory for "
+              "index map of level %d", l-1);
+      ffd_log(msg, FFD_ERROR);
+      free_mg_data(para);
+      return 1;
+    }
+    for(i=0; i<=fimax+1; i++)
+      fine->ic[i] = imax==fimax ? i : (i+1)/2;
+    for(j=0; j<=fjmax+1; j++)
+      fine->jc[j] = jmax==fjmax ? j : (j+1)/2;
+    for(k=0; k<=fkmax+1; k++)
+      fine->kc[k] = kmax==fkmax ? k : (k+1)/2;
+    // The ghost cells are mapped to the ghost cells
+    fine->ic[fimax+1] = imax+1;
+    fine->jc[fjmax+1] = jmax+1;
+    fine->kc[fkmax+1] = kmax+1;
+
+    /*-------------------------------------------------------------------------
+    | Allocate the coarse level
+    -------------------------------------------------------------------------*/
+    lev = &mg->level[l];
+    lev->imax = imax;
+    lev->jmax = jmax;
+    lev->kmax = kmax;
+    size = (imax+2) * (jmax+2) * (kmax+2);
+    lev->ap = (REAL *) calloc(size, sizeof(REAL));
+    lev->ae = (REAL *) calloc(size, sizeof(REAL));
+    lev->aw = (REAL *) calloc(size, sizeof(REAL));
+    lev->an = (REAL *) calloc(size, sizeof(REAL));
+    lev->as = (REAL *) calloc(size, sizeof(REAL));
+    lev->af = (REAL *) calloc(size, sizeof(REAL));
+    lev->ab = (REAL *) calloc(size, sizeof(REAL));
+    lev->b = (REAL *) calloc(size, sizeof(REAL));
+    lev->x = (REAL *) calloc(size, sizeof(REAL));
+    lev->r = (REAL *) calloc(size, sizeof(REAL));
+    lev->flag = (REAL *) calloc(size, sizeof(REAL));
+    mg->nb_level = l+1;
+    if(lev->ap==NULL || lev->ae==NULL || lev->aw==NULL || lev->an==NULL
+       || lev->as==NULL || lev->af==NULL || lev->ab==NULL || lev->b==NULL
+       || lev->x==NULL || lev->r==NULL || lev->flag==NULL) {
+      sprintf(msg, "allocate_mg_data(): Could not allocate memory for "
+              "level %d", l);
+      ffd_log(msg, FFD_ERROR);
+      free_mg_data(para);
+      return 1;
+    }
+
+    /*-------------------------------------------------------------------------
+    | A coarse cell is solved if any of its fine cells is solved
+    -------------------------------------------------------------------------*/
+    IMAX = imax+2;
+    IJMAX = (imax+2)*(jmax+2);
+    FIMAX = fimax+2;
+    FIJMAX = (fimax+2)*(fjmax+2);
+    for(i=0; i<size; i++) lev->flag[i] = SOLID;
+
+    for(k=1; k<=fkmax; k++)
+      for(j=1; j<=fjmax; j++)
+        for(i=1; i<=fimax; i++)
+          if(fine->flag[i+FIMAX*j+FIJMAX*k]<0)
+            lev->flag[IX(fine->ic[i],fine->jc[j],fine->kc[k])] = FLUID;
+
+    sprintf(msg, "allocate_mg_data(): Multigrid level %d has %d*%d*%d cells",
+            l, imax, jmax, kmax);
+    ffd_log(msg, FFD_NORMAL);
+  }
+
+  return 0;
+} // End of allocate_mg_data()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free memory for the grid hierarchy of the multigrid solver
+///
+///\param para Pointer to FFD parameters
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_mg_data(PARA_DATA *para) {
+  MG_DATA *mg = para->solv->mg;
+  MG_LEVEL *lev;
+  int l;
+
+  if(mg==NULL) return;
+
+  for(l=0; l<MG_MAX_LEVEL; l++) {
+    lev = &mg->level[l];
+    // The finest level shares the coefficients with the FFD variables
+    if(l>0) {
+      if(lev->ap) free(lev->ap);
+      if(lev->ae) free(lev->ae);
+      if(lev->aw) free(lev->aw);
+      if(lev->an) free(lev->an);
+      if(lev->as) free(lev->as);
+      if(lev->af) free(lev->af);
+      if(lev->ab) free(lev->ab);
+      if(lev->b) free(lev->b);
+      if(lev->x) free(lev->x);
+      if(lev->flag) free(lev->flag);
+    }
+    if(lev->r) free(lev->r);
+    if(lev->ic) free(lev->ic);
+    if(lev->jc) free(lev->jc);
+    if(lev->kc) free(lev->kc);
+  }
+
+  free(mg->level);
+  free(mg);
+  para->solv->mg = NULL;
+} // End of free_mg_data()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Assemble the equations on a coarse level from the ones on the fine level
+///
+/// The coarse coefficient between two coarse cells is the sum of the fine
+/// coefficients across their common face. The coefficients between fine
+/// cells inside the same coarse cell are removed from the center
+/// coefficient. This is equal to the Galerkin product with piecewise
+/// constant transfer operators and thus needs no geometry information.
+///
+///\param fine Pointer to the fine level
+///\param coarse Pointer to the coarse level
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void mg_coarse_equation(MG_LEVEL *fine, MG_LEVEL *coarse) {
+  int i, j, k, ci, cj, ck, it, itc;
+  int imax = fine->imax, jmax = fine->jmax, kmax = fine->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int CIMAX = coarse->imax+2, CIJMAX = (coarse->imax+2)*(coarse->jmax+2);
+  int size = (coarse->imax+2)*(coarse->jmax+2)*(coarse->kmax+2);
+  REAL *flag = fine->flag;
+
+  for(itc=0; itc<size; itc++) {
+    coarse->ap[itc] = 0;
+    coarse->ae[itc] = 0;
+    coarse->aw[itc] = 0;
+    coarse->an[itc] = 0;
+    coarse->as[itc] = 0;
+    coarse->af[itc] = 0;
+    coarse->ab[itc] = 0;
+  }
+
+  for(k=1; k<=kmax; k++)
+    for(j=1; j<=jmax; j++)
+      for(i=1; i<=imax; i++) {
+        it = IX(i,j,k);
+        if(flag[it]>=0) continue;
+
+        ci = fine->ic[i];
+        cj = fine->jc[j];
+        ck = fine->kc[k];
+        itc = ci + CIMAX*cj + CIJMAX*ck;
+
+        coarse->ap[itc] += fine->ap[it];
+
+        // Neighbors that are not solved do not couple to the correction
+        if(flag[IX(i+1,j,k)]<0) {
+          if(fine->ic[i+1]!=ci) coarse->ae[itc] += fine->ae[it];
+          else coarse->ap[itc] -= fine->ae[it];
+        }
+        if(flag[IX(i-1,j,k)]<0) {
+          if(fine->ic[i-1]!=ci) coarse->aw[itc] += fine->aw[it];
+          else coarse->ap[itc] -= fine->aw[it];
+        }
+        if(flag[IX(i,j+1,k)]<0) {
+          if(fine->jc[j+1]!=cj) coarse->an[itc] += fine->an[it];
+          else coarse->ap[itc] -= fine->an[it];
+        }
+        if(flag[IX(i,j-1,k)]<0) {
+          if(fine->jc[j-1]!=cj) coarse->as[itc] += fine->as[it];
+          else coarse->ap[itc] -= fine->as[it];
+        }
+        if(flag[IX(i,j,k+1)]<0) {
+          if(fine->kc[k+1]!=ck) coarse->af[itc] += fine->af[it];
+          else coarse->ap[itc] -= fine->af[it];
+        }
+        if(flag[IX(i,j,k-1)]<0) {
+          if(fine->kc[k-1]!=ck) coarse->ab[itc] += fine->ab[it];
+          else coarse->ap[itc] -= fine->ab[it];
+        }
+      }
+} // End of mg_coarse_equation()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Gauss-Seidel smoother for one level
+///
+///\param lev Pointer to the level
+///\param nb_sweep Number of sweeps
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void mg_smooth(MG_LEVEL *lev, int nb_sweep) {
+  REAL *as = lev->as, *aw = lev->aw, *ae = lev->ae, *an = lev->an;
+  REAL *ap = lev->ap, *af = lev->af, *ab = lev->ab, *b = lev->b;
+  REAL *x = lev->x, *flag = lev->flag;
+  int imax = lev->imax, jmax = lev->jmax, kmax = lev->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int i, j, k, it;
+
+  for(it=0; it<nb_sweep; it++)
+    for(k=1; k<=kmax; k++)
+      for(j=1; j<=jmax; j++)
+        for(i=1; i<=imax; i++) {
+          if(flag[IX(i,j,k)]>=0 || ap[IX(i,j,k)]==0) continue;
+
+          x[IX(i,j,k)] = (  ae[IX(i,j,k)]*x[IX(i+1,j,k)]
+                          + aw[IX(i,j,k)]*x[IX(i-1,j,k)]
+                          + an[IX(i,j,k)]*x[IX(i,j+1,k)]
+                          + as[IX(i,j,k)]*x[IX(i,j-1,k)]
+                          + af[IX(i,j,k)]*x[IX(i,j,k+1)]
+                          + ab[IX(i,j,k)]*x[IX(i,j,k-1)]
+                          + b[IX(i,j,k)] ) / ap[IX(i,j,k)];
+        }
+} // End of mg_smooth()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Remove the part of the source that is not compatible with a pure Neumann
+/// problem
+///
+/// If no cell of the level is connected to a fixed value, the equations are
+/// singular and the smoother can not reduce the mean value of the residual.
+/// The mean value of the source is then removed, so that the coarse levels
+/// receive compatible sources as well.
+///
+///\param lev Pointer to the level
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void mg_compatible_source(MG_LEVEL *lev) {
+  REAL *as = lev->as, *aw = lev->aw, *ae = lev->ae, *an = lev->an;
+  REAL *ap = lev->ap, *af = lev->af, *ab = lev->ab, *b = lev->b;
+  REAL *flag = lev->flag;
+  int imax = lev->imax, jmax = lev->jmax, kmax = lev->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int i, j, k, nb_cell = 0;
+  double mean = 0, excess = 0, diag = 0;
+
+  for(k=1; k<=kmax; k++)
+    for(j=1; j<=jmax; j++)
+      for(i=1; i<=imax; i++) {
+        if(flag[IX(i,j,k)]>=0) continue;
+        mean += b[IX(i,j,k)];
+        excess += fabs(ap[IX(i,j,k)] - ae[IX(i,j,k)] - aw[IX(i,j,k)]
+                       - an[IX(i,j,k)] - as[IX(i,j,k)]
+                       - af[IX(i,j,k)] - ab[IX(i,j,k)]);
+        diag += fabs(ap[IX(i,j,k)]);
+        nb_cell++;
+      }
+
+  if(nb_cell==0 || excess>1e-6*diag) return;
+
+  mean /= nb_cell;
+  for(k=1; k<=kmax; k++)
+    for(j=1; j<=jmax; j++)
+      for(i=1; i<=imax; i++)
+        if(flag[IX(i,j,k)]<0) b[IX(i,j,k)] -= (REAL) mean;
+} // End of mg_compatible_source()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Calculate the residual of one level
+///
+/// The residual is stored in lev->r. The returned value is normalized by the
+/// source b, since a normalization by ap*x would hide the divergence of the
+/// new velocities when the pressure of the last time step is large.
+///
+///\param lev Pointer to the level
+///
+///\return Normalized residual
+///////////////////////////////////////////////////////////////////////////////
+REAL mg_residual(MG_LEVEL *lev) {
+  REAL *as = lev->as, *aw = lev->aw, *ae = lev->ae, *an = lev->an;
+  REAL *ap = lev->ap, *af = lev->af, *ab = lev->ab, *b = lev->b;
+  REAL *x = lev->x, *r = lev->r, *flag = lev->flag;
+  int imax = lev->imax, jmax = lev->jmax, kmax = lev->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int i, j, k;
+  REAL tmp1 = 0, tmp2 = (REAL)0.0000000001;
+
+  for(k=1; k<=kmax; k++)
+    for(j=1; j<=jmax; j++)
+      for(i=1; i<=imax; i++) {
+        if(flag[IX(i,j,k)]>=0) {
+          r[IX(i,j,k)] = 0;
+          continue;
+        }
+
+        r[IX(i,j,k)] = b[IX(i,j,k)]
+                     + ae[IX(i,j,k)]*x[IX(i+1,j,k)] + aw[IX(i,j,k)]*x[IX(i-1,j,k)]
+                     + an[IX(i,j,k)]*x[IX(i,j+1,k)] + as[IX(i,j,k)]*x[IX(i,j-1,k)]
+                     + af[IX(i,j,k)]*x[IX(i,j,k+1)] + ab[IX(i,j,k)]*x[IX(i,j,k-1)]
+                     - ap[IX(i,j,k)]*x[IX(i,j,k)];
+        tmp1 += (REAL) fabs(r[IX(i,j,k)]);
+        tmp2 += (REAL) fabs(b[IX(i,j,k)]);
+      }
+
+  return tmp1 / tmp2;
+} // End of mg_residual()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Transfer the residual of the fine level to the source of the coarse level
+///
+///\param fine Pointer to the fine level
+///\param coarse Pointer to the coarse level
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void mg_restrict(MG_LEVEL *fine, MG_LEVEL *coarse) {
+  int i, j, k;
+  int imax = fine->imax, jmax = fine->jmax, kmax = fine->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int CIMAX = coarse->imax+2, CIJMAX = (coarse->imax+2)*(coarse->jmax+2);
+  int size = (coarse->imax+2)*(coarse->jmax+2)*(coarse->kmax+2);
+
+  for(i=0; i<size; i++) {
+    coarse->b[i] = 0;
+    coarse->x[i] = 0;
+  }
+
+  for(k=1; k<=kmax; k++)
+    for(j=1; j<=jmax; j++)
+      for(i=1; i<=imax; i++)
+        coarse->b[fine->ic[i]+CIMAX*fine->jc[j]+CIJMAX*fine->kc[k]]
+          += fine->r[IX(i,j,k)];
+} // End of mg_restrict()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Add the correction of the coarse level to the solution of the fine level
+///
+/// The piecewise constant correction underestimates the smooth error, so it
+/// is scaled by MG_OVER_CORRECTION.
+///
+///\param coarse Pointer to the coarse level
+///\param fine Pointer to the fine level
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void mg_prolong(MG_LEVEL *coarse, MG_LEVEL *fine) {
+  int i, j, k;
+  int imax = fine->imax, jmax = fine->jmax, kmax = fine->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int CIMAX = coarse->imax+2, CIJMAX = (coarse->imax+2)*(coarse->jmax+2);
+
+  for(k=1; k<=kmax; k++)
+    for(j=1; j<=jmax; j++)
+      for(i=1; i<=imax; i++) {
+        if(fine->flag[IX(i,j,k)]>=0) continue;
+        fine->x[IX(i,j,k)] += MG_OVER_CORRECTION
+          * coarse->x[fine->ic[i]+CIMAX*fine->jc[j]+CIJMAX*fine->kc[k]];
+      }
+} // End of mg_prolong()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Recursive V-cycle starting from level l
+///
+///\param mg Pointer to the multigrid hierarchy
+///\param l Index of the level
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void mg_vcycle(MG_DATA *mg, int l) {
+  MG_LEVEL *lev = &mg->level[l];
+
+  // Solve the coarsest level
+  if(l==mg->nb_level-1) {
+    mg_smooth(lev, MG_COARSEST_SWEEP);
+    return;
+  }
+
+  mg_smooth(lev, MG_PRE_SWEEP);
+  mg_residual(lev);
+  mg_restrict(lev, &mg->level[l+1]);
+  mg_vcycle(mg, l+1);
+  mg_prolong(&mg->level[l+1], lev);
+  mg_smooth(lev, MG_POST_SWEEP);
+} // End of mg_vcycle()
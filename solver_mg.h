@@ -0,0 +1,139 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// \file   solver_mg.h
+///
+/// \brief  Geometric multigrid solver for the pressure equation
+///
+/// \author agent
+///         agent@local
+///
+/// \date   10/17/2026
+///
+/// This file provides a V-cycle multigrid solver that works on the same
+/// coefficients (AP, AE, AW, AN, AS, AF, AB and B) as the Gauss-Seidel
+/// solver. The coarse grids are built by merging pairs of cells in each
+/// direction of the non-uniform FFD grid and the coarse equations are
+/// assembled from the fine ones, so that walls and internal blocks defined
+/// by FLAGP are kept on all the levels.
+///
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef _SOLVER_MG_H
+#define _SOLVER_MG_H
+#endif
+
+#ifndef _DATA_STRUCTURE_H
+#define _DATA_STRUCTURE_H
+#include "data_structure.h"
+#endif
+
+#ifndef _UTILITY_H
+#define _UTILITY_H
+#include "utility.h"
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+/// Multigrid solver for pressure
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param Type Type of variable
+///\param x Pointer to variable
+///
+///\return Residual
+///////////////////////////////////////////////////////////////////////////////
+REAL MG_P(PARA_DATA *para, REAL **var, int Type, REAL *x);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Allocate memory for the grid hierarchy of the multigrid solver
+///
+/// If an error occurs, the memory allocated so far is freed and
+/// para->solv->mg is reset to NULL, so that the next call starts again.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int allocate_mg_data(PARA_DATA *para, REAL **var);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free memory for the grid hierarchy of the multigrid solver
+///
+///\param para Pointer to FFD parameters
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_mg_data(PARA_DATA *para);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Assemble the equations on a coarse level from the ones on the fine level
+///
+///\param fine Pointer to the fine level
+///\param coarse Pointer to the coarse level
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void mg_coarse_equation(MG_LEVEL *fine, MG_LEVEL *coarse);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Gauss-Seidel smoother for one level
+///
+///\param lev Pointer to the level
+///\param nb_sweep Number of sweeps
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void mg_smooth(MG_LEVEL *lev, int nb_sweep);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Remove the part of the source that is not compatible with a pure Neumann
+/// problem
+///
+///\param lev Pointer to the level
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void mg_compatible_source(MG_LEVEL *lev);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Calculate the residual of one level
+///
+/// The residual is stored in lev->r. The returned value is normalized by the
+/// source b.
+///
+///\param lev Pointer to the level
+///
+///\return Normalized residual
+///////////////////////////////////////////////////////////////////////////////
+REAL mg_residual(MG_LEVEL *lev);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Transfer the residual of the fine level to the source of the coarse level
+///
+///\param fine Pointer to the fine level
+///\param coarse Pointer to the coarse level
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void mg_restrict(MG_LEVEL *fine, MG_LEVEL *coarse);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Add the correction of the coarse level to the solution of the fine level
+///
+///\param coarse Pointer to the coarse level
+///\param fine Pointer to the fine level
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void mg_prolong(MG_LEVEL *coarse, MG_LEVEL *fine);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Recursive V-cycle starting from level l
+///
+///\param mg Pointer to the multigrid hierarchy
+///\param l Index of the level
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void mg_vcycle(MG_DATA *mg, int l);
@@ -0,0 +1,382 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// \file   solver_pcg.c
+///
+/// \brief  Preconditioned conjugate gradient solver for the pressure equation
+///
+/// \author agent
+///         agent@local
+///
+/// \date   10/17/2026
+///
+/// This file provides a conjugate gradient solver for the symmetric pressure
+/// equation. It works on the same coefficients (AP, AE, AW, AN, AS, AF, AB
+/// and B) as the Gauss-Seidel solver and only solves the cells with
+/// FLAGP<0. The preconditioner can be Jacobi, symmetric Gauss-Seidel (SSOR
+/// with relaxation factor 1) or incomplete Cholesky without fill-in.
+///
+///////////////////////////////////////////////////////////////////////////////
+
+#include "solver_pcg.h"
+
+///////////////////////////////////////////////////////////////////////////////
+/// Preconditioned conjugate gradient solver for pressure
+///
+/// The iteration stops when the residual, normalized by the source b, is
+/// below para->solv->p_tol or after para->solv->pcg_max_iter iterations.
+/// The pressure of the last time step is the initial guess, so a
+/// normalization by ap*x would stop the iteration too early. If the
+/// coefficients define a pure Neumann problem, the mean value of the initial
+/// residual is removed so that the iteration stays in the range of the
+/// matrix. A warning is logged if the residual is still above the target at
+/// the end.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param Type Type of variable
+///\param x Pointer to variable
+///
+///\return Residual
+///////////////////////////////////////////////////////////////////////////////
+REAL PCG_P(PARA_DATA *para, REAL **var, int Type, REAL *x) {
+  REAL *as = var[AS], *aw = var[AW], *ae = var[AE], *an = var[AN];
+  REAL *ap = var[AP], *af = var[AF], *ab = var[AB], *b = var[B];
+  REAL *flagp = var[FLAGP];
+  REAL *r, *z, *p, *q;
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int i, j, k, it, nb_cell = 0;
+  double rz, rz_old, alpha, mean = 0, excess = 0, diag = 0;
+  double norm = 0.0000000001;
+  double tmp1;
+  REAL residual;
+
+  /****************************************************************************
+  | Allocate the work vectors at the first call
+  ****************************************************************************/
+  if(para->solv->pcg==NULL) {
+    if(allocate_pcg_data(para)!=0) {
+      ffd_log("PCG_P(): Could not allocate memory for PCG solver.",
+              FFD_ERROR);
+      return -1;
+    }
+  }
+  r = para->solv->pcg->r;
+  z = para->solv->pcg->z;
+  p = para->solv->pcg->p;
+  q = para->solv->pcg->q;
+
+  // The coefficients are recomputed before each call
+  pcg_factor(para, var);
+
+  /****************************************************************************
+  | Initial residual
+  ****************************************************************************/
+  for(k=1; k<=kmax; k++)
+    for(j=1; j<=jmax; j++)
+      for(i=1; i<=imax; i++) {
+        if(flagp[IX(i,j,k)]>=0) continue;
+
+        r[IX(i,j,k)] = b[IX(i,j,k)]
+                     + ae[IX(i,j,k)]*x[IX(i+1,j,k)] + aw[IX(i,j,k)]*x[IX(i-1,j,k)]
+                     + an[IX(i,j,k)]*x[IX(i,j+1,k)] + as[IX(i,j,k)]*x[IX(i,j-1,k)]
+                     + af[IX(i,j,k)]*x[IX(i,j,k+1)] + ab[IX(i,j,k)]*x[IX(i,j,k-1)]
+                     - ap[IX(i,j,k)]*x[IX(i,j,k)];
+        mean += r[IX(i,j,k)];
+        excess += fabs(ap[IX(i,j,k)] - ae[IX(i,j,k)] - aw[IX(i,j,k)]
+                       - an[IX(i,j,k)] - as[IX(i,j,k)]
+                       - af[IX(i,j,k)] - ab[IX(i,j,k)]);
+        diag += fabs(ap[IX(i,j,k)]);
+        norm += fabs(b[IX(i,j,k)]);
+        nb_cell++;
+      }
+
+  if(nb_cell==0) return 0;
+
+  /****************************************************************************
+  | Remove the part of the source that is not compatible with a pure
+  | Neumann problem
+  ****************************************************************************/
+  tmp1 = 0;
+  mean = excess<=1e-6*diag ? mean/nb_cell : 0;
+  for(k=1; k<=kmax; k++)
+    for(j=1; j<=jmax; j++)
+      for(i=1; i<=imax; i++) {
+        if(flagp[IX(i,j,k)]>=0) continue;
+        r[IX(i,j,k)] -= (REAL) mean;
+        tmp1 += fabs(r[IX(i,j,k)]);
+      }
+  residual = (REAL) (tmp1/norm);
+
+  /****************************************************************************
+  | Conjugate gradient iterations
+  ****************************************************************************/
+  pcg_precondition(para, var, r, z);
+  for(k=1; k<=kmax; k++)
+    for(j=1; j<=jmax; j++)
+      for(i=1; i<=imax; i++)
+        p[IX(i,j,k)] = z[IX(i,j,k)];
+  rz = pcg_dot(para, flagp, r, z);
+
+  for(it=0; it<para->solv->pcg_max_iter && residual>para->solv->p_tol;
+      it++) {
+    pcg_matvec(para, var, p, q);
+    alpha = pcg_dot(para, flagp, p, q);
+    // The matrix is not positive definite in the direction p
+    if(alpha<=0) {
+      sprintf(msg, "PCG_P(): Search direction with p*Ap=%e after %d "
+              "iterations", alpha, it);
+      ffd_log(msg, FFD_WARNING);
+      break;
+    }
+    alpha = rz / alpha;
+
+    tmp1 = 0;
+    for(k=1; k<=kmax; k++)
+      for(j=1; j<=jmax; j++)
+        for(i=1; i<=imax; i++) {
+          if(flagp[IX(i,j,k)]>=0) continue;
+          x[IX(i,j,k)] += (REAL) alpha * p[IX(i,j,k)];
+          r[IX(i,j,k)] -= (REAL) alpha * q[IX(i,j,k)];
+          tmp1 += fabs(r[IX(i,j,k)]);
+        }
+    residual = (REAL) (tmp1/norm);
+
+    pcg_precondition(para, var, r, z);
+    rz_old = rz;
+    rz = pcg_dot(para, flagp, r, z);
+    for(k=1; k<=kmax; k++)
+      for(j=1; j<=jmax; j++)
+        for(i=1; i<=imax; i++)
+          p[IX(i,j,k)] = z[IX(i,j,k)] + (REAL) (rz/rz_old) * p[IX(i,j,k)];
+  }
+
+  sprintf(msg, "PCG_P(): Residual is %e after %d iterations", residual, it);
+  ffd_log(msg, FFD_NORMAL);
+  if(residual>para->solv->p_tol) {
+    sprintf(msg, "PCG_P(): Residual %e is above the target %e after %d "
+            "iterations", residual, para->solv->p_tol, it);
+    ffd_log(msg, FFD_WARNING);
+  }
+
+  return residual;
+} // End of PCG_P()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Allocate memory for the work vectors of the PCG solver
+///
+///\param para Pointer to FFD parameters
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int allocate_pcg_data(PARA_DATA *para) {
+  PCG_DATA *pcg;
+  int size = (para->geom->imax+2) * (para->geom->jmax+2)
+           * (para->geom->kmax+2);
+
+  pcg = (PCG_DATA *) malloc(sizeof(PCG_DATA));
+  if(pcg==NULL) {
+    ffd_log("allocate_pcg_data(): Could not allocate memory for pcg.",
+            FFD_ERROR);
+    return 1;
+  }
+  para->solv->pcg = pcg;
+
+  // The cells which are not solved stay zero
+  pcg->r = (REAL *) calloc(size, sizeof(REAL));
+  pcg->z = (REAL *) calloc(size, sizeof(REAL));
+  pcg->p = (REAL *) calloc(size, sizeof(REAL));
+  pcg->q = (REAL *) calloc(size, sizeof(REAL));
+  pcg->d = (REAL *) calloc(size, sizeof(REAL));
+  if(pcg->r==NULL || pcg->z==NULL || pcg->p==NULL || pcg->q==NULL
+     || pcg->d==NULL) {
+    ffd_log("allocate_pcg_data(): Could not allocate memory for "
+            "work vectors.", FFD_ERROR);
+    return 1;
+  }
+
+  return 0;
+} // End of allocate_pcg_data()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free memory for the work vectors of the PCG solver
+///
+///\param para Pointer to FFD parameters
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_pcg_data(PARA_DATA *para) {
+  PCG_DATA *pcg = para->solv->pcg;
+
+  if(pcg==NULL) return;
+
+  free(pcg->r);
+  free(pcg->z);
+  free(pcg->p);
+  free(pcg->q);
+  free(pcg->d);
+  free(pcg);
+  para->solv->pcg = NULL;
+} // End of free_pcg_data()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Compute the diagonal of the preconditioner
+///
+/// Jacobi and SSOR use AP. The incomplete Cholesky factorization keeps the
+/// sparsity of the matrix, so that only its diagonal has to be stored.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void pcg_factor(PARA_DATA *para, REAL **var) {
+  REAL *aw = var[AW], *ae = var[AE], *as = var[AS], *an = var[AN];
+  REAL *ab = var[AB], *af = var[AF], *ap = var[AP];
+  REAL *flagp = var[FLAGP], *d = para->solv->pcg->d;
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int i, j, k;
+  REAL tmp;
+
+  for(k=1; k<=kmax; k++)
+    for(j=1; j<=jmax; j++)
+      for(i=1; i<=imax; i++) {
+        if(flagp[IX(i,j,k)]>=0) continue;
+
+        if(para->solv->pcg_precond!=IC) {
+          d[IX(i,j,k)] = ap[IX(i,j,k)];
+          continue;
+        }
+
+        // The cells which are not solved have d=0 and are skipped
+        tmp = ap[IX(i,j,k)];
+        if(d[IX(i-1,j,k)]>0)
+          tmp -= aw[IX(i,j,k)]*ae[IX(i-1,j,k)] / d[IX(i-1,j,k)];
+        if(d[IX(i,j-1,k)]>0)
+          tmp -= as[IX(i,j,k)]*an[IX(i,j-1,k)] / d[IX(i,j-1,k)];
+        if(d[IX(i,j,k-1)]>0)
+          tmp -= ab[IX(i,j,k)]*af[IX(i,j,k-1)] / d[IX(i,j,k-1)];
+        // Fall back to AP if the factorization breaks down
+        d[IX(i,j,k)] = tmp>SMALL*ap[IX(i,j,k)] ? tmp : ap[IX(i,j,k)];
+      }
+} // End of pcg_factor()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Apply the preconditioner
+///
+/// Jacobi divides r by AP. SSOR and incomplete Cholesky solve
+/// (D+L) D^-1 (D+U) z = r with a forward and a backward sweep, where D is
+/// the diagonal computed by pcg_factor() and L, U are the neighbor
+/// coefficients of the matrix.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param r Pointer to the residual
+///\param z Pointer to the preconditioned residual
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void pcg_precondition(PARA_DATA *para, REAL **var, REAL *r, REAL *z) {
+  REAL *aw = var[AW], *ae = var[AE], *as = var[AS], *an = var[AN];
+  REAL *ab = var[AB], *af = var[AF];
+  REAL *flagp = var[FLAGP], *d = para->solv->pcg->d;
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int i, j, k;
+
+  if(para->solv->pcg_precond==JACOBI) {
+    for(k=1; k<=kmax; k++)
+      for(j=1; j<=jmax; j++)
+        for(i=1; i<=imax; i++) {
+          if(flagp[IX(i,j,k)]>=0) continue;
+          z[IX(i,j,k)] = r[IX(i,j,k)] / d[IX(i,j,k)];
+        }
+    return;
+  }
+
+  /****************************************************************************
+  | Forward sweep: (D+L) y = r
+  ****************************************************************************/
+  for(k=1; k<=kmax; k++)
+    for(j=1; j<=jmax; j++)
+      for(i=1; i<=imax; i++) {
+        if(flagp[IX(i,j,k)]>=0) continue;
+        z[IX(i,j,k)] = ( r[IX(i,j,k)]
+                       + aw[IX(i,j,k)]*z[IX(i-1,j,k)]
+                       + as[IX(i,j,k)]*z[IX(i,j-1,k)]
+                       + ab[IX(i,j,k)]*z[IX(i,j,k-1)] ) / d[IX(i,j,k)];
+      }
+
+  /****************************************************************************
+  | Backward sweep: (D+U) z = D y
+  ****************************************************************************/
+  for(k=kmax; k>=1; k--)
+    for(j=jmax; j>=1; j--)
+      for(i=imax; i>=1; i--) {
+        if(flagp[IX(i,j,k)]>=0) continue;
+        z[IX(i,j,k)] += ( ae[IX(i,j,k)]*z[IX(i+1,j,k)]
+                        + an[IX(i,j,k)]*z[IX(i,j+1,k)]
+                        + af[IX(i,j,k)]*z[IX(i,j,k+1)] ) / d[IX(i,j,k)];
+      }
+} // End of pcg_precondition()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Multiply the matrix with a vector
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param p Pointer to the vector
+///\param q Pointer to the product
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void pcg_matvec(PARA_DATA *para, REAL **var, REAL *p, REAL *q) {
+  REAL *as = var[AS], *aw = var[AW], *ae = var[AE], *an = var[AN];
+  REAL *ap = var[AP], *af = var[AF], *ab = var[AB];
+  REAL *flagp = var[FLAGP];
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int i, j, k;
+
+  for(k=1; k<=kmax; k++)
+    for(j=1; j<=jmax; j++)
+      for(i=1; i<=imax; i++) {
+        if(flagp[IX(i,j,k)]>=0) continue;
+        q[IX(i,j,k)] = ap[IX(i,j,k)]*p[IX(i,j,k)]
+                     - ae[IX(i,j,k)]*p[IX(i+1,j,k)] - aw[IX(i,j,k)]*p[IX(i-1,j,k)]
+                     - an[IX(i,j,k)]*p[IX(i,j+1,k)] - as[IX(i,j,k)]*p[IX(i,j-1,k)]
+                     - af[IX(i,j,k)]*p[IX(i,j,k+1)] - ab[IX(i,j,k)]*p[IX(i,j,k-1)];
+      }
+} // End of pcg_matvec()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Dot product of two vectors over the cells which are solved
+///
+///\param para Pointer to FFD parameters
+///\param flag Pointer to the cell property flag
+///\param a Pointer to the first vector
+///\param b Pointer to the second vector
+///
+///\return Dot product
+///////////////////////////////////////////////////////////////////////////////
+double pcg_dot(PARA_DATA *para, REAL *flag, REAL *a, REAL *b) {
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  int i, j, k;
+  double sum = 0;
+
+  for(k=1; k<=kmax; k++)
+    for(j=1; j<=jmax; j++)
+      for(i=1; i<=imax; i++) {
+        if(flag[IX(i,j,k)]>=0) continue;
+        sum += (double) a[IX(i,j,k)] * b[IX(i,j,k)];
+      }
+
+  return sum;
+} // End of pcg_dot()
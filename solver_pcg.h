@@ -0,0 +1,125 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// \file   solver_pcg.h
+///
+/// \brief  Preconditioned conjugate gradient solver for the pressure equation
+///
+/// \author agent
+///         agent@local
+///
+/// \date   10/17/2026
+///
+/// This file provides a conjugate gradient solver for the symmetric pressure
+/// equation. It works on the same coefficients (AP, AE, AW, AN, AS, AF, AB
+/// and B) as the Gauss-Seidel solver and only solves the cells with
+/// FLAGP<0. The preconditioner can be Jacobi, symmetric Gauss-Seidel (SSOR
+/// with relaxation factor 1) or incomplete Cholesky without fill-in.
+///
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef _SOLVER_PCG_H
+#define _SOLVER_PCG_H
+#endif
+
+#ifndef _DATA_STRUCTURE_H
+#define _DATA_STRUCTURE_H
+#include "data_structure.h"
+#endif
+
+#ifndef _UTILITY_H
+#define _UTILITY_H
+#include "utility.h"
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+/// Preconditioned conjugate gradient solver for pressure
+///
+/// The iteration stops when the residual, normalized by the source b, is
+/// below para->solv->p_tol or after para->solv->pcg_max_iter iterations.
+/// The pressure of the last time step is the initial guess, so a
+/// normalization by ap*x would stop the iteration too early. If the
+/// coefficients define a pure Neumann problem, the mean value of the initial
+/// residual is removed so that the iteration stays in the range of the
+/// matrix. A warning is logged if the residual is still above the target at
+/// the end.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param Type Type of variable
+///\param x Pointer to variable
+///
+///\return Residual
+///////////////////////////////////////////////////////////////////////////////
+REAL PCG_P(PARA_DATA *para, REAL **var, int Type, REAL *x);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Allocate memory for the work vectors of the PCG solver
+///
+///\param para Pointer to FFD parameters
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int allocate_pcg_data(PARA_DATA *para);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free memory for the work vectors of the PCG solver
+///
+///\param para Pointer to FFD parameters
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_pcg_data(PARA_DATA *para);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Compute the diagonal of the preconditioner
+///
+/// Jacobi and SSOR use AP. The incomplete Cholesky factorization keeps the
+/// sparsity of the matrix, so that only its diagonal has to be stored.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void pcg_factor(PARA_DATA *para, REAL **var);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Apply the preconditioner
+///
+/// Jacobi divides r by AP. SSOR and incomplete Cholesky solve
+/// (D+L) D^-1 (D+U) z = r with a forward and a backward sweep, where D is
+/// the diagonal computed by pcg_factor() and L, U are the neighbor
+/// coefficients of the matrix.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param r Pointer to the residual
+///\param z Pointer to the preconditioned residual
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void pcg_precondition(PARA_DATA *para, REAL **var, REAL *r, REAL *z);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Multiply the matrix with a vector
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param p Pointer to the vector
+///\param q Pointer to the product
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void pcg_matvec(PARA_DATA *para, REAL **var, REAL *p, REAL *q);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Dot product of two vectors over the cells which are solved
+///
+///\param para Pointer to FFD parameters
+///\param flag Pointer to the cell property flag
+///\param a Pointer to the first vector
+///\param b Pointer to the second vector
+///
+///\return Dot product
+///////////////////////////////////////////////////////////////////////////////
+double pcg_dot(PARA_DATA *para, REAL *flag, REAL *a, REAL *b);
@@ -2,7 +2,7 @@
 ///
 /// \file   solver_tdma.c
 ///
-/// \brief Tri-Diagonal Matrix Algorithm Solver 
+/// \brief Tri-Diagonal Matrix Algorithm Solver
 ///
 /// \author Mingang Jin, Qingyan Chen
 ///         Purdue University
@@ -10,350 +10,293 @@
 ///         Wangda Zuo
 ///         University of Miami
 ///         W.Zuo@miami.edu
+///         agent
+///         agent@local
 ///
-/// \date   8/3/2013
+/// \date   8/3/2013, batched solver 10/17/2026
+///
+/// The lines of one plane are solved together as a batch. The coefficients
+/// of a batch are copied into a workspace where the line index is the
+/// innermost one, so that the elimination is vectorized across the lines.
+/// The planes of the same parity do not depend on each other and are solved
+/// by different threads if the code is compiled with OpenMP. The workspaces
+/// are allocated at the first call and again when more threads are used.
 ///
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "solver_tdma.h"
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 ///////////////////////////////////////////////////////////////////////////////
 /// TDMA solver for 3D
 ///
+/// Each pass solves the lines in X, Y and Z direction once. The planes are
+/// visited in red-black order, which is reversed in the second pass.
+///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
-///\param type Type of variable
+///\param flag Pointer to the cell property flag
 ///\param psi Pointer to variable
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int TDMA_3D(PARA_DATA *para, REAL **var, int type, REAL *psi) {
-  int imax = para->geom->imax;
+int TDMA_3D(PARA_DATA *para, REAL **var, REAL *flag, REAL *psi) {
   int jmax = para->geom->jmax;
   int kmax = para->geom->kmax;
-  int i, j, k;
+  int pass, dir, color, plane, nb_plane, thread = 0;
+  REAL **work;
 
-  //West to East
-  for(i=1; i<=imax; i++) {
-    if(TDMA_YZ(para, var, psi, i)) {
-      ffd_log("TDMA_3D: Could not compute TDMA_YZ.", FFD_ERROR);
-      return 1;
-    }     
-  }
-  //South to North
-  for(j=1; j<=jmax; j++) {
-    if(TDMA_ZX(para, var, psi, j)) {
-      ffd_log("TDMA_3D: Could not compute TDMA_ZX.", FFD_ERROR);
-      return 1;
-    } 
-  }
-  //Back to Front
-  for(k=1; k<=kmax; k++) {
-    if(TDMA_XY(para, var, psi, k)) {
-      ffd_log("TDMA_3D: Could not compute TDMA_XY.", FFD_ERROR);
-      return 1;
-    }     
-  }
-  //East to West
-  for(i=imax; i>=1; i--) {
-    if(TDMA_YZ(para, var, psi, i)) {
-      ffd_log("TDMA_3D: Could not compute TDMA_YZ.", FFD_ERROR);
-      return 1;
-    }     
-  }
-  //North to South
-  for(j=jmax; j>=1; j--) {
-    if(TDMA_ZX(para, var, psi, j)) {
-      ffd_log("TDMA_3D: Could not compute TDMA_ZX.", FFD_ERROR);
-      return 1;
-    }     
-  }
-  //Front to Back
-  for(k=kmax; k>=1; k--) {
-    if(TDMA_XY(para, var, psi, k)) {
-      ffd_log("TDMA_3D: Could not compute TDMA_YZ.", FFD_ERROR);
+  /****************************************************************************
+  | Allocate the workspaces at the first call and again if the number of
+  | threads has grown since then
+  ****************************************************************************/
+#ifdef _OPENMP
+  if(para->solv->tdma!=NULL
+     && omp_get_max_threads()>para->solv->tdma->nb_thread)
+    free_tdma_data(para);
+#endif
+  if(para->solv->tdma==NULL) {
+    if(allocate_tdma_data(para)!=0) {
+      ffd_log("TDMA_3D(): Could not allocate memory for TDMA solver.",
+              FFD_ERROR);
       return 1;
-    }          
+    }
   }
+  work = para->solv->tdma->work;
+
+  for(pass=0; pass<2; pass++)
+    for(dir=X; dir<=Z; dir++) {
+      // Lines in Z direction are batched in the XZ-planes, others in XY-planes
+      nb_plane = dir==Z ? jmax : kmax;
+      for(color=0; color<2; color++) {
+#pragma omp parallel for private(thread) schedule(static)
+        for(plane=1+(color+pass)%2; plane<=nb_plane; plane+=2) {
+#ifdef _OPENMP
+          thread = omp_get_thread_num();
+#endif
+          TDMA_plane(para, var, flag, psi, dir, plane, work[thread]);
+        }
+      }
+    }
+
   return 0;
-}// end of TDMA_3D()
+} // End of TDMA_3D()
 
 ///////////////////////////////////////////////////////////////////////////////
-/// TDMA solver for XY-plane 
+/// Allocate the workspaces of the TDMA solver
+///
+/// One workspace is allocated for each thread. It holds the coefficients,
+/// the source and the variable of a batch of lines. If an error occurs,
+/// the memory allocated so far is freed and para->solv->tdma is reset to
+/// NULL.
 ///
 ///\param para Pointer to FFD parameters
-///\param var Pointer to FFD simulation variables
-///\param psi Pointer to variable
-///\param k K-index of the plane
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int TDMA_XY(PARA_DATA *para, REAL **var, REAL *psi, int k) {
-  int imax = para->geom->imax, jmax = para->geom->jmax;
-  int i, j;
-  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
-  REAL *b = var[B], *ap = var[AP], *af = var[AF], *ab = var[AB];
-  REAL *ae = var[AE], *aw =var[AW], *an = var[AN], *as = var[AS];
-  REAL *temp_ap, *temp_aw, *temp_ae, *temp_b, *temp_psi;
-  
-  temp_ap = (REAL *) malloc((jmax+1)*sizeof(REAL));
-  if(temp_ap==NULL) {
-    ffd_log("TDMA_XY(): Could not allocate memory for temp_ap.",
-            FFD_ERROR);
-    return 1;
-  }
-  temp_ae = (REAL *) malloc((jmax+1)*sizeof(REAL));
-  if(temp_ae==NULL) {
-    ffd_log("TDMA_XY(): Could not allocate memory for temp_ae.",
-            FFD_ERROR);
-    return 1;
-  }
-  temp_aw = (REAL *) malloc((jmax+1)*sizeof(REAL));
-  if(temp_aw==NULL) {
-    ffd_log("TDMA_XY(): Could not allocate memory for temp_aw.",
-            FFD_ERROR);
-    return 1;
-  }
-  temp_b = (REAL *) malloc((jmax+1)*sizeof(REAL));
-  if(temp_b==NULL) {
-    ffd_log("TDMA_XY(): Could not allocate memory for temp_b.",
+int allocate_tdma_data(PARA_DATA *para) {
+  TDMA_DATA *tdma;
+  int imax = para->geom->imax;
+  int jmax = para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int t;
+
+  tdma = (TDMA_DATA *) malloc(sizeof(TDMA_DATA));
+  if(tdma==NULL) {
+    ffd_log("allocate_tdma_data(): Could not allocate memory for tdma.",
             FFD_ERROR);
     return 1;
   }
-  temp_psi = (REAL *) malloc((jmax+1)*sizeof(REAL));
-  if(temp_psi==NULL) {
-    ffd_log("TDMA_XY(): Could not allocate memory for temp_psi.",
-            FFD_ERROR);
+
+#ifdef _OPENMP
+  tdma->nb_thread = omp_get_max_threads();
+#else
+  tdma->nb_thread = 1;
+#endif
+  tdma->length = max(max(imax, jmax), kmax);
+
+  tdma->work = (REAL **) calloc(tdma->nb_thread, sizeof(REAL *));
+  if(tdma->work==NULL) {
+    ffd_log("allocate_tdma_data(): Could not allocate memory for "
+            "tdma->work.", FFD_ERROR);
+    free(tdma);
     return 1;
   }
+  para->solv->tdma = tdma;
 
-  //line-by-line from West to East
-  for(i=1; i<=imax; i++) {
-    for(j=1; j<=jmax; j++) {
-      temp_b[j] = b[IX(i,j,k)] 
-                + ae[IX(i,j,k)]*psi[IX(i+1,j,k)] + aw[IX(i,j,k)]*psi[IX(i-1,j,k)]
-                + af[IX(i,j,k)]*psi[IX(i,j,k+1)] + ab[IX(i,j,k)]*psi[IX(i,j,k-1)];
-      temp_ap[j] = ap[IX(i,j,k)];
-      temp_aw[j] = as[IX(i,j,k)];
-      temp_ae[j] = an[IX(i,j,k)];
-      temp_psi[j] = psi[IX(i,j,k)];
-    }
-
-    if(TDMA_1D(temp_ap, temp_ae, temp_aw, temp_b, temp_psi, jmax)) {
-      ffd_log("TDMA_XY(): Could not compute TDMA_1D", FFD_ERROR);
+  for(t=0; t<tdma->nb_thread; t++) {
+    tdma->work[t] = (REAL *) malloc(5 * (tdma->length+2) * tdma->length
+                                    * sizeof(REAL));
+    if(tdma->work[t]==NULL) {
+      sprintf(msg, "allocate_tdma_data(): Could not allocate memory for "
+              "workspace of thread %d.", t);
+      ffd_log(msg, FFD_ERROR);
+      free_tdma_data(para);
       return 1;
-    }   
-    for(j=1; j<=jmax; j++)  
-      psi[IX(i,j,k)] = temp_psi[j];
+    }
   }
-  
-  free(temp_ap);
-  free(temp_ae);
-  free(temp_aw);
-  free(temp_b);
-  free(temp_psi);
+
   return 0;
-} // End of TDMA_XY()
+} // End of allocate_tdma_data()
 
 ///////////////////////////////////////////////////////////////////////////////
-/// TDMA solver for YZ-plane 
+/// Free the workspaces of the TDMA solver
 ///
 ///\param para Pointer to FFD parameters
-///\param var Pointer to FFD simulation variables
-///\param psi Pointer to variable
-///\param i I-index of the plane
 ///
-///\return 0 if no error occurred
+///\return No return needed
 ///////////////////////////////////////////////////////////////////////////////
-int TDMA_YZ(PARA_DATA *para, REAL **var, REAL *psi, int i)
-{
-  int imax = para->geom->imax;
-  int jmax = para->geom->jmax;
-  int kmax = para->geom->kmax;
-  int j, k;
-  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
-  REAL *b = var[B], *ap = var[AP], *af = var[AF], *ab = var[AB];
-  REAL *ae = var[AE], *aw =var[AW], *an = var[AN], *as = var[AS];
-  REAL *temp_ap, *temp_aw, *temp_ae, *temp_b, *temp_psi;
-  
-  temp_ap = (REAL *) malloc((kmax+1)*sizeof(REAL));
-  if(temp_ap==NULL) {
-    ffd_log("TDMA_YZ(): Could not allocate memory for temp_ap.",
-            FFD_ERROR);
-    return 1;
-  }
-  temp_ae = (REAL *) malloc((kmax+1)*sizeof(REAL));
-  if(temp_ae==NULL) {
-    ffd_log("TDMA_YZ(): Could not allocate memory for temp_ae.",
-            FFD_ERROR);
-    return 1;
-  }
-  temp_aw = (REAL *) malloc((kmax+1)*sizeof(REAL));
-  if(temp_aw==NULL) {
-    ffd_log("TDMA_YZ(): Could not allocate memory for temp_aw.",
-            FFD_ERROR);
-    return 1;
-  }
-  temp_b = (REAL *) malloc((kmax+1)*sizeof(REAL));
-  if(temp_b==NULL) {
-    ffd_log("TDMA_YZ(): Could not allocate memory for temp_b.",
-            FFD_ERROR);
-    return 1;
-  }
-  temp_psi = (REAL *) malloc((kmax+1)*sizeof(REAL));
-  if(temp_psi==NULL) {
-    ffd_log("TDMA_YZ(): Could not allocate memory for temp_psi.",
-            FFD_ERROR);
-    return 1;
-  }
-  
-  //line-by-line from South to North
-  for(j=1; j<=jmax; j++) {
-    for(k=1; k<=kmax; k++) {
-      temp_b[k] = b[IX(i,j,k)] 
-                + ae[IX(i,j,k)]*psi[IX(i+1,j,k)] + aw[IX(i,j,k)]*psi[IX(i-1,j,k)]
-                + an[IX(i,j,k)]*psi[IX(i,j+1,k)] + as[IX(i,j,k)]*psi[IX(i,j-1,k)];
-      temp_ap[k] = ap[IX(i,j,k)];
-      temp_aw[k] = ab[IX(i,j,k)];
-      temp_ae[k] = af[IX(i,j,k)];
-      temp_psi[k] = psi[IX(i,j,k)];
-    }
+void free_tdma_data(PARA_DATA *para) {
+  TDMA_DATA *tdma = para->solv->tdma;
+  int t;
 
-    if(TDMA_1D(temp_ap, temp_ae, temp_aw, temp_b, temp_psi, kmax)) {
-      ffd_log("TDMA_YZ(): Could not compute TDMA_1D", FFD_ERROR);
-      return 1;
-    }
-    for(k=1; k<=kmax; k++)  psi[IX(i,j,k)] = temp_psi[k];
+  if(tdma==NULL) return;
 
-  }
-  
-  free(temp_ap);
-  free(temp_ae);
-  free(temp_aw);
-  free(temp_b);
-  free(temp_psi);
-  return 0;
-} // End of TDMA_YZ()
+  for(t=0; t<tdma->nb_thread; t++)
+    free(tdma->work[t]);
+  free(tdma->work);
+  free(tdma);
+  para->solv->tdma = NULL;
+} // End of free_tdma_data()
 
 ///////////////////////////////////////////////////////////////////////////////
-/// TDMA solver for ZX-plane 
+/// TDMA solver for all the lines in one plane
+///
+/// The lines in X and Y direction are taken from the XY-plane k=plane and
+/// the lines in Z direction from the XZ-plane j=plane. The neighbors which
+/// are not on the line are taken from psi before the batch is solved. The
+/// cells with flag>=0 keep their values.
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
+///\param flag Pointer to the cell property flag
 ///\param psi Pointer to variable
-///\param j J-index of the plane
+///\param dir Direction of the lines: X, Y or Z
+///\param plane Index of the plane
+///\param work Pointer to the workspace
 ///
-///\return 0 if no error occurred
+///\return No return needed
 ///////////////////////////////////////////////////////////////////////////////
-int TDMA_ZX(PARA_DATA *para, REAL **var, REAL *psi, int j)
-{
-  int imax = para->geom->imax;
-  int jmax = para->geom->jmax;
+void TDMA_plane(PARA_DATA *para, REAL **var, REAL *flag, REAL *psi,
+                int dir, int plane, REAL *work) {
+  int imax = para->geom->imax, jmax = para->geom->jmax;
   int kmax = para->geom->kmax;
-  int k, i;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
-  REAL *b = var[B], *ap = var[AP], *af = var[AF], *ab = var[AB];
-  REAL *ae = var[AE], *aw =var[AW], *an = var[AN], *as = var[AS];
-  REAL *temp_ap, *temp_aw, *temp_ae, *temp_b, *temp_psi;
+  REAL *b = var[B], *ap = var[AP];
+  REAL *a_p, *a_m, *a1_p, *a1_m, *a2_p, *a2_m;
+  int n, m, p, l, c, w, size;
+  int s_line, s_batch, s1, s2, start;
+  REAL *w_ap, *w_ae, *w_aw, *w_b, *w_psi;
 
-  temp_ap = (REAL *) malloc((imax+1)*sizeof(REAL));
-  if(temp_ap==NULL) {
-    ffd_log("TDMA_ZX(): Could not allocate memory for temp_ap.",
-            FFD_ERROR);
-    return 1;
-  }
-  temp_ae = (REAL *) malloc((imax+1)*sizeof(REAL));
-  if(temp_ae==NULL) {
-    ffd_log("TDMA_ZX(): Could not allocate memory for temp_ae.",
-            FFD_ERROR);
-    return 1;
-  }
-  temp_aw = (REAL *) malloc((imax+1)*sizeof(REAL));
-  if(temp_aw==NULL) {
-    ffd_log("TDMA_ZX(): Could not allocate memory for temp_aw.",
-            FFD_ERROR);
-    return 1;
-  }
-  temp_b = (REAL *) malloc((imax+1)*sizeof(REAL));
-  if(temp_b==NULL) {
-    ffd_log("TDMA_ZX(): Could not allocate memory for temp_b.",
-            FFD_ERROR);
-    return 1;
+  /****************************************************************************
+  | Set the strides of the line, the batch and the other two neighbors
+  ****************************************************************************/
+  switch(dir) {
+    case X:
+      n = imax; m = jmax;
+      s_line = 1; s_batch = IMAX; s1 = IMAX; s2 = IJMAX;
+      a_p = var[AE]; a_m = var[AW];
+      a1_p = var[AN]; a1_m = var[AS]; a2_p = var[AF]; a2_m = var[AB];
+      start = IX(0,1,plane);
+      break;
+    case Y:
+      n = jmax; m = imax;
+      s_line = IMAX; s_batch = 1; s1 = 1; s2 = IJMAX;
+      a_p = var[AN]; a_m = var[AS];
+      a1_p = var[AE]; a1_m = var[AW]; a2_p = var[AF]; a2_m = var[AB];
+      start = IX(1,0,plane);
+      break;
+    default:
+      n = kmax; m = imax;
+      s_line = IJMAX; s_batch = 1; s1 = 1; s2 = IMAX;
+      a_p = var[AF]; a_m = var[AB];
+      a1_p = var[AE]; a1_m = var[AW]; a2_p = var[AN]; a2_m = var[AS];
+      start = IX(1,plane,0);
+      break;
   }
-  temp_psi = (REAL *) malloc((imax+1)*sizeof(REAL));
-  if(temp_psi==NULL) {
-    ffd_log("TDMA_ZX(): Could not allocate memory for temp_psi.",
-            FFD_ERROR);
-    return 1;
-  }
-  
-  //line-by-line from South to North
-  for(k=1; k<=kmax; k++) {
-    for(i=1; i<=imax; i++) {
-      temp_b[i] = b[IX(i,j,k)] 
-               + af[IX(i,j,k)]*psi[IX(i,j,k+1)] + ab[IX(i,j,k)]*psi[IX(i,j,k-1)]
-               + an[IX(i,j,k)]*psi[IX(i,j+1,k)] + as[IX(i,j,k)]*psi[IX(i,j-1,k)];
-      temp_ap[i] = ap[IX(i,j,k)];
-      temp_aw[i] = aw[IX(i,j,k)];
-      temp_ae[i] = ae[IX(i,j,k)];
-      temp_psi[i] = psi[IX(i,j,k)];
-    }
 
-    if(TDMA_1D(temp_ap, temp_ae, temp_aw, temp_b, temp_psi, imax)) {
-      ffd_log("TDMA_ZX(): Could not compute TDMA_1D", FFD_ERROR);
-      return 1;
+  size = (n+2) * m;
+  w_ap = work;
+  w_ae = w_ap + size;
+  w_aw = w_ae + size;
+  w_b = w_aw + size;
+  w_psi = w_b + size;
+
+  /****************************************************************************
+  | Copy the batch into the workspace with the line index innermost
+  ****************************************************************************/
+  for(p=0; p<=n+1; p++)
+    for(l=0; l<m; l++) {
+      c = start + p*s_line + l*s_batch;
+      w = p*m + l;
+      w_psi[w] = psi[c];
+      if(p==0 || p==n+1 || flag[c]>=0) {
+        w_ap[w] = 1;
+        w_ae[w] = 0;
+        w_aw[w] = 0;
+        w_b[w] = psi[c];
+      }
+      else {
+        w_ap[w] = ap[c];
+        w_ae[w] = a_p[c];
+        w_aw[w] = a_m[c];
+        w_b[w] = b[c] + a1_p[c]*psi[c+s1] + a1_m[c]*psi[c-s1]
+                      + a2_p[c]*psi[c+s2] + a2_m[c]*psi[c-s2];
+      }
     }
 
-    for(i=1; i<=imax; i++)  psi[IX(i,j,k)] = temp_psi[i];
-  }
-  
-  free(temp_ap);
-  free(temp_ae);
-  free(temp_aw);
-  free(temp_b);
-  free(temp_psi);
-  return 0;
-} // End of TDMA_ZX()
+  TDMA_batch(w_ap, w_ae, w_aw, w_b, w_psi, n, m);
+
+  /****************************************************************************
+  | Copy the solution back
+  ****************************************************************************/
+  for(p=1; p<=n; p++)
+    for(l=0; l<m; l++)
+      psi[start + p*s_line + l*s_batch] = w_psi[p*m+l];
+
+} // End of TDMA_plane()
 
 ///////////////////////////////////////////////////////////////////////////////
-/// TDMA solver for 1D array 
+/// TDMA solver for a batch of lines
 ///
-///\param ap Pointer to coefficient for center 
+/// The arrays are stored as a[p*m+l] for cell p=0,...,n+1 of line l. The
+/// values of psi at p=0 and p=n+1 are the fixed boundary values. The arrays
+/// ae and b are overwritten by the coefficients of the back substitution.
+///
+///\param ap Pointer to coefficient for center
 ///\param ae Pointer to coefficient for east
 ///\param aw Pointer to coefficient for west
 ///\param b Pointer to b
 ///\param psi Pointer to variable
-///\param LENGTH Length of the array
+///\param n Number of cells in each line
+///\param m Number of lines
 ///
-///\return 0 if no error occurred
+///\return No return needed
 ///////////////////////////////////////////////////////////////////////////////
-int TDMA_1D(REAL *ap, REAL *ae, REAL *aw, REAL *b, REAL *psi, 
-             int LENGTH) {
-  REAL *P, *Q;
-  int i;
+void TDMA_batch(REAL *ap, REAL *ae, REAL *aw, REAL *b, REAL *psi,
+                int n, int m) {
+  int p, l;
+  REAL d;
 
-  P = (REAL *)malloc(LENGTH * sizeof(REAL));
-  if(P==NULL) {
-    ffd_log("TDMA_1D(): Could not allocate memory for P.", FFD_ERROR);
-    return 1;
-  }
-  Q = (REAL *)malloc(LENGTH * sizeof(REAL));
-  if(Q==NULL) {
-    ffd_log("TDMA_1D(): Could not allocate memory for Q.", FFD_ERROR);
-    return 1;
-  }
-  for(i=1; i<=LENGTH-1; i++) {
-    P[i] = ae[i] / (ap[i] - aw[i]*P[i-1]);
-    Q[i] = (b[i] + aw[i]*Q[i-1]) / (ap[i] - aw[i]*P[i-1]);
+  // The west boundary value enters through Q[0]
+  for(l=0; l<m; l++) {
+    ae[l] = 0;
+    b[l] = psi[l];
   }
 
-  for(i=LENGTH-1; i>=1; i--)
-    psi[i] = P[i]*psi[i+1] + Q[i];
-
-  free(P);
-  free(Q);
-  return 0;
-} /* end of TDMA_1D() */
+  // P[p] is stored in ae and Q[p] in b
+  for(p=1; p<=n; p++)
+    for(l=p*m; l<(p+1)*m; l++) {
+      d = ap[l] - aw[l]*ae[l-m];
+      ae[l] = ae[l] / d;
+      b[l] = (b[l] + aw[l]*b[l-m]) / d;
+    }
 
+  for(p=n; p>=1; p--)
+    for(l=p*m; l<(p+1)*m; l++)
+      psi[l] = ae[l]*psi[l+m] + b[l];
 
-  
\ No newline at end of file
+} // End of TDMA_batch()
@@ -32,61 +32,78 @@
 ///////////////////////////////////////////////////////////////////////////////
 /// TDMA solver for 3D
 ///
+/// Each pass solves the lines in X, Y and Z direction once. The planes are
+/// visited in red-black order, which is reversed in the second pass.
+///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
-///\param type Type of variable
+///\param flag Pointer to the cell property flag
 ///\param psi Pointer to variable
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int TDMA_3D(PARA_DATA *para, REAL **var, int type, REAL *psi);
+int TDMA_3D(PARA_DATA *para, REAL **var, REAL *flag, REAL *psi);
 
 ///////////////////////////////////////////////////////////////////////////////
-/// TDMA solver for XY-plane 
+/// Allocate the workspaces of the TDMA solver
+///
+/// One workspace is allocated for each thread. It holds the coefficients,
+/// the source and the variable of a batch of lines. If an error occurs,
+/// the memory allocated so far is freed and para->solv->tdma is reset to
+/// NULL.
 ///
 ///\param para Pointer to FFD parameters
-///\param var Pointer to FFD simulation variables
-///\param psi Pointer to variable
-///\param k K-index of the plane
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-int TDMA_XY(PARA_DATA *para, REAL **var, REAL *psi, int k);
+int allocate_tdma_data(PARA_DATA *para);
 
 ///////////////////////////////////////////////////////////////////////////////
-/// TDMA solver for YZ-plane 
+/// Free the workspaces of the TDMA solver
 ///
 ///\param para Pointer to FFD parameters
-///\param var Pointer to FFD simulation variables
-///\param psi Pointer to variable
-///\param i I-index of the plane
 ///
-///\return 0 if no error occurred
+///\return No return needed
 ///////////////////////////////////////////////////////////////////////////////
-int TDMA_YZ(PARA_DATA *para, REAL **var, REAL *psi, int i);
+void free_tdma_data(PARA_DATA *para);
 
 ///////////////////////////////////////////////////////////////////////////////
-/// TDMA solver for ZX-plane 
+/// TDMA solver for all the lines in one plane
+///
+/// The lines in X and Y direction are taken from the XY-plane k=plane and
+/// the lines in Z direction from the XZ-plane j=plane. The neighbors which
+/// are not on the line are taken from psi before the batch is solved. The
+/// cells with flag>=0 keep their values.
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
+///\param flag Pointer to the cell property flag
 ///\param psi Pointer to variable
-///\param j J-index of the plane
+///\param dir Direction of the lines: X, Y or Z
+///\param plane Index of the plane
+///\param work Pointer to the workspace
 ///
-///\return 0 if no error occurred
+///\return No return needed
 ///////////////////////////////////////////////////////////////////////////////
-int TDMA_ZX(PARA_DATA *para, REAL **var, REAL *psi, int j);
+void TDMA_plane(PARA_DATA *para, REAL **var, REAL *flag, REAL *psi,
+                int dir, int plane, REAL *work);
 
-//////////////////////////////////////////////////////////////////////////////
-/// TDMA solver for 1D array 
+///////////////////////////////////////////////////////////////////////////////
+/// TDMA solver for a batch of lines
+///
+/// The arrays are stored as a[p*m+l] for cell p=0,...,n+1 of line l. The
+/// values of psi at p=0 and p=n+1 are the fixed boundary values. The arrays
+/// ae and b are overwritten by the coefficients of the back substitution.
 ///
-///\param ap Pointer to coefficient for center 
+///\param ap Pointer to coefficient for center
 ///\param ae Pointer to coefficient for east
 ///\param aw Pointer to coefficient for west
 ///\param b Pointer to b
 ///\param psi Pointer to variable
-///\param LENGTH Length of the array
+///\param n Number of cells in each line
+///\param m Number of lines
 ///
-///\return 0 if no error occurred
+///\return No return needed
 ///////////////////////////////////////////////////////////////////////////////
-int TDMA_1D(REAL *a, REAL *b, REAL *c, REAL *d, REAL *psi, int LENGTH);
\ No newline at end of file
+void TDMA_batch(REAL *ap, REAL *ae, REAL *aw, REAL *b, REAL *psi,
+                int n, int m);
@@ -37,4 +37,310 @@ void timing(PARA_DATA *para) {
          para->mytime->t, cputime, para->mytime->t/cputime);
   ffd_log(msg, FFD_NORMAL);
 
-} // End of timing( )
\ No newline at end of file
+} // End of timing( )
+
+///////////////////////////////////////////////////////////////////////////////
+/// Set the adaptive time step size
+///
+/// The CFL number of a fluid cell is computed with the velocities at the 
+/// center of the cell. The diffusion number uses the largest diffusivity, 
+/// which is multiplied by 101 for turbulent flows as in \c coef_diff().
+/// The time step size is limited by the target CFL number, the maximum
+/// diffusion number, the growth DT_GROWTH from the previous step and the
+/// limits dt_min and dt_max. The interval to the next synchronization time
+/// is then divided into equal steps that are not larger than this size, so
+/// that the simulation reaches the synchronization time exactly. If t_next
+/// is not after the current time, the step size is not divided. The step
+/// size is only written in the log if it differs from the last logged one
+/// by more than the fraction DT_LOG_CHANGE.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param t_next Next synchronization time
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int set_time_step(PARA_DATA *para, REAL **var, double t_next) {
+  int i, j, k, nb_step;
+  int imax = para->geom->imax, jmax = para->geom->jmax;
+  int kmax = para->geom->kmax;
+  int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
+  REAL *rlx = para->geom->metric->rlx, *rly = para->geom->metric->rly;
+  REAL *rlz = para->geom->metric->rlz;
+  REAL *u = var[VX], *v = var[VY], *w = var[VZ], *flagp = var[FLAGP];
+  REAL rate = 0, rx = 0, ry = 0, rz = 0, kapa, tmp;
+  TIME_DATA *mytime = para->mytime;
+  double dt, remain;
+
+  /****************************************************************************
+  | Largest ratio of the velocity to the cell length in the fluid cells
+  ****************************************************************************/
+  for(k=1; k<=kmax; k++)
+    for(j=1; j<=jmax; j++)
+      for(i=1; i<=imax; i++) {
+        if(flagp[IX(i,j,k)]>=0) continue;
+        tmp = (REAL) 0.5 * ((REAL) fabs(u[IX(i-1,j,k)]+u[IX(i,j,k)])*rlx[i]
+                          + (REAL) fabs(v[IX(i,j-1,k)]+v[IX(i,j,k)])*rly[j]
+                          + (REAL) fabs(w[IX(i,j,k-1)]+w[IX(i,j,k)])*rlz[k]);
+        if(tmp>rate) rate = tmp;
+      }
+
+  /****************************************************************************
+  | Largest diffusivity and inverse squared cell length
+  ****************************************************************************/
+  kapa = max(max(para->prob->nu, para->prob->alpha), para->prob->diff);
+  if(para->prob->tur_model!=LAM) kapa = (REAL) 101.0 * kapa;
+
+  for(i=1; i<=imax; i++) rx = max(rx, rlx[i]*rlx[i]);
+  for(j=1; j<=jmax; j++) ry = max(ry, rly[j]*rly[j]);
+  for(k=1; k<=kmax; k++) rz = max(rz, rlz[k]*rlz[k]);
+
+  /****************************************************************************
+  | Limit the time step size
+  ****************************************************************************/
+  dt = DT_GROWTH * mytime->dt;
+  if(rate>0 && mytime->cfl/rate<dt) 
+    dt = mytime->cfl / rate;
+  if(kapa>0 && mytime->fourier>0 && mytime->fourier/(kapa*(rx+ry+rz))<dt)
+    dt = mytime->fourier / (kapa*(rx+ry+rz));
+  if(mytime->dt_max>0 && dt>mytime->dt_max) 
+    dt = mytime->dt_max;
+  if(dt<mytime->dt_min) 
+    dt = mytime->dt_min;
+
+  /****************************************************************************
+  | Divide the interval to the synchronization time into equal steps
+  ****************************************************************************/
+  remain = t_next - mytime->t;
+  if(remain>0) {
+    nb_step = (int) ceil(remain/dt - SMALL);
+    if(nb_step<1) nb_step = 1;
+    dt = remain / nb_step;
+  }
+
+  mytime->dt = dt;
+  if(fabs(dt-mytime->dt_log)>DT_LOG_CHANGE*mytime->dt_log) {
+    sprintf(msg, "set_time_step(): dt=%f[s], CFL=%f", dt, dt*rate);
+    ffd_log(msg, FFD_NORMAL);
+    mytime->dt_log = dt;
+  }
+
+  return 0;
+} // End of set_time_step()
+
+// Names of the phases in the report
+static const char *phase_name[NB_PHASE] = {
+  "vel_step", "temp_step", "den_step", "advect", "diffusion", "coef_diff",
+  "equ_solver", "project", "set_bnd", "average", "read_cosim_data",
+  "write_cosim_data"};
+
+///////////////////////////////////////////////////////////////////////////////
+/// Read the monotonic wall clock
+///
+///\return Time in seconds from an arbitrary origin
+///////////////////////////////////////////////////////////////////////////////
+double ffd_clock() {
+#ifdef _MSC_VER
+  LARGE_INTEGER freq, now;
+
+  QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&now);
+  return (double) now.QuadPart / (double) freq.QuadPart;
+#else
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double) ts.tv_sec + 1.0e-9 * (double) ts.tv_nsec;
+#endif
+} // End of ffd_clock()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Allocate the timers of the solver phases
+///
+///\param para Pointer to FFD parameters
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int allocate_profile_data(PARA_DATA *para) {
+  PROFILE_DATA *prof;
+
+  prof = (PROFILE_DATA *) calloc(1, sizeof(PROFILE_DATA));
+  if(prof==NULL) {
+    ffd_log("allocate_profile_data(): Could not allocate memory for the "
+            "timers.", FFD_ERROR);
+    return 1;
+  }
+
+  prof->t_start = ffd_clock();
+  para->solv->profile = prof;
+  return 0;
+} // End of allocate_profile_data()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free the timers of the solver phases
+///
+///\param para Pointer to FFD parameters
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_profile_data(PARA_DATA *para) {
+  free(para->solv->profile);
+  para->solv->profile = NULL;
+} // End of free_profile_data()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Start the timer of a solver phase
+///
+/// Nothing is done if the timers are not allocated or the function is called
+/// in an OpenMP parallel region. If the timer of the phase is already
+/// running, only the outermost call is measured.
+///
+///\param para Pointer to FFD parameters
+///\param phase Phase of the solver
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void start_timer(PARA_DATA *para, FFD_PHASE phase) {
+  PROFILE_DATA *prof = para->solv->profile;
+
+  if(prof==NULL) return;
+#ifdef _OPENMP
+  if(omp_in_parallel()) return;
+#endif
+
+  if(prof->depth[phase]++==0)
+    prof->start[phase] = ffd_clock();
+} // End of start_timer()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Stop the timer of a solver phase and add the call to its histogram
+///
+///\param para Pointer to FFD parameters
+///\param phase Phase of the solver
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void stop_timer(PARA_DATA *para, FFD_PHASE phase) {
+  PROFILE_DATA *prof = para->solv->profile;
+  double dt;
+  int bin;
+
+  if(prof==NULL) return;
+#ifdef _OPENMP
+  if(omp_in_parallel()) return;
+#endif
+
+  if(--prof->depth[phase]>0) return;
+
+  dt = ffd_clock() - prof->start[phase];
+  if(prof->count[phase]==0 || dt<prof->min[phase]) prof->min[phase] = dt;
+  if(dt>prof->max[phase]) prof->max[phase] = dt;
+  prof->count[phase]++;
+  prof->total[phase] += dt;
+
+  // The duration in microseconds is in [2^(bin-1), 2^bin)
+  frexp(dt*1.0e6, &bin);
+  bin = bin - 1;
+  if(bin<0) bin = 0;
+  if(bin>PROFILE_BIN-1) bin = PROFILE_BIN - 1;
+  prof->hist[phase][bin]++;
+} // End of stop_timer()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Percentile of the call durations of a phase from its histogram
+///
+///\param prof Pointer to the timers
+///\param phase Phase of the solver
+///\param p Fraction of the calls
+///
+///\return Upper bound of the bin containing the percentile in seconds
+///////////////////////////////////////////////////////////////////////////////
+static double percentile(PROFILE_DATA *prof, FFD_PHASE phase, double p) {
+  long sum = 0, target = (long) ceil(p * prof->count[phase]);
+  int b;
+
+  for(b=0; b<PROFILE_BIN-1; b++) {
+    sum += prof->hist[phase][b];
+    if(sum>=target) break;
+  }
+
+  return min(1.0e-6*ldexp(1.0, b+1), prof->max[phase]);
+} // End of percentile()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Write the summary of the timers into the log file and the timers into a
+/// JSON file
+///
+/// The times of nested phases are also counted in the enclosing phases, for
+/// example advect in vel_step. The percentiles are the upper bounds of the
+/// histogram bins.
+///
+///\param para Pointer to FFD parameters
+///\param name Name of the JSON file without extension
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int write_profile(PARA_DATA *para, char *name) {
+  PROFILE_DATA *prof = para->solv->profile;
+  double wall = ffd_clock() - prof->t_start, mean;
+  char filename[400];
+  FILE *file;
+  int p, b;
+
+  /****************************************************************************
+  | Summary table in the log file
+  ****************************************************************************/
+  sprintf(msg, "write_profile(): %ld time steps in %.3f s wall clock time. "
+          "Nested phases are included in the enclosing ones.",
+          prof->count[PHASE_VEL], wall);
+  ffd_log(msg, FFD_NORMAL);
+  sprintf(msg, "%-18s%10s%11s%9s%11s%11s%11s%11s%11s", "phase", "calls",
+          "total[s]", "share[%]", "mean[ms]", "min[ms]", "max[ms]", "p50[ms]",
+          "p99[ms]");
+  ffd_log(msg, FFD_NORMAL);
+
+  for(p=0; p<NB_PHASE; p++) {
+    if(prof->count[p]==0) continue;
+    mean = prof->total[p] / prof->count[p];
+    sprintf(msg, "%-18s%10ld%11.4f%9.2f%11.4f%11.4f%11.4f%11.4f%11.4f",
+            phase_name[p], prof->count[p], prof->total[p],
+            wall>0 ? 100.0*prof->total[p]/wall : 0.0, 1.0e3*mean,
+            1.0e3*prof->min[p], 1.0e3*prof->max[p],
+            1.0e3*percentile(prof, (FFD_PHASE) p, 0.5),
+            1.0e3*percentile(prof, (FFD_PHASE) p, 0.99));
+    ffd_log(msg, FFD_NORMAL);
+  }
+
+  /****************************************************************************
+  | All the timers in the JSON file
+  ****************************************************************************/
+  sprintf(filename, "%s.json", name);
+  if((file=fopen(filename, "w"))==NULL) {
+    sprintf(msg, "write_profile(): Could not open the file %s.", filename);
+    ffd_log(msg, FFD_ERROR);
+    return 1;
+  }
+
+  fprintf(file, "{\n");
+  fprintf(file, "  \"wall_time\": %.9e,\n", wall);
+  fprintf(file, "  \"steps\": %ld,\n", prof->count[PHASE_VEL]);
+  fprintf(file, "  \"histogram\": \"bin b counts the calls taking "
+          "[2^b, 2^(b+1)) microseconds, bin 0 also the shorter ones\",\n");
+  fprintf(file, "  \"phases\": {\n");
+  for(p=0; p<NB_PHASE; p++) {
+    fprintf(file, "    \"%s\": {\"calls\": %ld, \"total\": %.9e, "
+            "\"min\": %.9e, \"max\": %.9e,\n", phase_name[p], prof->count[p],
+            prof->total[p], prof->min[p], prof->max[p]);
+    fprintf(file, "      \"histogram\": [");
+    for(b=0; b<PROFILE_BIN; b++)
+      fprintf(file, "%ld%s", prof->hist[p][b], b<PROFILE_BIN-1 ? ", " : "");
+    fprintf(file, "]}%s\n", p<NB_PHASE-1 ? "," : "");
+  }
+  fprintf(file, "  }\n}\n");
+  fclose(file);
+
+  sprintf(msg, "write_profile(): Wrote the timers into %s.", filename);
+  ffd_log(msg, FFD_NORMAL);
+
+  return 0;
+} // End of write_profile()
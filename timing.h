@@ -18,6 +18,10 @@
 #define _TIMING_H
 #endif
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 #ifndef _DATA_STRUCTURE_H
 #define _DATA_STRUCTURE_H
 #include "data_structure.h"
@@ -28,6 +32,9 @@
 #include "utility.h"
 #endif
 
+#define DT_GROWTH 1.2 // Maximum growth of the adaptive time step in one step
+#define DT_LOG_CHANGE 0.1 // Relative change of the time step size to be logged
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Calculate the simulation time and time ratio
 ///
@@ -35,4 +42,88 @@
 ///
 ///\return No return needed
 ///////////////////////////////////////////////////////////////////////////////
-void timing(PARA_DATA *para);
\ No newline at end of file
+void timing(PARA_DATA *para);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Set the adaptive time step size
+///
+/// The time step size is limited by the target CFL number, the maximum
+/// diffusion number, the growth DT_GROWTH from the previous step and the
+/// limits dt_min and dt_max. The interval to the next synchronization time
+/// is then divided into equal steps that are not larger than this size, so
+/// that the simulation reaches the synchronization time exactly. If t_next
+/// is not after the current time, the step size is not divided. The step
+/// size is only written in the log if it differs from the last logged one
+/// by more than the fraction DT_LOG_CHANGE.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///\param t_next Next synchronization time
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int set_time_step(PARA_DATA *para, REAL **var, double t_next);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Read the monotonic wall clock
+///
+///\return Time in seconds from an arbitrary origin
+///////////////////////////////////////////////////////////////////////////////
+double ffd_clock();
+
+///////////////////////////////////////////////////////////////////////////////
+/// Allocate the timers of the solver phases
+///
+///\param para Pointer to FFD parameters
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int allocate_profile_data(PARA_DATA *para);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free the timers of the solver phases
+///
+///\param para Pointer to FFD parameters
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_profile_data(PARA_DATA *para);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Start the timer of a solver phase
+///
+/// Nothing is done if the timers are not allocated or the function is called
+/// in an OpenMP parallel region. If the timer of the phase is already
+/// running, only the outermost call is measured.
+///
+///\param para Pointer to FFD parameters
+///\param phase Phase of the solver
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void start_timer(PARA_DATA *para, FFD_PHASE phase);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Stop the timer of a solver phase and add the call to its histogram
+///
+///\param para Pointer to FFD parameters
+///\param phase Phase of the solver
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void stop_timer(PARA_DATA *para, FFD_PHASE phase);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Write the summary of the timers into the log file and the timers into a
+/// JSON file
+///
+/// The times of nested phases are also counted in the enclosing phases, for
+/// example advect in vel_step. The percentiles are the upper bounds of the
+/// histogram bins.
+///
+///\param para Pointer to FFD parameters
+///\param name Name of the JSON file without extension
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int write_profile(PARA_DATA *para, char *name);
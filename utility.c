@@ -17,6 +17,13 @@
 
 #include "utility.h"
 
+#ifndef _MSC_VER
+#include <sys/mman.h>
+#endif
+
+// Message buffer of each thread
+FFD_THREAD_LOCAL char msg[1000];
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Check the residual of equation
 ///
@@ -48,40 +55,6 @@ REAL check_residual(PARA_DATA *para, REAL **var, REAL *x) {
 
 }// End of check_residual( )
 
-///////////////////////////////////////////////////////////////////////////////
-/// Write the log file
-///
-///\param message Pointer the message
-///\param msg_type Type ogf message
-///
-///\return 0 if no error occurred
-///////////////////////////////////////////////////////////////////////////////
-void ffd_log(char *message, FFD_MSG_TYPE msg_type) {
-  if(msg_type==FFD_NEW) {
-    if((file_log=fopen("log.ffd","w"))==NULL) {
-        fprintf(stderr, "Error:can not open error file!\n");
-        exit(1);
-    }
-  }
-  else if((file_log=fopen("log.ffd","a+"))==NULL) {
-    fprintf(stderr,"Error:can not open error file!\n");
-    exit(1);
-  }
-
-  switch(msg_type) {
-    case FFD_WARNING:
-      fprintf(file_log, "WARNING in %s\n", message);
-      break;
-    case FFD_ERROR:
-      fprintf(file_log, "ERROR in %s\n", message);
-      break;
-    // Normal log
-    default:
-      fprintf(file_log, "%s\n", message);
-  }
-  fclose(file_log);
-} // End of ffd_log()
-
 ///////////////////////////////////////////////////////////////////////////////
 /// Check the outflow rate of the scalar psi
 ///
@@ -285,11 +258,12 @@ REAL average_volume(PARA_DATA *para, REAL **var, REAL *psi) {
   int i, j, k;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
   REAL tmp1 = 0, tmp2 = 0, tmp3 = 0;
+  REAL *axy = para->geom->metric->axy, *lz = para->geom->metric->lz;
 
 
   FOR_EACH_CELL
     if(var[FLAGP][IX(i,j,k)]==FLUID) {
-      tmp1 = vol(para, var, i, j, k);
+      tmp1 = axy[i+IMAX*j] * lz[k];
       tmp2 += psi[IX(i,j,k)]*tmp1;
       tmp3 += tmp1;
     }
@@ -306,6 +280,8 @@ REAL average_volume(PARA_DATA *para, REAL **var, REAL *psi) {
 ///////////////////////////////////////////////////////////////////////////////
 /// Calcuate time averaged value
 ///
+/// The sums are divided by the sum of the weights, which is the number of
+/// steps for a fixed time step size and the time interval otherwise.
 ///
 ///\param para Pointer to FFD parameters
 ///\param var Pointer to FFD simulation variables
@@ -318,7 +294,7 @@ int average_time(PARA_DATA *para, REAL **var) {
   int imax = para->geom->imax, jmax = para->geom->jmax;
   int kmax = para->geom->kmax;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
-  int step = para->mytime->step_mean;
+  REAL step = (REAL) para->mytime->w_mean;
 
   FOR_ALL_CELL
     var[VXM][IX(i,j,k)] = var[VXM][IX(i,j,k)] / step;
@@ -395,6 +371,7 @@ int reset_time_averaged_data (PARA_DATA *para, REAL **var) {
 
   //Reset the time step to 0
   para->mytime->step_mean = 0;
+  para->mytime->w_mean = 0;
   return 0;
 } // End of reset_time_averaged_data()
 
@@ -413,42 +390,200 @@ int add_time_averaged_data(PARA_DATA *para, REAL **var) {
   int kmax = para->geom->kmax;
   int IMAX = imax+2, IJMAX = (imax+2)*(jmax+2);
   int size = (imax+2) * (jmax+2) * (kmax+2);
+  REAL w = para->mytime->adaptive==1 ? (REAL) para->mytime->dt : 1;
 
   // All the cells
   for(i=0; i<size; i++) {
-    var[VXM][i] += var[VX][i];
-    var[VYM][i] += var[VY][i];
-    var[VZM][i] += var[VZ][i];
-    var[TEMPM][i] += var[TEMP][i];
+    var[VXM][i] += w*var[VX][i];
+    var[VYM][i] += w*var[VY][i];
+    var[VZM][i] += w*var[VZ][i];
+    var[TEMPM][i] += w*var[TEMP][i];
   }
 
   // Wall surfaces
   for(i=0; i<para->bc->nb_wall; i++) 
-    para->bc->temHeaMean[i] += para->bc->temHeaAve[i];
+    para->bc->temHeaMean[i] += w*para->bc->temHeaAve[i];
 
   // Fluid ports
   for(i=0; i<para->bc->nb_port; i++) {
-    para->bc->TPortMean[i] += para->bc->TPortAve[i];
-    para->bc->velPortMean[i] += para->bc->velPortAve[i];
+    para->bc->TPortMean[i] += w*para->bc->TPortAve[i];
+    para->bc->velPortMean[i] += w*para->bc->velPortAve[i];
     
     for(j=0; j<para->bc->nb_Xi; j++) 
-      para->bc->XiPortMean[i][j] += para->bc->XiPortAve[i][j];
+      para->bc->XiPortMean[i][j] += w*para->bc->XiPortAve[i][j];
     for(j=0; j<para->bc->nb_C; j++) 
-      para->bc->CPortMean[i][j] += para->bc->CPortAve[i][j];
+      para->bc->CPortMean[i][j] += w*para->bc->CPortAve[i][j];
     
   }
 
   // Sensor data
-  para->sens->TRooMean += para->sens->TRoo;
+  para->sens->TRooMean += w*para->sens->TRoo;
   for(j=0; j<para->sens->nb_sensor; j++) 
-    para->sens->senValMean[j] += para->sens->senVal[j];
+    para->sens->senValMean[j] += w*para->sens->senVal[j];
 
   // Update the step
   para->mytime->step_mean++;
+  para->mytime->w_mean += w;
 
   return 0;
 } // End of add_time_averaged_data()
 
+///////////////////////////////////////////////////////////////////////////////
+/// Monitor the convergence to the steady state
+///
+/// The relative change of the velocities between two steps, the kinetic
+/// energy and the volume averaged temperature TRoo are averaged over windows
+/// of steady_window steps. The velocities are compared on the faces with
+/// FLAGU, FLAGV or FLAGW<0. Since the velocities of FFD keep changing by a
+/// small amount from step to step, the flow has settled once the means of
+/// the kinetic energy and of TRoo change by less than steady_tol from one
+/// window to the next and the mean velocity change is either below
+/// steady_tol, or below steady_du_max and has stagnated, i.e. it differs by
+/// less than steady_tol times its value from the one of the last window.
+/// The first call only stores the velocities as the reference of the next
+/// step.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int monitor_steady(PARA_DATA *para, REAL **var) {
+  int i, c;
+  int size = (para->geom->imax+2)*(para->geom->jmax+2)*(para->geom->kmax+2);
+  REAL *vel0, *psi, *flag;
+  REAL du_mean, ke_mean, troo_mean, change;
+  double du = 0, sum = 0, ke = 0;
+  STEADY_DATA *monitor;
+
+  // The velocities of the first call are the reference of the next step
+  if(para->solv->monitor==NULL) {
+    if(allocate_steady_data(para, var)!=0) {
+      ffd_log("monitor_steady(): Could not allocate memory for the monitor.",
+              FFD_ERROR);
+      return 1;
+    }
+    return 0;
+  }
+  monitor = para->solv->monitor;
+
+  /****************************************************************************
+  | Change of the velocities and the kinetic energy of this step
+  ****************************************************************************/
+  for(c=0; c<3; c++) {
+    psi = var[VX+c];
+    flag = var[FLAGU+c];
+    vel0 = monitor->vel0 + c*size;
+    for(i=0; i<size; i++) {
+      if(flag[i]>=0) continue;
+      du += fabs(psi[i]-vel0[i]);
+      sum += fabs(psi[i]);
+      ke += (double) psi[i]*psi[i];
+      vel0[i] = psi[i];
+    }
+  }
+
+  monitor->du += (REAL) (du / max(sum, SMALL));
+  monitor->ke += (REAL) (0.5 * ke);
+  monitor->troo += average_volume(para, var, var[TEMP]);
+  monitor->nb_step++;
+
+  if(monitor->nb_step<para->solv->steady_window) return 0;
+
+  /****************************************************************************
+  | Compare the means of this window with the ones of the last window
+  ****************************************************************************/
+  du_mean = monitor->du / monitor->nb_step;
+  ke_mean = monitor->ke / monitor->nb_step;
+  troo_mean = monitor->troo / monitor->nb_step;
+
+  if(monitor->nb_window>0) {
+    change = (REAL) fabs(ke_mean-monitor->ke_mean) / max(ke_mean, (REAL) SMALL);
+    change = max(change, (REAL) fabs(troo_mean-monitor->troo_mean)
+                         / max((REAL) fabs(troo_mean), 1));
+    monitor->change = change;
+    monitor->settled = change<para->solv->steady_tol
+                    && (du_mean<para->solv->steady_tol
+                        || (du_mean<para->solv->steady_du_max
+                            && (REAL) fabs(du_mean-monitor->du_mean)
+                               < para->solv->steady_tol*monitor->du_mean));
+  }
+
+  monitor->du_mean = du_mean;
+  monitor->ke_mean = ke_mean;
+  monitor->troo_mean = troo_mean;
+  monitor->du = 0;
+  monitor->ke = 0;
+  monitor->troo = 0;
+  monitor->nb_step = 0;
+  monitor->nb_window++;
+
+  return 0;
+} // End of monitor_steady()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Allocate memory for the monitor of the steady state
+///
+/// The velocities of the previous step are initialized with the current
+/// velocities, so that the first change is not measured against zero.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int allocate_steady_data(PARA_DATA *para, REAL **var) {
+  STEADY_DATA *monitor;
+  int size = (para->geom->imax+2)*(para->geom->jmax+2)*(para->geom->kmax+2);
+  int c;
+
+  monitor = (STEADY_DATA *) malloc(sizeof(STEADY_DATA));
+  if(monitor==NULL) {
+    ffd_log("allocate_steady_data(): Could not allocate memory for monitor.",
+            FFD_ERROR);
+    return 1;
+  }
+
+  monitor->vel0 = (REAL *) malloc(3*size*sizeof(REAL));
+  if(monitor->vel0==NULL) {
+    ffd_log("allocate_steady_data(): Could not allocate memory for "
+            "monitor->vel0.", FFD_ERROR);
+    free(monitor);
+    return 1;
+  }
+  for(c=0; c<3; c++)
+    memcpy(monitor->vel0+c*size, var[VX+c], size*sizeof(REAL));
+
+  monitor->nb_step = 0;
+  monitor->nb_window = 0;
+  monitor->du = 0;
+  monitor->ke = 0;
+  monitor->troo = 0;
+  monitor->du_mean = 0;
+  monitor->ke_mean = 0;
+  monitor->troo_mean = 0;
+  monitor->change = 1;
+  monitor->settled = 0;
+  para->solv->monitor = monitor;
+
+  return 0;
+} // End of allocate_steady_data()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free memory for the monitor of the steady state
+///
+///\param para Pointer to FFD parameters
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_steady_data(PARA_DATA *para) {
+  if(para->solv->monitor==NULL) return;
+
+  free(para->solv->monitor->vel0);
+  free(para->solv->monitor);
+  para->solv->monitor = NULL;
+} // End of free_steady_data()
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Check the energy transfer rate through the wall to the air
 ///
@@ -557,69 +692,116 @@ REAL qwall(PARA_DATA *para, REAL **var,int **BINDEX) {
 ///////////////////////////////////////////////////////////////////////////////
 /// Free memory for BINDEX
 ///
+/// The columns of BINDEX are stored in the memory arena of the variables
+/// and are released by free_data().
+///
 ///\param BINDEX Pointer to the boudnary index
 ///
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
 void free_index(int **BINDEX) { 
-  if(BINDEX[0]) free(BINDEX[0]);
-  if(BINDEX[1]) free(BINDEX[1]);
-  if(BINDEX[2]) free(BINDEX[2]);
+  if(BINDEX) free(BINDEX);
 } // End of free_index ()
 
 ///////////////////////////////////////////////////////////////////////////////
 /// Free memory for FFD simulation variables
 ///
+/// All the variables and the columns of BINDEX are stored in one memory
+/// arena, which starts at var[0].
+///
 ///\param var Pointer to FFD simulation variables
 ///
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
 void free_data(REAL **var) {
-  if(var[X]) free(var[X]);
-  if(var[Y]) free(var[Y]);
-  if(var[Z]) free(var[Z]);
-  if(var[VX]) free(var[VX]);
-  if(var[VY]) free(var[VY]);
-  if(var[VZ]) free(var[VZ]);
-  if(var[VXS]) free(var[VXS]);
-  if(var[VYS]) free(var[VYS]);
-  if(var[VZS]) free(var[VZS]);
-  if(var[VXM]) free(var[VXM]);
-  if(var[VYM]) free(var[VYM]);
-  if(var[VZM]) free(var[VZM]);
-  if(var[TEMP]) free(var[TEMP]);
-  if(var[TEMPM]) free(var[TEMPM]);
-  if(var[TEMPS]) free(var[TEMPS]);
-  if(var[IP]) free(var[IP]);
-  if(var[TMP1]) free(var[TMP1]);
-  if(var[TMP2]) free(var[TMP2]);
-  if(var[TMP3]) free(var[TMP3]);
-  if(var[AP]) free(var[AP]);
-  if(var[AN]) free(var[AN]);
-  if(var[AS]) free(var[AS]);
-  if(var[AE]) free(var[AE]);
-  if(var[AW]) free(var[AW]);
-  if(var[AF]) free(var[AF]);
-  if(var[AB]) free(var[AB]);
-  if(var[B])  free(var[B]);
-  if(var[GX])  free(var[GX]);
-  if(var[GY])  free(var[GY]);
-  if(var[GZ])  free(var[GZ]);
-  if(var[AP0])  free(var[AP0]);
-  if(var[PP])  free(var[PP]);
-  if(var[FLAGP])  free(var[FLAGP]);
-  if(var[FLAGU])  free(var[FLAGU]);
-  if(var[FLAGV])  free(var[FLAGV]);
-  if(var[FLAGW])  free(var[FLAGW]);
-  if(var[LOCMIN])  free(var[LOCMIN]);
-  if(var[LOCMAX])  free(var[LOCMAX]);
-  if(var[VXBC])  free(var[VXBC]);
-  if(var[VYBC])  free(var[VYBC]);
-  if(var[VZBC])  free(var[VZBC]);
-  if(var[TEMPBC])  free(var[TEMPBC]);
-  if(var[QFLUXBC])  free(var[QFLUXBC]);
-  if(var[QFLUX])  free(var[QFLUX]);
-
+  if(var==NULL) return;
+  if(var[0]) ffd_aligned_free(var[0]);
+  free(var);
 } // End of free_data()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Allocate aligned memory
+///
+/// The memory is aligned to FFD_ALIGN bytes. On Linux, blocks of at least
+/// FFD_HUGE_PAGE bytes are aligned to the huge page size and the kernel is
+/// advised to back them with transparent huge pages.
+///
+///\param size Size of the memory in bytes
+///
+///\return Pointer to the memory, NULL if the memory could not be allocated
+///////////////////////////////////////////////////////////////////////////////
+void *ffd_aligned_malloc(size_t size) {
+  void *ptr = NULL;
+
+#ifdef _MSC_VER
+  ptr = _aligned_malloc(size, FFD_ALIGN);
+#else
+  if(size>=FFD_HUGE_PAGE) {
+    if(posix_memalign(&ptr, FFD_HUGE_PAGE, size)!=0) return NULL;
+#ifdef MADV_HUGEPAGE
+    madvise(ptr, size, MADV_HUGEPAGE);
+#endif
+  }
+  else if(posix_memalign(&ptr, FFD_ALIGN, size)!=0) return NULL;
+#endif
+
+  return ptr;
+} // End of ffd_aligned_malloc()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free memory allocated by ffd_aligned_malloc()
+///
+///\param ptr Pointer to the memory
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void ffd_aligned_free(void *ptr) {
+#ifdef _MSC_VER
+  _aligned_free(ptr);
+#else
+  free(ptr);
+#endif
+} // End of ffd_aligned_free()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Name of an output file of the FFD instance
+///
+/// The files of the first instance keep the base name. The ones of the
+/// other instances get the suffix _ID, so that the instances running at
+/// the same time do not write into the same files.
+///
+///\param para Pointer to FFD parameters
+///\param base Base name of the file without extension
+///\param name Pointer to the name, at least strlen(base)+12 characters
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void output_name(PARA_DATA *para, char *base, char *name) {
+  if(para->outp->id>1)
+    sprintf(name, "%s_%d", base, para->outp->id);
+  else
+    strcpy(name, base);
+} // End of output_name()
+
+///////////////////////////////////////////////////////////////////////////////
+/// Write the messages of the calling thread into the log of the instance
+///
+/// The log file and the log level are kept per thread. Every thread which
+/// logs for an instance calls this first, otherwise its messages go into
+/// log.ffd at the level 3.
+///
+///\param para Pointer to FFD parameters
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int open_instance_log(PARA_DATA *para) {
+  char name[40];
+
+  output_name(para, "log", name);
+  strcat(name, ".ffd");
+  ffd_log_set_level(para->outp->log_level);
+
+  return ffd_log_open(name);
+} // End of open_instance_log()
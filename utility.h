@@ -29,8 +29,10 @@
 #include "geometry.h"
 #endif
 
-
-FILE *file_log;
+#ifndef _LOGGER_H
+#define _LOGGER_H
+#include "logger.h"
+#endif
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -44,16 +46,6 @@ FILE *file_log;
 ///////////////////////////////////////////////////////////////////////////////
 REAL check_residual(PARA_DATA *para, REAL **var, REAL *x);
 
-///////////////////////////////////////////////////////////////////////////////
-/// Write the log file
-///
-///\param message Pointer the message
-///\param msg_type Type ogf message
-///
-///\return 0 if no error occurred
-///////////////////////////////////////////////////////////////////////////////
-void ffd_log(char *message, FFD_MSG_TYPE msg_type);
-
 ///////////////////////////////////////////////////////////////////////////////
 /// Check the outflow rate of the scalar psi
 ///
@@ -163,6 +155,50 @@ int reset_time_averaged_data (PARA_DATA *para, REAL **var);
 ///////////////////////////////////////////////////////////////////////////////
 int add_time_averaged_data (PARA_DATA *para, REAL **var);
 
+///////////////////////////////////////////////////////////////////////////////
+/// Monitor the convergence to the steady state
+///
+/// The relative change of the velocities between two steps, the kinetic
+/// energy and the volume averaged temperature TRoo are averaged over windows
+/// of steady_window steps. The velocities are compared on the faces with
+/// FLAGU, FLAGV or FLAGW<0. Since the velocities of FFD keep changing by a
+/// small amount from step to step, the flow has settled once the means of
+/// the kinetic energy and of TRoo change by less than steady_tol from one
+/// window to the next and the mean velocity change is either below
+/// steady_tol, or below steady_du_max and has stagnated, i.e. it differs by
+/// less than steady_tol times its value from the one of the last window.
+/// The first call only stores the velocities as the reference of the next
+/// step.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int monitor_steady(PARA_DATA *para, REAL **var);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Allocate memory for the monitor of the steady state
+///
+/// The velocities of the previous step are initialized with the current
+/// velocities, so that the first change is not measured against zero.
+///
+///\param para Pointer to FFD parameters
+///\param var Pointer to FFD simulation variables
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int allocate_steady_data(PARA_DATA *para, REAL **var);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free memory for the monitor of the steady state
+///
+///\param para Pointer to FFD parameters
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void free_steady_data(PARA_DATA *para);
+
 ///////////////////////////////////////////////////////////////////////////////
 /// Check the energy transfer rate through the wall to the air
 ///
@@ -178,6 +214,9 @@ REAL qwall(PARA_DATA *para, REAL **var,int **BINDEX);
 ///////////////////////////////////////////////////////////////////////////////
 /// Free memory for BINDEX
 ///
+/// The columns of BINDEX are stored in the memory arena of the variables
+/// and are released by free_data().
+///
 ///\param BINDEX Pointer to the boudnary index
 ///
 ///
@@ -188,9 +227,62 @@ void free_index(int **BINDEX);
 ///////////////////////////////////////////////////////////////////////////////
 /// Free memory for FFD simulation variables
 ///
+/// All the variables and the columns of BINDEX are stored in one memory
+/// arena, which starts at var[0].
+///
 ///\param var Pointer to FFD simulation variables
 ///
 ///
 ///\return 0 if no error occurred
 ///////////////////////////////////////////////////////////////////////////////
-void free_data(REAL **var); 
\ No newline at end of file
+void free_data(REAL **var);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Allocate aligned memory
+///
+/// The memory is aligned to FFD_ALIGN bytes. On Linux, blocks of at least
+/// FFD_HUGE_PAGE bytes are aligned to the huge page size and the kernel is
+/// advised to back them with transparent huge pages.
+///
+///\param size Size of the memory in bytes
+///
+///\return Pointer to the memory, NULL if the memory could not be allocated
+///////////////////////////////////////////////////////////////////////////////
+void *ffd_aligned_malloc(size_t size);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Free memory allocated by ffd_aligned_malloc()
+///
+///\param ptr Pointer to the memory
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void ffd_aligned_free(void *ptr);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Name of an output file of the FFD instance
+///
+/// The files of the first instance keep the base name. The ones of the
+/// other instances get the suffix _ID, so that the instances running at
+/// the same time do not write into the same files.
+///
+///\param para Pointer to FFD parameters
+///\param base Base name of the file without extension
+///\param name Pointer to the name, at least strlen(base)+12 characters
+///
+///\return No return needed
+///////////////////////////////////////////////////////////////////////////////
+void output_name(PARA_DATA *para, char *base, char *name);
+
+///////////////////////////////////////////////////////////////////////////////
+/// Write the messages of the calling thread into the log of the instance
+///
+/// The log file and the log level are kept per thread. Every thread which
+/// logs for an instance calls this first, otherwise its messages go into
+/// log.ffd at the level 3.
+///
+///\param para Pointer to FFD parameters
+///
+///\return 0 if no error occurred
+///////////////////////////////////////////////////////////////////////////////
+int open_instance_log(PARA_DATA *para);
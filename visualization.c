@@ -117,6 +117,7 @@ void ffd_idle_func(PARA_DATA *para, REAL **var, int **BINDEX) {
 ///////////////////////////////////////////////////////////////////////////////
 void ffd_key_func(PARA_DATA *para, REAL **var, int **BINDEX, 
                   unsigned char key) {
+  char name[20];
 
   // Set control variable according to key input
   switch(key) {
@@ -154,7 +155,8 @@ void ffd_key_func(PARA_DATA *para, REAL **var, int **BINDEX,
     case 'S':
       if(para->outp->cal_mean == 1)
         average_time(para, var);
-      write_tecplot_data(para, var, "result"); 
+      output_name(para, "result", name);
+      write_tecplot_data(para, var, name);
       break;
     // Reduce the drawed length of veloity
     case 'k':